@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <errno.h>
@@ -7,9 +8,21 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <math.h>
+#include <limits.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <stdlib.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JS_SIMD_X86 1
+#endif
+
 #include <liblz.h>
 #include <liblz/lzapi.h>
 
@@ -38,7 +51,13 @@ typedef enum lz_j_state     lz_j_state;
 typedef enum lz_j_arr_state lz_j_arr_state;
 typedef enum lz_j_obj_state lz_j_obj_state;
 
-static __thread void * __js_heap = NULL;
+struct js_arena;
+struct js_pool;
+struct js_array;
+struct js_object;
+
+static __thread struct js_pool  * __js_pool  = NULL;
+static __thread struct js_arena * __js_arena = NULL;
 
 struct __jbuf {
     char  * buf;
@@ -47,25 +66,156 @@ struct __jbuf {
     ssize_t written;
     int     dynamic;
     bool    escape;
+    bool    count_only; /* only count what would be written */
+
+    /* when set, a full buffer is handed to the sink and reused */
+    lz_json_writecb sink;
+    void          * sink_arg;
+
+    /* when set, long strings are referenced instead of copied */
+    lz_json_iov * iov;
 };
 
 
+/* an iovec serialization: everything but the referenced strings is staged
+ * in one buffer. While building, staged entries have a NULL iov_base, since
+ * the buffer may still move; they are consecutive runs of it, in order.
+ */
+struct lz_json_iov_s {
+    char         * staging;
+    struct iovec * vec;
+    size_t         n_vec;
+    size_t         n_alloc;
+    size_t         run; /* where the current staged run begins */
+    size_t         len;
+};
+
 struct lz_json_s {
     lz_json_vtype type;
     union {
-        lz_kvmap   * object;
-        lz_tailq   * array;
-        char       * string;
-        unsigned int number;
-        bool         boolean;
+        struct js_object * object;
+        struct js_array  * array;
+        char             * string;
+        int64_t            integer; /* numbers, JS_F_NUM_* says which */
+        uint64_t           uinteger;
+        double             real;
+        bool               boolean;
+        lz_json          * next_free; /* links freed nodes on a pool's remote list */
     };
 
     size_t slen;
-    void   (* freefn)(void *);
+    union {
+        struct js_arena * arena; /* JS_F_ARENA: the arena it was carved from */
+        struct js_pool  * pool;  /* otherwise the pool it was allocated from */
+    };
+    unsigned int flags;
+};
+
+#define JS_F_ARENA       0x01
+#define JS_F_ARENA_OWNER 0x02 /* freeing this node frees the whole arena */
+#define JS_F_TRACKED     0x04 /* recorded by its arena, see js_arena_track_() */
+#define JS_F_NUM_UINT    0x08 /* the number is in `uinteger` */
+#define JS_F_NUM_DOUBLE  0x10 /* the number is in `real`, otherwise `integer` */
+#define JS_F_LAZY        0x20 /* a container which has not been parsed yet */
+#define JS_F_LAZY_VIEW   0x40 /* its text is the caller's input, not a copy */
+
+static int       js_lazy_expand_(lz_json * js);
+static lz_json * js_parse_lazy_(const char * data, size_t len, int flags, size_t * consumed);
+
+/* a LZ_JSON_PARSE_LAZY container keeps the span of its text in `string` and
+ * `slen` until something first looks inside it, see js_lazy_expand_().
+ */
+static inline int
+js_lazy_(lz_json * js)
+{
+    if (lz_likely(!(js->flags & JS_F_LAZY)))
+    {
+        return 0;
+    }
+
+    return js_lazy_expand_(js);
+}
+
+/* arrays keep their values in one contiguous vector */
+struct js_array {
+    size_t     len;
+    size_t     cap;
+    lz_tailq * view; /* built on demand by lz_json_get_array() */
+    lz_json  * items[];
+};
+
+#define JS_ARRAY_MIN 4
+
+/* objects keep their entries in insertion order. Small ones are searched
+ * linearly; once an object has more than JS_OBJECT_LINEAR entries, an
+ * open-addressing index of the entries (by hash) is kept alongside.
+ */
+struct js_entry {
+    char     * key;
+    uint32_t   klen   : 31;
+    uint32_t   shared : 1; /* the key belongs to an intern table, see js_keys_intern_() */
+    uint32_t   hash;       /* only set while the object has an index, or the key is shared */
+    lz_json  * val;
+};
+
+#define JS_KLEN_MAX (1U << 31)
+
+struct js_object {
+    uint32_t          len;
+    uint32_t          cap;
+    uint32_t          mask;  /* number of index slots - 1 */
+    uint32_t        * index; /* entry number + 1 for each used slot */
+    lz_kvmap        * view;  /* built on demand by lz_json_get_object() */
+    struct js_shape * shape; /* if set, the object only holds values */
+    struct js_entry   entries[];
+};
+
+#define JS_OBJECT_MIN    4
+#define JS_OBJECT_LINEAR 8
+
+/* the records of an array often all have the same keys, in the same order.
+ * The builder then has them share a shape, which keeps the keys, their index
+ * and their text once, while each object keeps nothing but its values, in
+ * place of its entries. A shaped object may have fewer values than its shape
+ * has keys, it then has the first `len` of them; a change which does not fit
+ * is made after turning the object back into a plain one.
+ */
+struct js_shape {
+    struct js_arena * arena;    /* the arena it was carved from, NULL if none */
+    uint32_t          refs;     /* the objects using it, if not in an arena, atomic */
+    uint32_t          len;
+    uint32_t          mask;
+    uint32_t        * index;    /* as for objects, once there are enough keys */
+    char            * text;     /* `{"k0":` `,"k1":` ..., NULL if a key needs escaping */
+    uint32_t        * text_off; /* where the text of each key starts, then its end */
+    struct js_entry   keys[];   /* `val` is unused */
 };
 
+#define JS_SHAPE_MAX      256  /* objects with more keys are never shaped */
+#define JS_SHAPE_KLEN_MAX 1024 /* nor ones with longer keys */
+
+#define JS_OBJECT_KEYS(obj) ((obj)->shape ? (obj)->shape->keys : (obj)->entries)
+#define JS_OBJECT_VALS(obj) ((lz_json **)(void *)(obj)->entries)
+
+static inline lz_json *
+js_object_val_(struct js_object * obj, uint32_t i)
+{
+    return obj->shape ? JS_OBJECT_VALS(obj)[i] : obj->entries[i].val;
+}
+
+static inline void
+js_shape_drop_(struct js_shape * shape)
+{
+    /* records sharing a shape may be freed from different threads */
+    if (shape->arena == NULL && __atomic_sub_fetch(&shape->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        free(shape);
+    }
+}
+
 static lz_json * js_parse_value_(const char *, size_t, size_t *);
 static int       js_compare_(lz_json *, lz_json *, lz_json_key_filtercb);
+static size_t    js_scan_string_scalar_(const char *, size_t);
 
 static int js_json_to_buffer_(lz_json * json, struct __jbuf * jbuf);
 static int js_addbuf_(struct __jbuf * jbuf, const char * buf, size_t len);
@@ -83,9 +233,6 @@ static int js_addbuf_(struct __jbuf * jbuf, const char * buf, size_t len);
     lz_alias(js_get_ ## arg_name ## _, lz_json_get_ ## arg_name)
 
 
-JS_STATIC_GET_FNDEF(lz_kvmap *, NULL, lz_json_vtype_object, object);
-JS_STATIC_GET_FNDEF(lz_tailq *, NULL, lz_json_vtype_array, array);
-JS_STATIC_GET_FNDEF(unsigned int, 0, lz_json_vtype_number, number);
 JS_STATIC_GET_FNDEF(const char *, NULL, lz_json_vtype_string, string);
 JS_STATIC_GET_FNDEF(bool, false, lz_json_vtype_bool, boolean);
 
@@ -119,7 +266,7 @@ js_get_type_(lz_json * js)
 static ssize_t
 js_get_size_(lz_json * js)
 {
-    if (lz_unlikely(js == NULL))
+    if (lz_unlikely(js == NULL) || js_lazy_(js) == -1)
     {
         return -1;
     }
@@ -128,9 +275,9 @@ js_get_size_(lz_json * js)
         case lz_json_vtype_string:
             return (ssize_t)js->slen;
         case lz_json_vtype_array:
-            return lz_tailq_size(js->array);
+            return (ssize_t)js->array->len;
         case lz_json_vtype_object:
-            return lz_kvmap_get_size(js->object);
+            return (ssize_t)js->object->len;
         default:
             return 0;
     }
@@ -138,185 +285,220 @@ js_get_size_(lz_json * js)
     return 0;
 }
 
-static lz_json *
-js_new_(lz_json_vtype type)
+/* arenas: while one is active on a thread (see js_arena_enter_()), nodes,
+ * strings and container bookkeeping are bump-allocated from large blocks
+ * instead of coming from the node heap and malloc. Nothing in an arena is
+ * ever freed on its own; it all goes at once when the arena is freed, which
+ * is normally done by freeing the root node that owns it.
+ *
+ * Some containers hold things the arena cannot release by itself: views of
+ * objects and arrays, and values which came from somewhere else (the heap
+ * or another arena) and are freed along with their parent. Those containers
+ * are recorded, and released when the arena goes away.
+ */
+#define JS_ARENA_BLOCK_MIN (16 * 1024)
+#define JS_ARENA_BLOCK_MAX (1024 * 1024)
+
+struct js_arena_block {
+    struct js_arena_block * next;
+    size_t                  len;
+    size_t                  idx;
+    char                    data[];
+};
+
+struct js_arena_rec {
+    struct js_arena_rec * next;
+    lz_json             * js;
+};
+
+struct js_arena {
+    struct js_arena_block * block;
+    struct js_arena_rec   * containers;
+    size_t                  block_len;
+    void                  * map;     /* a zero-copy document's file mapping */
+    size_t                  map_len;
+};
+
+static struct js_arena *
+js_arena_new_(void)
 {
-    lz_json * lz_j;
+    struct js_arena * a;
 
-    /* if lz_json_init() was never called, this leads to bad things! */
-    if (!(lz_j = lz_heap_alloc(__js_heap)))
+    if (!(a = calloc(1, sizeof(*a))))
     {
         return NULL;
     }
 
-    lz_j->type   = type;
-    lz_j->freefn = NULL;
+    a->block_len = JS_ARENA_BLOCK_MIN;
 
-    return lz_j;
+    return a;
 }
 
-static void
-js_free_(lz_json * js)
+static void *
+js_arena_grow_(struct js_arena * a, size_t len)
 {
-    if (js == NULL)
+    struct js_arena_block * blk;
+
+    if (len > a->block_len / 4)
     {
-        return;
-    }
+        /* large allocations get a block of their own behind the current
+         * one, so the current block keeps being filled.
+         */
+        if (!(blk = malloc(sizeof(*blk) + len)))
+        {
+            return NULL;
+        }
 
-    switch (js->type) {
-        case lz_json_vtype_string:
-            lz_safe_free(js->string, free);
-            break;
-        case lz_json_vtype_object:
-            lz_safe_free(js->object, lz_kvmap_free);
-            break;
-        case lz_json_vtype_array:
-            lz_safe_free(js->array, lz_tailq_free);
-            break;
-        default:
-            break;
-    }
+        blk->len = len;
+        blk->idx = len;
 
-    lz_heap_free(__js_heap, js);
-}
+        if (a->block != NULL)
+        {
+            blk->next      = a->block->next;
+            a->block->next = blk;
+        } else {
+            blk->next = NULL;
+            a->block  = blk;
+        }
 
-static lz_json *
-js_object_new_(void)
-{
-    lz_json * js;
+        return blk->data;
+    }
 
-    if (!(js = js_new_(lz_json_vtype_object)))
+    if (!(blk = malloc(sizeof(*blk) + a->block_len)))
     {
         return NULL;
     }
 
-    if (!(js->object = lz_kvmap_new(10)))
-    {
-        lz_safe_free(js, js_free_);
+    blk->len  = a->block_len;
+    blk->idx  = len;
+    blk->next = a->block;
+    a->block  = blk;
 
-        return NULL;
+    if (a->block_len < JS_ARENA_BLOCK_MAX)
+    {
+        a->block_len *= 2;
     }
 
-    js->freefn = (void (*))lz_kvmap_free;
-
-    return js;
+    return blk->data;
 }
 
-static lz_json *
-js_array_new_(void)
+static inline void *
+js_arena_alloc_(struct js_arena * a, size_t len)
 {
-    lz_json * js;
+    struct js_arena_block * blk;
+    void                  * ptr;
 
-    if (!(js = js_new_(lz_json_vtype_array)))
-    {
-        return NULL;
-    }
+    len = (len + 7) & ~(size_t)7;
+    blk = a->block;
 
-    if (!(js->array = lz_tailq_new()))
+    if (lz_likely(blk != NULL && blk->len - blk->idx >= len))
     {
-        lz_safe_free(js, js_free_);
+        ptr       = &blk->data[blk->idx];
+        blk->idx += len;
 
-        return NULL;
+        return ptr;
     }
 
-    js->freefn = (void (*))lz_tailq_free;
-
-    return js;
+    return js_arena_grow_(a, len);
 }
 
-static lz_json *
-js_string_new_len_(const char * str, size_t slen)
-{
-    lz_json * js;
+static void js_array_release_(lz_json *);
+static void js_object_release_(lz_json *);
 
-    if (str == NULL || slen <= 0)
-    {
-        return NULL;
-    }
+/* releases whatever the containers recorded by the arena hold outside of it */
+static void
+js_arena_release_(struct js_arena * a)
+{
+    struct js_arena_rec * rec;
 
-    if (!(js = js_new_(lz_json_vtype_string)))
+    for (rec = a->containers; rec != NULL; rec = rec->next)
     {
-        return NULL;
+        if (rec->js->type == lz_json_vtype_object)
+        {
+            js_object_release_(rec->js);
+        } else {
+            js_array_release_(rec->js);
+        }
     }
 
-    if (!(js->string = malloc(slen + 1)))
-    {
-        js_free_(js);
+    a->containers = NULL;
+}
 
-        return NULL;
-    }
+/* frees everything allocated from the arena, but keeps its newest block
+ * around to be reused.
+ */
+static void
+js_arena_reset_(struct js_arena * a)
+{
+    struct js_arena_block * blk;
+    struct js_arena_block * next;
 
-    js->string[slen] = '\0';
+    js_arena_release_(a);
 
-    if (memcpy(js->string, str, slen) != js->string)
+    if (a->block == NULL)
     {
-        js_free_(js);
-
-        return NULL;
+        return;
     }
 
-    js->slen   = slen;
-    js->freefn = free;
-
-    return js;
-}
+    for (blk = a->block->next; blk != NULL; blk = next)
+    {
+        next = blk->next;
+        free(blk);
+    }
 
-static lz_json *
-js_string_new_(const char * str)
-{
-    return js_string_new_len_(str, strlen(str));
+    a->block->next = NULL;
+    a->block->idx  = 0;
 }
 
-static lz_json *
-js_number_new_(unsigned int num)
+static void
+js_arena_free_(struct js_arena * a)
 {
-    lz_json * js;
+    struct js_arena_block * blk;
+    struct js_arena_block * next;
 
-    if (!(js = js_new_(lz_json_vtype_number)))
+    if (a == NULL)
     {
-        return NULL;
+        return;
     }
 
-    js->number = num;
-
-    return js;
-}
-
-static lz_json *
-js_boolean_new_(bool boolean)
-{
-    lz_json * js;
+    js_arena_release_(a);
 
-    if (!(js = js_new_(lz_json_vtype_bool)))
+    for (blk = a->block; blk != NULL; blk = next)
     {
-        return NULL;
+        next = blk->next;
+        free(blk);
     }
 
-    js->boolean = boolean;
+    if (a->map != NULL)
+    {
+        munmap(a->map, a->map_len);
+    }
 
-    return js;
+    free(a);
 }
 
-static lz_json *
-js_null_new_(void)
+/* makes `a` the arena new nodes on this thread come from, returns the one it
+ * replaced so the caller can restore it.
+ */
+static inline struct js_arena *
+js_arena_enter_(struct js_arena * a)
 {
-    return js_new_(lz_json_vtype_null);
+    struct js_arena * prev = __js_arena;
+
+    __js_arena = a;
+
+    return prev;
 }
 
 static int
-js_object_add_(lz_json * dst, const char * key, lz_json * val)
+js_arena_begin_(void)
 {
-    if (lz_unlikely(!dst || !key || !val))
-    {
-        return -1;
-    }
-
-    if (dst->type != lz_json_vtype_object)
+    if (__js_arena != NULL)
     {
         return -1;
     }
 
-    if (!lz_kvmap_add(dst->object, key, val, (void (*))lz_json_free))
+    if (!(__js_arena = js_arena_new_()))
     {
         return -1;
     }
@@ -324,1540 +506,10113 @@ js_object_add_(lz_json * dst, const char * key, lz_json * val)
     return 0;
 }
 
-static int
-js_object_add_klen_(lz_json * dst, const char * key, size_t klen, lz_json * val)
+static void
+js_arena_end_(lz_json * root)
 {
-    if (lz_unlikely(dst == NULL))
+    struct js_arena * a = js_arena_enter_(NULL);
+
+    if (a == NULL)
     {
-        return -1;
+        return;
     }
 
-    if (dst->type != lz_json_vtype_object)
+    if (root != NULL && (root->flags & JS_F_ARENA) && root->arena == a)
     {
-        return -1;
+        root->flags |= JS_F_ARENA_OWNER;
+    } else {
+        js_arena_free_(a);
     }
+}
 
-    if (!lz_kvmap_add_wklen(dst->object,
-                            key, klen, val,
-                            (void (*))lz_json_free))
+/* allocates the storage for a node's data (string bodies and the like) */
+static inline void *
+js_node_alloc_(lz_json * js, size_t len)
+{
+    if (js->flags & JS_F_ARENA)
     {
-        return -1;
+        return js_arena_alloc_(js->arena, len);
     }
 
-    return 0;
+    return malloc(len);
 }
 
-static int
-js_array_add_(lz_json * dst, lz_json * src)
+/* node pools: each thread allocates nodes from a pool of its own, created on
+ * first use, so allocating never takes a lock. Any thread may free a node;
+ * if it is not the one which allocated it, the node is pushed onto the
+ * owning pool's remote list, which the owner drains the next time it
+ * allocates.
+ *
+ * Nodes from a pool can outlive its thread, so when a thread exits its pool
+ * is parked instead of destroyed, and the next thread which needs a pool
+ * adopts it.
+ */
+struct js_pool {
+    lz_heap        * heap;
+    lz_json        * remote;
+    struct js_pool * next;
+};
+
+static pthread_key_t    js_pool_key;
+static pthread_once_t   js_pool_once   = PTHREAD_ONCE_INIT;
+static pthread_mutex_t  js_pool_lock   = PTHREAD_MUTEX_INITIALIZER;
+static struct js_pool * js_pool_parked = NULL;
+
+static void
+js_pool_drain_(struct js_pool * pool)
 {
-    if (lz_unlikely(dst == NULL))
-    {
-        return -1;
-    }
+    lz_json * js;
+    lz_json * next;
+
+    js = __atomic_exchange_n(&pool->remote, NULL, __ATOMIC_ACQUIRE);
 
-    if (dst->type != lz_json_vtype_array)
+    for (; js != NULL; js = next)
     {
-        return -1;
+        next = js->next_free;
+        lz_heap_free(pool->heap, js);
     }
+}
+
+/* thread exit */
+static void
+js_pool_park_(void * arg)
+{
+    struct js_pool * pool = arg;
+
+    js_pool_drain_(pool);
 
-    if (!lz_tailq_append(dst->array, src, 1, (void (*))lz_json_free))
+    pthread_mutex_lock(&js_pool_lock);
     {
-        return -1;
+        pool->next     = js_pool_parked;
+        js_pool_parked = pool;
     }
+    pthread_mutex_unlock(&js_pool_lock);
 
-    return 0;
+    __js_pool = NULL;
 }
 
-static lz_json *
-js_parse_string_(const char * data, size_t len, size_t * n_read)
+static void
+js_pool_key_init_(void)
 {
-    unsigned char ch;
-    size_t        i;
-    size_t        buflen;
-    char          buf[len + 128];
-    int           buf_idx;
-    int           escaped;
-    bool          error;
-    lz_json     * js;
+    pthread_key_create(&js_pool_key, js_pool_park_);
+}
 
-    if (!data || !len || *data != '"')
+static struct js_pool *
+js_pool_get_(void)
+{
+    struct js_pool * pool;
+
+    if (lz_likely(__js_pool != NULL))
     {
-        /* *n_read = 0; */
-        return NULL;
+        return __js_pool;
     }
 
-    escaped = 0;
-    buf_idx = 0;
-    error   = false;
-    js      = NULL;
-    buflen  = len + 128;
+    pthread_once(&js_pool_once, js_pool_key_init_);
 
-    len--;
-    data++;
-
-    for (i = 0; i < len; i++)
+    pthread_mutex_lock(&js_pool_lock);
     {
-        if (buf_idx >= buflen)
+        if ((pool = js_pool_parked) != NULL)
         {
-            error = true;
-            errno = ENOBUFS;
-            goto end;
+            js_pool_parked = pool->next;
         }
+    }
+    pthread_mutex_unlock(&js_pool_lock);
 
-        ch = data[i];
-
-        if (!lz_isascii(ch))
+    if (pool == NULL)
+    {
+        if (!(pool = calloc(1, sizeof(*pool))))
         {
-            error = true;
-            goto end;
+            return NULL;
         }
 
-        if (escaped)
+        if (!(pool->heap = lz_heap_new(sizeof(lz_json), 1024)))
         {
-            switch (ch) {
-                case '"':
-                case '/':
-                case 'b':
-                case 'f':
-                case 'n':
-                case 'r':
-                case 't':
-                case '\\':
-                    escaped        = 0;
-                    buf[buf_idx++] = ch;
-                    break;
-                default:
-                    error          = true;
-                    goto end;
-            }
-            continue;
+            free(pool);
+            return NULL;
         }
+    }
 
-        if (ch == '\\')
-        {
-            escaped = 1;
-            continue;
-        }
+    pool->next = NULL;
 
-        if (ch == '"')
-        {
-            js = js_string_new_len_(buf, buf_idx);
-            i += 1;
-            break;
-        }
+    pthread_setspecific(js_pool_key, pool);
 
-        buf[buf_idx++] = ch;
-    }
+    return __js_pool = pool;
+} /* js_pool_get_ */
 
-end:
-    *n_read += i;
+static inline lz_json *
+js_pool_alloc_(void)
+{
+    struct js_pool * pool;
+    lz_json        * js;
 
-    if (error == true)
+    if (lz_unlikely((pool = js_pool_get_()) == NULL))
     {
-        lz_safe_free(js, js_free_);
+        return NULL;
+    }
+
+    if (__atomic_load_n(&pool->remote, __ATOMIC_RELAXED) != NULL)
+    {
+        js_pool_drain_(pool);
+    }
 
+    if (!(js = lz_heap_alloc(pool->heap)))
+    {
         return NULL;
     }
 
-    return js;
-} /* js_parse_string_ */
+    js->pool = pool;
 
-static lz_alias(js_parse_string_, js_parse_key_);
+    return js;
+}
 
-static lz_json *
-js_parse_number_(const char * data, size_t len, size_t * n_read)
+static inline void
+js_pool_free_(lz_json * js)
 {
-    unsigned char ch;
-    char          buf[len];
-    int           buf_idx;
-    size_t        i;
-    lz_json     * js;
+    struct js_pool * pool = js->pool;
 
-    if (!data || !len)
+    if (lz_likely(pool == __js_pool))
     {
-        return NULL;
+        lz_heap_free(pool->heap, js);
+        return;
     }
 
-    js      = NULL;
-    buf_idx = 0;
+    js->next_free = __atomic_load_n(&pool->remote, __ATOMIC_RELAXED);
 
-    if (memset(buf, 0, sizeof(buf)) != buf)
+    while (!__atomic_compare_exchange_n(&pool->remote, &js->next_free, js,
+                                        true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
     {
-        return NULL;
+        ;
     }
+}
 
-    for (i = 0; i < len; i++)
-    {
-        ch = data[i];
+static lz_json *
+js_new_(lz_json_vtype type)
+{
+    lz_json * lz_j;
 
-        if (!isdigit(ch) || (len == 1 && isdigit(ch)))
+    if (__js_arena != NULL)
+    {
+        if (!(lz_j = js_arena_alloc_(__js_arena, sizeof(lz_json))))
         {
-            js = js_number_new_((unsigned int)lz_atoi(buf, buf_idx));
-            break;
+            return NULL;
+        }
+
+        lz_j->arena = __js_arena;
+        lz_j->flags = JS_F_ARENA;
+    } else {
+        if (!(lz_j = js_pool_alloc_()))
+        {
+            return NULL;
         }
 
-        buf[buf_idx++] = ch;
+        lz_j->flags = 0;
     }
 
-    *n_read += (len == 1) ? 1 : i - 1;
+    lz_j->type = type;
 
-    return js;
+    return lz_j;
 }
 
-#define J_TRUE_CMP   0x657572
-#define J_FALSE_CMP  0x65736c61
-#define J_TRUE_MASK  0xFFFFFF
-#define J_FALSE_MASK 0xFFFFFFFF
-
-static lz_json *
-js_parse_boolean_(const char * data, size_t len, size_t * n_read)
+static void
+js_free_(lz_json * js)
 {
-    lz_json * js;
+    if (js == NULL)
+    {
+        return;
+    }
 
-    if (lz_unlikely(len < 4))
+    if (js->flags & JS_F_ARENA_OWNER)
     {
-        /* need at LEAST 'true' */
-        *n_read = 0;
-        return NULL;
+        js_arena_free_(js->arena);
+        return;
     }
 
-    js = NULL;
+    if (js->flags & JS_F_LAZY)
+    {
+        /* only ever in an arena, and holds nothing but its span */
+        return;
+    }
 
-    /* here we cast our data string to an integer, mask it by the
-     * number of words we want to see, then match the integer version
-     * of the string.
-     */
-    switch (*data) {
-        case 't':
-            if ((*((uint32_t *)(data + 1)) & J_TRUE_MASK) == J_TRUE_CMP)
+    switch (js->type) {
+        case lz_json_vtype_string:
+            if (!(js->flags & JS_F_ARENA))
             {
-                *n_read += 3;
-
-                if (!(js = js_boolean_new_(true)))
-                {
-                    return NULL;
-                }
+                lz_safe_free(js->string, free);
             }
-
             break;
-        case 'f':
-            if (len < 5)
-            {
-                return NULL;
-            }
+        case lz_json_vtype_object:
+            js_object_release_(js);
 
-            if ((*((uint32_t *)(data + 1)) & J_FALSE_MASK) == J_FALSE_CMP)
+            if (!(js->flags & JS_F_ARENA) && js->object != NULL)
             {
-                *n_read += 4;
-
-                if (!(js = js_boolean_new_(false)))
+                if (js->object->shape != NULL)
                 {
-                    return NULL;
+                    js_shape_drop_(js->object->shape);
                 }
+
+                lz_safe_free(js->object->index, free);
+                lz_safe_free(js->object, free);
             }
+            break;
+        case lz_json_vtype_array:
+            js_array_release_(js);
 
+            if (!(js->flags & JS_F_ARENA))
+            {
+                lz_safe_free(js->array, free);
+            }
             break;
         default:
-            return NULL;
-    } /* switch */
-
-    return js;
-}     /* js_parse_boolean_ */
+            break;
+    }
 
-static lz_json *
-js_parse_null_(const char * data, size_t len, size_t * n_read)
-{
-    if (data == NULL || len < 4)
+    if (!(js->flags & JS_F_ARENA))
     {
-        return NULL;
+        js_pool_free_(js);
     }
+}
 
-    if (!lz_str30_cmp(data, 'n', 'u', 'l', 'l'))
+/* whether freeing `parent` also frees `child`: values carved from the same
+ * arena as their parent are left to the arena.
+ */
+static inline bool
+js_owns_(lz_json * parent, lz_json * child)
+{
+    if (!(parent->flags & JS_F_ARENA) || !(child->flags & JS_F_ARENA))
     {
-        return NULL;
+        return true;
     }
 
-    *n_read += 4;
-
-    return js_null_new_();
+    return child->arena != parent->arena;
 }
 
-static lz_json *
-js_parse_array_(const char * data, size_t len, size_t * n_read)
+/* frees the values an array owns, and its view */
+static void
+js_array_release_(lz_json * js)
 {
-    unsigned char  ch;
-    unsigned char  end_ch;
-    size_t         i;
-    bool           error;
-    size_t         b_read;
-    lz_j_arr_state state;
-    lz_json      * js;
-
+    struct js_array * arr;
+    size_t            i;
 
-    if (!data || !len || *data != '[')
+    if ((arr = js->array) == NULL)
     {
-        /* *n_read = 0; */
-        return NULL;
+        return;
     }
 
-    data++;
-    len--;
-
-    js     = js_array_new_();
-    state  = lz_j_arr_s_val;
-    error  = false;
-    b_read = 0;
-    end_ch = 0;
-
-    for (i = 0; i < len; i++)
+    for (i = 0; i < arr->len; i++)
     {
-        lz_json * val;
-
-        ch = data[i];
-
-        if (isspace(ch))
+        if (js_owns_(js, arr->items[i]))
         {
-            continue;
+            js_free_(arr->items[i]);
         }
+    }
 
-        switch (state) {
-            case lz_j_arr_s_val:
-                if (ch == ']')
-                {
-                    end_ch = ch;
-                    state  = lz_j_arr_s_end;
-                    break;
-                }
+    arr->len = 0;
 
-                if (!(val = js_parse_value_(&data[i], (len - i), &b_read)))
-                {
-                    error = true;
-                    goto end;
-                }
+    lz_safe_free(arr->view, lz_tailq_free);
+}
 
-                i     += b_read;
-                b_read = 0;
+/* frees the keys and values an object owns, and its view */
+static void
+js_object_release_(lz_json * js)
+{
+    struct js_object * obj;
+    lz_json          * val;
+    uint32_t           i;
 
-                js_array_add_(js, val);
+    if ((obj = js->object) == NULL)
+    {
+        return;
+    }
 
-                state  = lz_j_arr_s_comma;
+    for (i = 0; i < obj->len; i++)
+    {
+        if (!obj->shape && !(js->flags & JS_F_ARENA) && !obj->entries[i].shared)
+        {
+            free(obj->entries[i].key);
+        }
 
-                if ((i + 1) == len)
-                {
-                    end_ch = data[i];
-                }
+        val = js_object_val_(obj, i);
 
-                break;
-            case lz_j_arr_s_comma:
-                switch (ch) {
-                    case ',':
-                        state  = lz_j_arr_s_val;
-                        break;
-                    case ']':
-                        end_ch = ch;
-                        state  = lz_j_arr_s_end;
-                        break;
-                    default:
-                        error  = true;
-                        goto end;
-                }
-                break;
-            case lz_j_arr_s_end:
-                goto end;
-        } /* switch */
+        if (js_owns_(js, val))
+        {
+            js_free_(val);
+        }
     }
-end:
-    *n_read += i;
 
-    if ((end_ch != ']' || error == true))
+    if (obj->index != NULL)
     {
-        lz_safe_free(js, js_free_);
-        return NULL;
+        memset(obj->index, 0, (obj->mask + 1) * sizeof(uint32_t));
     }
 
-    return js;
-} /* js_parse_array_ */
+    obj->len = 0;
 
-static lz_json *
-js_parse_object_(const char * data, size_t len, size_t * n_read)
+    lz_safe_free(obj->view, lz_kvmap_free);
+}
+
+/* records a container made in an arena, see js_arena_release_() */
+static int
+js_arena_track_(lz_json * js)
 {
-    unsigned char  ch;
-    unsigned char  end_ch;
-    size_t         i;
-    lz_json      * js;
-    lz_json      * key;
-    lz_json      * val;
-    lz_j_obj_state state;
-    bool           error;
-    size_t         b_read;
+    struct js_arena_rec * rec;
 
-    if (*data != '{')
+    if (!(js->flags & JS_F_ARENA) || (js->flags & JS_F_TRACKED))
     {
-        /* *n_read = 0; */
-        return NULL;
+        return 0;
     }
 
-    if (!(js = js_object_new_()))
+    if (!(rec = js_arena_alloc_(js->arena, sizeof(*rec))))
     {
-        return NULL;
+        return -1;
     }
 
-    state  = lz_j_obj_s_key;
-    key    = NULL;
-    val    = NULL;
-    error  = false;
-    b_read = 0;
-    end_ch = 0;
+    rec->js               = js;
+    rec->next             = js->arena->containers;
+    js->arena->containers = rec;
+    js->flags            |= JS_F_TRACKED;
 
-    data++;
-    len--;
+    return 0;
+}
 
-    for (i = 0; i < len; i++)
+/* `cap` is the number of entries to make room for, if known */
+static int
+js_object_init_(lz_json * js, uint32_t cap)
+{
+    if (cap < JS_OBJECT_MIN)
     {
-        ch = data[i];
+        cap = JS_OBJECT_MIN;
+    }
 
-        if (isspace(ch))
-        {
-            continue;
-        }
+    if (!(js->object = js_node_alloc_(js, sizeof(struct js_object) +
+                                      cap * sizeof(struct js_entry))))
+    {
+        return -1;
+    }
 
-        switch (state) {
-            case lz_j_obj_s_key:
-                if (ch == '}')
-                {
-                    end_ch = ch;
-                    state  = lz_j_obj_s_end;
-                    break;
-                }
+    memset(js->object, 0, sizeof(struct js_object));
+    js->object->cap = cap;
 
-                if (!(key = js_parse_key_(&data[i], (len - i), &b_read)))
-                {
-                    error = true;
-                    i    += b_read;
-                    goto end;
-                }
+    return 0;
+}
 
-                i     += b_read;
-                b_read = 0;
-                state  = lz_j_obj_s_delim;
-                break;
-            case lz_j_obj_s_delim:
-                if (ch != ':')
-                {
-                    error = true;
-                    goto end;
-                }
+static lz_json *
+js_object_new_(void)
+{
+    lz_json * js;
 
-                state = lz_j_obj_s_val;
-                break;
+    if (!(js = js_new_(lz_json_vtype_object)))
+    {
+        return NULL;
+    }
 
-            case lz_j_obj_s_val:
-                if (!(val = js_parse_value_(&data[i], (len - i), &b_read)))
-                {
-                    error = true;
-                    i    += b_read;
-                    goto end;
-                }
+    if (js_object_init_(js, 0) == -1)
+    {
+        lz_safe_free(js, js_free_);
 
-                i     += b_read;
-                b_read = 0;
+        return NULL;
+    }
 
-                if (js_object_add_(js, key->string, val) == -1)
-                {
-                    error = true;
-                    goto end;
-                }
+    return js;
+}
 
-                lz_safe_free(key, js_free_);
+/* `cap` is the number of values to make room for, if known */
+static int
+js_array_init_(lz_json * js, size_t cap)
+{
+    if (cap < JS_ARRAY_MIN)
+    {
+        cap = JS_ARRAY_MIN;
+    }
 
-                key   = NULL;
-                state = lz_j_obj_s_comma;
+    if (!(js->array = js_node_alloc_(js, sizeof(struct js_array) +
+                                     cap * sizeof(lz_json *))))
+    {
+        return -1;
+    }
 
-                break;
+    js->array->len  = 0;
+    js->array->cap  = cap;
+    js->array->view = NULL;
 
-            case lz_j_obj_s_comma:
-                switch (ch) {
-                    case ',':
-                        state  = lz_j_obj_s_key;
-                        break;
-                    case '}':
-                        end_ch = ch;
-                        state  = lz_j_obj_s_end;
-                        break;
-                    default:
-                        error  = true;
-                        goto end;
-                }
-                break;
-            case lz_j_obj_s_end:
-                goto end;
-        } /* switch */
-    }
+    return 0;
+}
 
-end:
-    *n_read += i;
+static lz_json *
+js_array_new_(void)
+{
+    lz_json * js;
 
-    lz_safe_free(key, js_free_);
+    if (!(js = js_new_(lz_json_vtype_array)))
+    {
+        return NULL;
+    }
 
-    if ((end_ch != '}' || error == true))
+    if (js_array_init_(js, 0) == -1)
     {
         lz_safe_free(js, js_free_);
+
         return NULL;
     }
 
     return js;
-} /* js_parse_object_ */
+}
 
-static lz_json *
-js_parse_buf_(const char * data, size_t len, size_t * n_read)
+static size_t
+js_utf8_encode_(char * dst, unsigned int cp)
 {
-    unsigned char ch;
-    size_t        b_read;
-    size_t        i;
-    lz_json     * js;
-    lz_j_state    state;
+    if (cp < 0x80)
+    {
+        dst[0] = (char)cp;
+        return 1;
+    }
 
-    js     = NULL;
-    b_read = 0;
-    state  = lz_j_s_start;
+    if (cp < 0x800)
+    {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
 
-    for (i = 0; i < len; i++)
+    if (cp < 0x10000)
     {
-        ch = data[i];
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
 
-        if (isspace(ch))
-        {
-            continue;
-        }
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
 
-        switch (state) {
-            case lz_j_s_start:
-                switch (ch) {
-                    case '{':
-                        if (!(js = js_parse_object_(&data[i], (len - i), &b_read)))
-                        {
-                            *n_read += b_read;
-                            return NULL;
-                        }
+static int
+js_hex4_(const char * str, unsigned int * cp)
+{
+    unsigned int val;
+    int          i;
 
-                        i     += b_read;
-                        b_read = 0;
-                        break;
-                    case '[':
-                        if (!(js = js_parse_array_(&data[i], (len - i), &b_read)))
-                        {
-                            *n_read += b_read;
-                            return NULL;
-                        }
+    for (i = 0, val = 0; i < 4; i++)
+    {
+        unsigned char ch = str[i];
 
-                        i       += b_read;
-                        b_read   = 0;
-                        break;
-                    default:
-                        *n_read += i;
-                        return NULL;
-                } /* switch */
+        val <<= 4;
 
-                state = lz_j_s_end;
-                break;
-            case lz_j_s_end:
-                break;
-        }         /* switch */
+        if (ch >= '0' && ch <= '9')
+        {
+            val |= ch - '0';
+        } else if (ch >= 'a' && ch <= 'f')
+        {
+            val |= ch - 'a' + 10;
+        } else if (ch >= 'A' && ch <= 'F')
+        {
+            val |= ch - 'A' + 10;
+        } else {
+            return -1;
+        }
     }
 
-    *n_read += i;
+    *cp = val;
 
-    return js;
-} /* js_parse_buf_ */
+    return 0;
+}
 
-static lz_json *
-js_parse_file_(const char * filename, size_t * bytes_read)
+/* decodes the escapes of a JSON string body into `dst`. The output is never
+ * longer than the input, so `dst` may be the same buffer as `src`. Returns
+ * the decoded length, or -1 on an invalid escape sequence.
+ */
+static ssize_t
+js_unescape_(char * dst, const char * src, size_t len)
 {
-    lz_json * json   = NULL;
-    FILE    * fp     = NULL;
-    char    * buf    = NULL;
-    size_t    n_read = 0;
-    long      file_size;
+    const char * end;
+    const char * esc;
+    size_t       n;
+    unsigned int cp;
+    unsigned int lo;
 
-    if (filename == NULL)
-    {
-        return NULL;
-    }
+    end = src + len;
+    n   = 0;
 
-    do {
-        if (!(fp = fopen(filename, "re")))
+    while (src < end)
+    {
+        if (!(esc = memchr(src, '\\', (size_t)(end - src))))
         {
-            break;
+            esc = end;
         }
 
-        if (fseek(fp, 0L, SEEK_END) == -1)
+        /* copy the run of plain bytes up to the next escape in one go */
+        if (esc > src)
         {
-            break;
+            memmove(&dst[n], src, (size_t)(esc - src));
+            n += (size_t)(esc - src);
         }
 
-        if ((file_size = ftell(fp)) == -1)
+        if (esc == end)
         {
             break;
         }
 
-        if (fseek(fp, 0L, SEEK_SET) == -1)
+        if (esc + 1 == end)
         {
-            break;
+            return -1;
         }
 
-        /* allocate 1 more than the size, just incase there is not an EOL
-         * terminator in the file.
-         */
-        if (!(buf = calloc(file_size + 1, 1)))
-        {
-            break;
-        }
+        src = esc + 2;
 
-        if (fread(buf, 1, file_size, fp) != file_size)
-        {
-            break;
-        }
+        switch (esc[1]) {
+            case '"':
+            case '/':
+            case '\\':
+                dst[n++] = esc[1];
+                break;
+            case 'b':
+                dst[n++] = '\b';
+                break;
+            case 'f':
+                dst[n++] = '\f';
+                break;
+            case 'n':
+                dst[n++] = '\n';
+                break;
+            case 'r':
+                dst[n++] = '\r';
+                break;
+            case 't':
+                dst[n++] = '\t';
+                break;
+            case 'u':
+                if (end - src < 4 || js_hex4_(src, &cp) == -1)
+                {
+                    return -1;
+                }
 
-        if (buf[file_size] == 0)
-        {
-            /* just make sure we have SOME type of EOL terminator by placing a
-             * \n in it. */
-            buf[file_size] = '\n';
-            file_size     += 1;
-        }
+                src += 4;
 
-        if (!(json = js_parse_buf_(buf, file_size, &n_read)))
-        {
-            break;
-        }
-    } while (0);
+                if (cp >= 0xD800 && cp <= 0xDBFF)
+                {
+                    /* a high surrogate must be followed by a low one */
+                    if (end - src < 6 || src[0] != '\\' || src[1] != 'u' ||
+                        js_hex4_(&src[2], &lo) == -1 ||
+                        lo < 0xDC00 || lo > 0xDFFF)
+                    {
+                        return -1;
+                    }
+
+                    src += 6;
+                    cp   = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF)
+                {
+                    return -1;
+                }
 
-    if (fp != NULL)
-    {
-        fclose(fp);
+                n += js_utf8_encode_(&dst[n], cp);
+                break;
+            default:
+                return -1;
+        } /* switch */
     }
 
-    *bytes_read = n_read;
-
-    lz_safe_free(buf, free);
-    return json;
-} /* lz_json_parse_file */
+    return (ssize_t)n;
+} /* js_unescape_ */
 
+/* creates a string from a raw JSON string body. The allocation is made once,
+ * at the raw length (which the decoded string never exceeds), and escaped
+ * bodies are decoded straight into it.
+ */
 static lz_json *
-js_get_array_index_(lz_json * array, int offset)
+js_string_new_raw_(const char * raw, size_t len, bool escaped)
 {
-    lz_tailq * list;
+    lz_json * js;
+    ssize_t   slen;
 
-    if (!(list = js_get_array_(array)))
+    if (!(js = js_new_(lz_json_vtype_string)))
     {
         return NULL;
     }
 
-    return (lz_json *)lz_tailq_get_at_index(list, offset);
-}
+    if (!(js->string = js_node_alloc_(js, len + 1)))
+    {
+        js_free_(js);
 
-enum path_state {
-    path_state_reading_key,
-    path_state_reading_array,
-    path_state_reading_array_end
-};
+        return NULL;
+    }
+
+    if (escaped == true)
+    {
+        if ((slen = js_unescape_(js->string, raw, len)) == -1)
+        {
+            js_free_(js);
+
+            return NULL;
+        }
+    } else {
+        memcpy(js->string, raw, len);
+        slen = (ssize_t)len;
+    }
+
+    js->string[slen] = '\0';
+    js->slen         = (size_t)slen;
 
+    return js;
+}
 
+/* a string which points at `len` bytes it does not own, used for zero-copy
+ * parsing into an arena, where strings are never freed.
+ */
 static lz_json *
-js_get_path_(lz_json * js, const char * path)
+js_string_new_view_(const char * str, size_t len)
 {
-    char            buf[strlen(path) + 1];
-    int             buf_idx;
-    lz_kvmap      * object;
-    lz_json       * prev;
-    unsigned char   ch;
-    size_t          i;
-    enum path_state state;
+    lz_json * js;
 
-    if (lz_unlikely(js == NULL || path == NULL))
+    if (!(js = js_new_(lz_json_vtype_string)))
     {
         return NULL;
     }
 
-    prev    = js;
-    object  = NULL;
-    buf_idx = 0;
-    buf[0]  = '\0';
-    state   = path_state_reading_key;
+    js->string = (char *)str;
+    js->slen   = len;
 
-    for (i = 0; i < strlen(path) + 1; i++)
+    return js;
+}
+
+static lz_json *
+js_string_new_len_(const char * str, size_t slen)
+{
+    if (str == NULL)
     {
-        ch = path[i];
+        return NULL;
+    }
 
-        switch (state) {
-            case path_state_reading_key:
-                switch (ch) {
-                    case '[':
-                        state = path_state_reading_array;
-                        break;
-                    case '\0':
-                    case '.':
-                        /* XXX: if there is a failed allocation, this might
-                         *      leak memory from `object`
-                         */
-                        if (!(object = js_get_object_(prev)))
-                        {
-                            return NULL;
-                        }
+    return js_string_new_raw_(str, slen, false);
+}
 
-                        if (!(prev = lz_kvmap_find(object, buf)))
-                        {
-                            return NULL;
-                        }
+static lz_json *
+js_string_new_(const char * str)
+{
+    return js_string_new_len_(str, strlen(str));
+}
 
-                        buf[0]         = '\0';
-                        buf_idx        = 0;
-                        break;
-                    default:
-                        buf[buf_idx++] = ch;
-                        buf[buf_idx]   = '\0';
-                        break;
-                } /* switch */
-                break;
-            case path_state_reading_array:
-                switch (ch) {
-                    case ']':
-                        prev = js_get_array_index_(prev,
-                                                   lz_atoi(buf, buf_idx));
+/* numbers are converted in both directions with one table of 128-bit
+ * approximations of the powers of ten: the mantissa of 10^e, normalized so
+ * the top bit is set, and rounded down.
+ *
+ * text to double first tries the exact fast path (a mantissa of at most 53
+ * bits scaled by an exactly representable power of ten), then the
+ * Eisel-Lemire algorithm, and only falls back to strtod() for the rare
+ * inputs where the approximation cannot decide how to round.
+ *
+ * double to text uses the Schubfach algorithm, which finds the shortest
+ * decimal that reads back as the same double.
+ */
+#define JS_POW10_MIN -342
+#define JS_POW10_MAX 326
+
+static const struct {
+    uint64_t hi;
+    uint64_t lo;
+} js_pow10_[JS_POW10_MAX - JS_POW10_MIN + 1] = {
+    { 0xEEF453D6923BD65AULL, 0x113FAA2906A13B3FULL }, /* -342 */
+    { 0x9558B4661B6565F8ULL, 0x4AC7CA59A424C507ULL }, /* -341 */
+    { 0xBAAEE17FA23EBF76ULL, 0x5D79BCF00D2DF649ULL }, /* -340 */
+    { 0xE95A99DF8ACE6F53ULL, 0xF4D82C2C107973DCULL }, /* -339 */
+    { 0x91D8A02BB6C10594ULL, 0x79071B9B8A4BE869ULL }, /* -338 */
+    { 0xB64EC836A47146F9ULL, 0x9748E2826CDEE284ULL }, /* -337 */
+    { 0xE3E27A444D8D98B7ULL, 0xFD1B1B2308169B25ULL }, /* -336 */
+    { 0x8E6D8C6AB0787F72ULL, 0xFE30F0F5E50E20F7ULL }, /* -335 */
+    { 0xB208EF855C969F4FULL, 0xBDBD2D335E51A935ULL }, /* -334 */
+    { 0xDE8B2B66B3BC4723ULL, 0xAD2C788035E61382ULL }, /* -333 */
+    { 0x8B16FB203055AC76ULL, 0x4C3BCB5021AFCC31ULL }, /* -332 */
+    { 0xADDCB9E83C6B1793ULL, 0xDF4ABE242A1BBF3DULL }, /* -331 */
+    { 0xD953E8624B85DD78ULL, 0xD71D6DAD34A2AF0DULL }, /* -330 */
+    { 0x87D4713D6F33AA6BULL, 0x8672648C40E5AD68ULL }, /* -329 */
+    { 0xA9C98D8CCB009506ULL, 0x680EFDAF511F18C2ULL }, /* -328 */
+    { 0xD43BF0EFFDC0BA48ULL, 0x0212BD1B2566DEF2ULL }, /* -327 */
+    { 0x84A57695FE98746DULL, 0x014BB630F7604B57ULL }, /* -326 */
+    { 0xA5CED43B7E3E9188ULL, 0x419EA3BD35385E2DULL }, /* -325 */
+    { 0xCF42894A5DCE35EAULL, 0x52064CAC828675B9ULL }, /* -324 */
+    { 0x818995CE7AA0E1B2ULL, 0x7343EFEBD1940993ULL }, /* -323 */
+    { 0xA1EBFB4219491A1FULL, 0x1014EBE6C5F90BF8ULL }, /* -322 */
+    { 0xCA66FA129F9B60A6ULL, 0xD41A26E077774EF6ULL }, /* -321 */
+    { 0xFD00B897478238D0ULL, 0x8920B098955522B4ULL }, /* -320 */
+    { 0x9E20735E8CB16382ULL, 0x55B46E5F5D5535B0ULL }, /* -319 */
+    { 0xC5A890362FDDBC62ULL, 0xEB2189F734AA831DULL }, /* -318 */
+    { 0xF712B443BBD52B7BULL, 0xA5E9EC7501D523E4ULL }, /* -317 */
+    { 0x9A6BB0AA55653B2DULL, 0x47B233C92125366EULL }, /* -316 */
+    { 0xC1069CD4EABE89F8ULL, 0x999EC0BB696E840AULL }, /* -315 */
+    { 0xF148440A256E2C76ULL, 0xC00670EA43CA250DULL }, /* -314 */
+    { 0x96CD2A865764DBCAULL, 0x380406926A5E5728ULL }, /* -313 */
+    { 0xBC807527ED3E12BCULL, 0xC605083704F5ECF2ULL }, /* -312 */
+    { 0xEBA09271E88D976BULL, 0xF7864A44C633682EULL }, /* -311 */
+    { 0x93445B8731587EA3ULL, 0x7AB3EE6AFBE0211DULL }, /* -310 */
+    { 0xB8157268FDAE9E4CULL, 0x5960EA05BAD82964ULL }, /* -309 */
+    { 0xE61ACF033D1A45DFULL, 0x6FB92487298E33BDULL }, /* -308 */
+    { 0x8FD0C16206306BABULL, 0xA5D3B6D479F8E056ULL }, /* -307 */
+    { 0xB3C4F1BA87BC8696ULL, 0x8F48A4899877186CULL }, /* -306 */
+    { 0xE0B62E2929ABA83CULL, 0x331ACDABFE94DE87ULL }, /* -305 */
+    { 0x8C71DCD9BA0B4925ULL, 0x9FF0C08B7F1D0B14ULL }, /* -304 */
+    { 0xAF8E5410288E1B6FULL, 0x07ECF0AE5EE44DD9ULL }, /* -303 */
+    { 0xDB71E91432B1A24AULL, 0xC9E82CD9F69D6150ULL }, /* -302 */
+    { 0x892731AC9FAF056EULL, 0xBE311C083A225CD2ULL }, /* -301 */
+    { 0xAB70FE17C79AC6CAULL, 0x6DBD630A48AAF406ULL }, /* -300 */
+    { 0xD64D3D9DB981787DULL, 0x092CBBCCDAD5B108ULL }, /* -299 */
+    { 0x85F0468293F0EB4EULL, 0x25BBF56008C58EA5ULL }, /* -298 */
+    { 0xA76C582338ED2621ULL, 0xAF2AF2B80AF6F24EULL }, /* -297 */
+    { 0xD1476E2C07286FAAULL, 0x1AF5AF660DB4AEE1ULL }, /* -296 */
+    { 0x82CCA4DB847945CAULL, 0x50D98D9FC890ED4DULL }, /* -295 */
+    { 0xA37FCE126597973CULL, 0xE50FF107BAB528A0ULL }, /* -294 */
+    { 0xCC5FC196FEFD7D0CULL, 0x1E53ED49A96272C8ULL }, /* -293 */
+    { 0xFF77B1FCBEBCDC4FULL, 0x25E8E89C13BB0F7AULL }, /* -292 */
+    { 0x9FAACF3DF73609B1ULL, 0x77B191618C54E9ACULL }, /* -291 */
+    { 0xC795830D75038C1DULL, 0xD59DF5B9EF6A2417ULL }, /* -290 */
+    { 0xF97AE3D0D2446F25ULL, 0x4B0573286B44AD1DULL }, /* -289 */
+    { 0x9BECCE62836AC577ULL, 0x4EE367F9430AEC32ULL }, /* -288 */
+    { 0xC2E801FB244576D5ULL, 0x229C41F793CDA73FULL }, /* -287 */
+    { 0xF3A20279ED56D48AULL, 0x6B43527578C1110FULL }, /* -286 */
+    { 0x9845418C345644D6ULL, 0x830A13896B78AAA9ULL }, /* -285 */
+    { 0xBE5691EF416BD60CULL, 0x23CC986BC656D553ULL }, /* -284 */
+    { 0xEDEC366B11C6CB8FULL, 0x2CBFBE86B7EC8AA8ULL }, /* -283 */
+    { 0x94B3A202EB1C3F39ULL, 0x7BF7D71432F3D6A9ULL }, /* -282 */
+    { 0xB9E08A83A5E34F07ULL, 0xDAF5CCD93FB0CC53ULL }, /* -281 */
+    { 0xE858AD248F5C22C9ULL, 0xD1B3400F8F9CFF68ULL }, /* -280 */
+    { 0x91376C36D99995BEULL, 0x23100809B9C21FA1ULL }, /* -279 */
+    { 0xB58547448FFFFB2DULL, 0xABD40A0C2832A78AULL }, /* -278 */
+    { 0xE2E69915B3FFF9F9ULL, 0x16C90C8F323F516CULL }, /* -277 */
+    { 0x8DD01FAD907FFC3BULL, 0xAE3DA7D97F6792E3ULL }, /* -276 */
+    { 0xB1442798F49FFB4AULL, 0x99CD11CFDF41779CULL }, /* -275 */
+    { 0xDD95317F31C7FA1DULL, 0x40405643D711D583ULL }, /* -274 */
+    { 0x8A7D3EEF7F1CFC52ULL, 0x482835EA666B2572ULL }, /* -273 */
+    { 0xAD1C8EAB5EE43B66ULL, 0xDA3243650005EECFULL }, /* -272 */
+    { 0xD863B256369D4A40ULL, 0x90BED43E40076A82ULL }, /* -271 */
+    { 0x873E4F75E2224E68ULL, 0x5A7744A6E804A291ULL }, /* -270 */
+    { 0xA90DE3535AAAE202ULL, 0x711515D0A205CB36ULL }, /* -269 */
+    { 0xD3515C2831559A83ULL, 0x0D5A5B44CA873E03ULL }, /* -268 */
+    { 0x8412D9991ED58091ULL, 0xE858790AFE9486C2ULL }, /* -267 */
+    { 0xA5178FFF668AE0B6ULL, 0x626E974DBE39A872ULL }, /* -266 */
+    { 0xCE5D73FF402D98E3ULL, 0xFB0A3D212DC8128FULL }, /* -265 */
+    { 0x80FA687F881C7F8EULL, 0x7CE66634BC9D0B99ULL }, /* -264 */
+    { 0xA139029F6A239F72ULL, 0x1C1FFFC1EBC44E80ULL }, /* -263 */
+    { 0xC987434744AC874EULL, 0xA327FFB266B56220ULL }, /* -262 */
+    { 0xFBE9141915D7A922ULL, 0x4BF1FF9F0062BAA8ULL }, /* -261 */
+    { 0x9D71AC8FADA6C9B5ULL, 0x6F773FC3603DB4A9ULL }, /* -260 */
+    { 0xC4CE17B399107C22ULL, 0xCB550FB4384D21D3ULL }, /* -259 */
+    { 0xF6019DA07F549B2BULL, 0x7E2A53A146606A48ULL }, /* -258 */
+    { 0x99C102844F94E0FBULL, 0x2EDA7444CBFC426DULL }, /* -257 */
+    { 0xC0314325637A1939ULL, 0xFA911155FEFB5308ULL }, /* -256 */
+    { 0xF03D93EEBC589F88ULL, 0x793555AB7EBA27CAULL }, /* -255 */
+    { 0x96267C7535B763B5ULL, 0x4BC1558B2F3458DEULL }, /* -254 */
+    { 0xBBB01B9283253CA2ULL, 0x9EB1AAEDFB016F16ULL }, /* -253 */
+    { 0xEA9C227723EE8BCBULL, 0x465E15A979C1CADCULL }, /* -252 */
+    { 0x92A1958A7675175FULL, 0x0BFACD89EC191EC9ULL }, /* -251 */
+    { 0xB749FAED14125D36ULL, 0xCEF980EC671F667BULL }, /* -250 */
+    { 0xE51C79A85916F484ULL, 0x82B7E12780E7401AULL }, /* -249 */
+    { 0x8F31CC0937AE58D2ULL, 0xD1B2ECB8B0908810ULL }, /* -248 */
+    { 0xB2FE3F0B8599EF07ULL, 0x861FA7E6DCB4AA15ULL }, /* -247 */
+    { 0xDFBDCECE67006AC9ULL, 0x67A791E093E1D49AULL }, /* -246 */
+    { 0x8BD6A141006042BDULL, 0xE0C8BB2C5C6D24E0ULL }, /* -245 */
+    { 0xAECC49914078536DULL, 0x58FAE9F773886E18ULL }, /* -244 */
+    { 0xDA7F5BF590966848ULL, 0xAF39A475506A899EULL }, /* -243 */
+    { 0x888F99797A5E012DULL, 0x6D8406C952429603ULL }, /* -242 */
+    { 0xAAB37FD7D8F58178ULL, 0xC8E5087BA6D33B83ULL }, /* -241 */
+    { 0xD5605FCDCF32E1D6ULL, 0xFB1E4A9A90880A64ULL }, /* -240 */
+    { 0x855C3BE0A17FCD26ULL, 0x5CF2EEA09A55067FULL }, /* -239 */
+    { 0xA6B34AD8C9DFC06FULL, 0xF42FAA48C0EA481EULL }, /* -238 */
+    { 0xD0601D8EFC57B08BULL, 0xF13B94DAF124DA26ULL }, /* -237 */
+    { 0x823C12795DB6CE57ULL, 0x76C53D08D6B70858ULL }, /* -236 */
+    { 0xA2CB1717B52481EDULL, 0x54768C4B0C64CA6EULL }, /* -235 */
+    { 0xCB7DDCDDA26DA268ULL, 0xA9942F5DCF7DFD09ULL }, /* -234 */
+    { 0xFE5D54150B090B02ULL, 0xD3F93B35435D7C4CULL }, /* -233 */
+    { 0x9EFA548D26E5A6E1ULL, 0xC47BC5014A1A6DAFULL }, /* -232 */
+    { 0xC6B8E9B0709F109AULL, 0x359AB6419CA1091BULL }, /* -231 */
+    { 0xF867241C8CC6D4C0ULL, 0xC30163D203C94B62ULL }, /* -230 */
+    { 0x9B407691D7FC44F8ULL, 0x79E0DE63425DCF1DULL }, /* -229 */
+    { 0xC21094364DFB5636ULL, 0x985915FC12F542E4ULL }, /* -228 */
+    { 0xF294B943E17A2BC4ULL, 0x3E6F5B7B17B2939DULL }, /* -227 */
+    { 0x979CF3CA6CEC5B5AULL, 0xA705992CEECF9C42ULL }, /* -226 */
+    { 0xBD8430BD08277231ULL, 0x50C6FF782A838353ULL }, /* -225 */
+    { 0xECE53CEC4A314EBDULL, 0xA4F8BF5635246428ULL }, /* -224 */
+    { 0x940F4613AE5ED136ULL, 0x871B7795E136BE99ULL }, /* -223 */
+    { 0xB913179899F68584ULL, 0x28E2557B59846E3FULL }, /* -222 */
+    { 0xE757DD7EC07426E5ULL, 0x331AEADA2FE589CFULL }, /* -221 */
+    { 0x9096EA6F3848984FULL, 0x3FF0D2C85DEF7621ULL }, /* -220 */
+    { 0xB4BCA50B065ABE63ULL, 0x0FED077A756B53A9ULL }, /* -219 */
+    { 0xE1EBCE4DC7F16DFBULL, 0xD3E8495912C62894ULL }, /* -218 */
+    { 0x8D3360F09CF6E4BDULL, 0x64712DD7ABBBD95CULL }, /* -217 */
+    { 0xB080392CC4349DECULL, 0xBD8D794D96AACFB3ULL }, /* -216 */
+    { 0xDCA04777F541C567ULL, 0xECF0D7A0FC5583A0ULL }, /* -215 */
+    { 0x89E42CAAF9491B60ULL, 0xF41686C49DB57244ULL }, /* -214 */
+    { 0xAC5D37D5B79B6239ULL, 0x311C2875C522CED5ULL }, /* -213 */
+    { 0xD77485CB25823AC7ULL, 0x7D633293366B828BULL }, /* -212 */
+    { 0x86A8D39EF77164BCULL, 0xAE5DFF9C02033197ULL }, /* -211 */
+    { 0xA8530886B54DBDEBULL, 0xD9F57F830283FDFCULL }, /* -210 */
+    { 0xD267CAA862A12D66ULL, 0xD072DF63C324FD7BULL }, /* -209 */
+    { 0x8380DEA93DA4BC60ULL, 0x4247CB9E59F71E6DULL }, /* -208 */
+    { 0xA46116538D0DEB78ULL, 0x52D9BE85F074E608ULL }, /* -207 */
+    { 0xCD795BE870516656ULL, 0x67902E276C921F8BULL }, /* -206 */
+    { 0x806BD9714632DFF6ULL, 0x00BA1CD8A3DB53B6ULL }, /* -205 */
+    { 0xA086CFCD97BF97F3ULL, 0x80E8A40ECCD228A4ULL }, /* -204 */
+    { 0xC8A883C0FDAF7DF0ULL, 0x6122CD128006B2CDULL }, /* -203 */
+    { 0xFAD2A4B13D1B5D6CULL, 0x796B805720085F81ULL }, /* -202 */
+    { 0x9CC3A6EEC6311A63ULL, 0xCBE3303674053BB0ULL }, /* -201 */
+    { 0xC3F490AA77BD60FCULL, 0xBEDBFC4411068A9CULL }, /* -200 */
+    { 0xF4F1B4D515ACB93BULL, 0xEE92FB5515482D44ULL }, /* -199 */
+    { 0x991711052D8BF3C5ULL, 0x751BDD152D4D1C4AULL }, /* -198 */
+    { 0xBF5CD54678EEF0B6ULL, 0xD262D45A78A0635DULL }, /* -197 */
+    { 0xEF340A98172AACE4ULL, 0x86FB897116C87C34ULL }, /* -196 */
+    { 0x9580869F0E7AAC0EULL, 0xD45D35E6AE3D4DA0ULL }, /* -195 */
+    { 0xBAE0A846D2195712ULL, 0x8974836059CCA109ULL }, /* -194 */
+    { 0xE998D258869FACD7ULL, 0x2BD1A438703FC94BULL }, /* -193 */
+    { 0x91FF83775423CC06ULL, 0x7B6306A34627DDCFULL }, /* -192 */
+    { 0xB67F6455292CBF08ULL, 0x1A3BC84C17B1D542ULL }, /* -191 */
+    { 0xE41F3D6A7377EECAULL, 0x20CABA5F1D9E4A93ULL }, /* -190 */
+    { 0x8E938662882AF53EULL, 0x547EB47B7282EE9CULL }, /* -189 */
+    { 0xB23867FB2A35B28DULL, 0xE99E619A4F23AA43ULL }, /* -188 */
+    { 0xDEC681F9F4C31F31ULL, 0x6405FA00E2EC94D4ULL }, /* -187 */
+    { 0x8B3C113C38F9F37EULL, 0xDE83BC408DD3DD04ULL }, /* -186 */
+    { 0xAE0B158B4738705EULL, 0x9624AB50B148D445ULL }, /* -185 */
+    { 0xD98DDAEE19068C76ULL, 0x3BADD624DD9B0957ULL }, /* -184 */
+    { 0x87F8A8D4CFA417C9ULL, 0xE54CA5D70A80E5D6ULL }, /* -183 */
+    { 0xA9F6D30A038D1DBCULL, 0x5E9FCF4CCD211F4CULL }, /* -182 */
+    { 0xD47487CC8470652BULL, 0x7647C3200069671FULL }, /* -181 */
+    { 0x84C8D4DFD2C63F3BULL, 0x29ECD9F40041E073ULL }, /* -180 */
+    { 0xA5FB0A17C777CF09ULL, 0xF468107100525890ULL }, /* -179 */
+    { 0xCF79CC9DB955C2CCULL, 0x7182148D4066EEB4ULL }, /* -178 */
+    { 0x81AC1FE293D599BFULL, 0xC6F14CD848405530ULL }, /* -177 */
+    { 0xA21727DB38CB002FULL, 0xB8ADA00E5A506A7CULL }, /* -176 */
+    { 0xCA9CF1D206FDC03BULL, 0xA6D90811F0E4851CULL }, /* -175 */
+    { 0xFD442E4688BD304AULL, 0x908F4A166D1DA663ULL }, /* -174 */
+    { 0x9E4A9CEC15763E2EULL, 0x9A598E4E043287FEULL }, /* -173 */
+    { 0xC5DD44271AD3CDBAULL, 0x40EFF1E1853F29FDULL }, /* -172 */
+    { 0xF7549530E188C128ULL, 0xD12BEE59E68EF47CULL }, /* -171 */
+    { 0x9A94DD3E8CF578B9ULL, 0x82BB74F8301958CEULL }, /* -170 */
+    { 0xC13A148E3032D6E7ULL, 0xE36A52363C1FAF01ULL }, /* -169 */
+    { 0xF18899B1BC3F8CA1ULL, 0xDC44E6C3CB279AC1ULL }, /* -168 */
+    { 0x96F5600F15A7B7E5ULL, 0x29AB103A5EF8C0B9ULL }, /* -167 */
+    { 0xBCB2B812DB11A5DEULL, 0x7415D448F6B6F0E7ULL }, /* -166 */
+    { 0xEBDF661791D60F56ULL, 0x111B495B3464AD21ULL }, /* -165 */
+    { 0x936B9FCEBB25C995ULL, 0xCAB10DD900BEEC34ULL }, /* -164 */
+    { 0xB84687C269EF3BFBULL, 0x3D5D514F40EEA742ULL }, /* -163 */
+    { 0xE65829B3046B0AFAULL, 0x0CB4A5A3112A5112ULL }, /* -162 */
+    { 0x8FF71A0FE2C2E6DCULL, 0x47F0E785EABA72ABULL }, /* -161 */
+    { 0xB3F4E093DB73A093ULL, 0x59ED216765690F56ULL }, /* -160 */
+    { 0xE0F218B8D25088B8ULL, 0x306869C13EC3532CULL }, /* -159 */
+    { 0x8C974F7383725573ULL, 0x1E414218C73A13FBULL }, /* -158 */
+    { 0xAFBD2350644EEACFULL, 0xE5D1929EF90898FAULL }, /* -157 */
+    { 0xDBAC6C247D62A583ULL, 0xDF45F746B74ABF39ULL }, /* -156 */
+    { 0x894BC396CE5DA772ULL, 0x6B8BBA8C328EB783ULL }, /* -155 */
+    { 0xAB9EB47C81F5114FULL, 0x066EA92F3F326564ULL }, /* -154 */
+    { 0xD686619BA27255A2ULL, 0xC80A537B0EFEFEBDULL }, /* -153 */
+    { 0x8613FD0145877585ULL, 0xBD06742CE95F5F36ULL }, /* -152 */
+    { 0xA798FC4196E952E7ULL, 0x2C48113823B73704ULL }, /* -151 */
+    { 0xD17F3B51FCA3A7A0ULL, 0xF75A15862CA504C5ULL }, /* -150 */
+    { 0x82EF85133DE648C4ULL, 0x9A984D73DBE722FBULL }, /* -149 */
+    { 0xA3AB66580D5FDAF5ULL, 0xC13E60D0D2E0EBBAULL }, /* -148 */
+    { 0xCC963FEE10B7D1B3ULL, 0x318DF905079926A8ULL }, /* -147 */
+    { 0xFFBBCFE994E5C61FULL, 0xFDF17746497F7052ULL }, /* -146 */
+    { 0x9FD561F1FD0F9BD3ULL, 0xFEB6EA8BEDEFA633ULL }, /* -145 */
+    { 0xC7CABA6E7C5382C8ULL, 0xFE64A52EE96B8FC0ULL }, /* -144 */
+    { 0xF9BD690A1B68637BULL, 0x3DFDCE7AA3C673B0ULL }, /* -143 */
+    { 0x9C1661A651213E2DULL, 0x06BEA10CA65C084EULL }, /* -142 */
+    { 0xC31BFA0FE5698DB8ULL, 0x486E494FCFF30A62ULL }, /* -141 */
+    { 0xF3E2F893DEC3F126ULL, 0x5A89DBA3C3EFCCFAULL }, /* -140 */
+    { 0x986DDB5C6B3A76B7ULL, 0xF89629465A75E01CULL }, /* -139 */
+    { 0xBE89523386091465ULL, 0xF6BBB397F1135823ULL }, /* -138 */
+    { 0xEE2BA6C0678B597FULL, 0x746AA07DED582E2CULL }, /* -137 */
+    { 0x94DB483840B717EFULL, 0xA8C2A44EB4571CDCULL }, /* -136 */
+    { 0xBA121A4650E4DDEBULL, 0x92F34D62616CE413ULL }, /* -135 */
+    { 0xE896A0D7E51E1566ULL, 0x77B020BAF9C81D17ULL }, /* -134 */
+    { 0x915E2486EF32CD60ULL, 0x0ACE1474DC1D122EULL }, /* -133 */
+    { 0xB5B5ADA8AAFF80B8ULL, 0x0D819992132456BAULL }, /* -132 */
+    { 0xE3231912D5BF60E6ULL, 0x10E1FFF697ED6C69ULL }, /* -131 */
+    { 0x8DF5EFABC5979C8FULL, 0xCA8D3FFA1EF463C1ULL }, /* -130 */
+    { 0xB1736B96B6FD83B3ULL, 0xBD308FF8A6B17CB2ULL }, /* -129 */
+    { 0xDDD0467C64BCE4A0ULL, 0xAC7CB3F6D05DDBDEULL }, /* -128 */
+    { 0x8AA22C0DBEF60EE4ULL, 0x6BCDF07A423AA96BULL }, /* -127 */
+    { 0xAD4AB7112EB3929DULL, 0x86C16C98D2C953C6ULL }, /* -126 */
+    { 0xD89D64D57A607744ULL, 0xE871C7BF077BA8B7ULL }, /* -125 */
+    { 0x87625F056C7C4A8BULL, 0x11471CD764AD4972ULL }, /* -124 */
+    { 0xA93AF6C6C79B5D2DULL, 0xD598E40D3DD89BCFULL }, /* -123 */
+    { 0xD389B47879823479ULL, 0x4AFF1D108D4EC2C3ULL }, /* -122 */
+    { 0x843610CB4BF160CBULL, 0xCEDF722A585139BAULL }, /* -121 */
+    { 0xA54394FE1EEDB8FEULL, 0xC2974EB4EE658828ULL }, /* -120 */
+    { 0xCE947A3DA6A9273EULL, 0x733D226229FEEA32ULL }, /* -119 */
+    { 0x811CCC668829B887ULL, 0x0806357D5A3F525FULL }, /* -118 */
+    { 0xA163FF802A3426A8ULL, 0xCA07C2DCB0CF26F7ULL }, /* -117 */
+    { 0xC9BCFF6034C13052ULL, 0xFC89B393DD02F0B5ULL }, /* -116 */
+    { 0xFC2C3F3841F17C67ULL, 0xBBAC2078D443ACE2ULL }, /* -115 */
+    { 0x9D9BA7832936EDC0ULL, 0xD54B944B84AA4C0DULL }, /* -114 */
+    { 0xC5029163F384A931ULL, 0x0A9E795E65D4DF11ULL }, /* -113 */
+    { 0xF64335BCF065D37DULL, 0x4D4617B5FF4A16D5ULL }, /* -112 */
+    { 0x99EA0196163FA42EULL, 0x504BCED1BF8E4E45ULL }, /* -111 */
+    { 0xC06481FB9BCF8D39ULL, 0xE45EC2862F71E1D6ULL }, /* -110 */
+    { 0xF07DA27A82C37088ULL, 0x5D767327BB4E5A4CULL }, /* -109 */
+    { 0x964E858C91BA2655ULL, 0x3A6A07F8D510F86FULL }, /* -108 */
+    { 0xBBE226EFB628AFEAULL, 0x890489F70A55368BULL }, /* -107 */
+    { 0xEADAB0ABA3B2DBE5ULL, 0x2B45AC74CCEA842EULL }, /* -106 */
+    { 0x92C8AE6B464FC96FULL, 0x3B0B8BC90012929DULL }, /* -105 */
+    { 0xB77ADA0617E3BBCBULL, 0x09CE6EBB40173744ULL }, /* -104 */
+    { 0xE55990879DDCAABDULL, 0xCC420A6A101D0515ULL }, /* -103 */
+    { 0x8F57FA54C2A9EAB6ULL, 0x9FA946824A12232DULL }, /* -102 */
+    { 0xB32DF8E9F3546564ULL, 0x47939822DC96ABF9ULL }, /* -101 */
+    { 0xDFF9772470297EBDULL, 0x59787E2B93BC56F7ULL }, /* -100 */
+    { 0x8BFBEA76C619EF36ULL, 0x57EB4EDB3C55B65AULL }, /* -99 */
+    { 0xAEFAE51477A06B03ULL, 0xEDE622920B6B23F1ULL }, /* -98 */
+    { 0xDAB99E59958885C4ULL, 0xE95FAB368E45ECEDULL }, /* -97 */
+    { 0x88B402F7FD75539BULL, 0x11DBCB0218EBB414ULL }, /* -96 */
+    { 0xAAE103B5FCD2A881ULL, 0xD652BDC29F26A119ULL }, /* -95 */
+    { 0xD59944A37C0752A2ULL, 0x4BE76D3346F0495FULL }, /* -94 */
+    { 0x857FCAE62D8493A5ULL, 0x6F70A4400C562DDBULL }, /* -93 */
+    { 0xA6DFBD9FB8E5B88EULL, 0xCB4CCD500F6BB952ULL }, /* -92 */
+    { 0xD097AD07A71F26B2ULL, 0x7E2000A41346A7A7ULL }, /* -91 */
+    { 0x825ECC24C873782FULL, 0x8ED400668C0C28C8ULL }, /* -90 */
+    { 0xA2F67F2DFA90563BULL, 0x728900802F0F32FAULL }, /* -89 */
+    { 0xCBB41EF979346BCAULL, 0x4F2B40A03AD2FFB9ULL }, /* -88 */
+    { 0xFEA126B7D78186BCULL, 0xE2F610C84987BFA8ULL }, /* -87 */
+    { 0x9F24B832E6B0F436ULL, 0x0DD9CA7D2DF4D7C9ULL }, /* -86 */
+    { 0xC6EDE63FA05D3143ULL, 0x91503D1C79720DBBULL }, /* -85 */
+    { 0xF8A95FCF88747D94ULL, 0x75A44C6397CE912AULL }, /* -84 */
+    { 0x9B69DBE1B548CE7CULL, 0xC986AFBE3EE11ABAULL }, /* -83 */
+    { 0xC24452DA229B021BULL, 0xFBE85BADCE996168ULL }, /* -82 */
+    { 0xF2D56790AB41C2A2ULL, 0xFAE27299423FB9C3ULL }, /* -81 */
+    { 0x97C560BA6B0919A5ULL, 0xDCCD879FC967D41AULL }, /* -80 */
+    { 0xBDB6B8E905CB600FULL, 0x5400E987BBC1C920ULL }, /* -79 */
+    { 0xED246723473E3813ULL, 0x290123E9AAB23B68ULL }, /* -78 */
+    { 0x9436C0760C86E30BULL, 0xF9A0B6720AAF6521ULL }, /* -77 */
+    { 0xB94470938FA89BCEULL, 0xF808E40E8D5B3E69ULL }, /* -76 */
+    { 0xE7958CB87392C2C2ULL, 0xB60B1D1230B20E04ULL }, /* -75 */
+    { 0x90BD77F3483BB9B9ULL, 0xB1C6F22B5E6F48C2ULL }, /* -74 */
+    { 0xB4ECD5F01A4AA828ULL, 0x1E38AEB6360B1AF3ULL }, /* -73 */
+    { 0xE2280B6C20DD5232ULL, 0x25C6DA63C38DE1B0ULL }, /* -72 */
+    { 0x8D590723948A535FULL, 0x579C487E5A38AD0EULL }, /* -71 */
+    { 0xB0AF48EC79ACE837ULL, 0x2D835A9DF0C6D851ULL }, /* -70 */
+    { 0xDCDB1B2798182244ULL, 0xF8E431456CF88E65ULL }, /* -69 */
+    { 0x8A08F0F8BF0F156BULL, 0x1B8E9ECB641B58FFULL }, /* -68 */
+    { 0xAC8B2D36EED2DAC5ULL, 0xE272467E3D222F3FULL }, /* -67 */
+    { 0xD7ADF884AA879177ULL, 0x5B0ED81DCC6ABB0FULL }, /* -66 */
+    { 0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL }, /* -65 */
+    { 0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL }, /* -64 */
+    { 0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL }, /* -63 */
+    { 0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL }, /* -62 */
+    { 0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL }, /* -61 */
+    { 0xCDB02555653131B6ULL, 0x3792F412CB06794DULL }, /* -60 */
+    { 0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL }, /* -59 */
+    { 0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL }, /* -58 */
+    { 0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL }, /* -57 */
+    { 0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL }, /* -56 */
+    { 0x9CED737BB6C4183DULL, 0x55464DD69685606BULL }, /* -55 */
+    { 0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL }, /* -54 */
+    { 0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL }, /* -53 */
+    { 0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL }, /* -52 */
+    { 0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL }, /* -51 */
+    { 0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL }, /* -50 */
+    { 0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL }, /* -49 */
+    { 0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL }, /* -48 */
+    { 0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL }, /* -47 */
+    { 0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL }, /* -46 */
+    { 0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL }, /* -45 */
+    { 0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL }, /* -44 */
+    { 0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL }, /* -43 */
+    { 0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL }, /* -42 */
+    { 0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL }, /* -41 */
+    { 0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL }, /* -40 */
+    { 0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL }, /* -39 */
+    { 0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL }, /* -38 */
+    { 0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL }, /* -37 */
+    { 0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL }, /* -36 */
+    { 0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL }, /* -35 */
+    { 0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL }, /* -34 */
+    { 0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL }, /* -33 */
+    { 0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL }, /* -32 */
+    { 0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL }, /* -31 */
+    { 0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL }, /* -30 */
+    { 0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL }, /* -29 */
+    { 0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL }, /* -28 */
+    { 0x9E74D1B791E07E48ULL, 0x775EA264CF55347DULL }, /* -27 */
+    { 0xC612062576589DDAULL, 0x95364AFE032A819DULL }, /* -26 */
+    { 0xF79687AED3EEC551ULL, 0x3A83DDBD83F52204ULL }, /* -25 */
+    { 0x9ABE14CD44753B52ULL, 0xC4926A9672793542ULL }, /* -24 */
+    { 0xC16D9A0095928A27ULL, 0x75B7053C0F178293ULL }, /* -23 */
+    { 0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6338ULL }, /* -22 */
+    { 0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E03ULL }, /* -21 */
+    { 0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF584ULL }, /* -20 */
+    { 0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E5ULL }, /* -19 */
+    { 0x9392EE8E921D5D07ULL, 0x3AFF322E62439FCFULL }, /* -18 */
+    { 0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C2ULL }, /* -17 */
+    { 0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B3ULL }, /* -16 */
+    { 0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A10ULL }, /* -15 */
+    { 0xB424DC35095CD80FULL, 0x538484C19EF38C94ULL }, /* -14 */
+    { 0xE12E13424BB40E13ULL, 0x2865A5F206B06FB9ULL }, /* -13 */
+    { 0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D3ULL }, /* -12 */
+    { 0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D748ULL }, /* -11 */
+    { 0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1BULL }, /* -10 */
+    { 0x89705F4136B4A597ULL, 0x31680A88F8953030ULL }, /* -9 */
+    { 0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3DULL }, /* -8 */
+    { 0xD6BF94D5E57A42BCULL, 0x3D32907604691B4CULL }, /* -7 */
+    { 0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B10FULL }, /* -6 */
+    { 0xA7C5AC471B478423ULL, 0x0FCF80DC33721D53ULL }, /* -5 */
+    { 0xD1B71758E219652BULL, 0xD3C36113404EA4A8ULL }, /* -4 */
+    { 0x83126E978D4FDF3BULL, 0x645A1CAC083126E9ULL }, /* -3 */
+    { 0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A3ULL }, /* -2 */
+    { 0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCCULL }, /* -1 */
+    { 0x8000000000000000ULL, 0x0000000000000000ULL }, /* 0 */
+    { 0xA000000000000000ULL, 0x0000000000000000ULL }, /* 1 */
+    { 0xC800000000000000ULL, 0x0000000000000000ULL }, /* 2 */
+    { 0xFA00000000000000ULL, 0x0000000000000000ULL }, /* 3 */
+    { 0x9C40000000000000ULL, 0x0000000000000000ULL }, /* 4 */
+    { 0xC350000000000000ULL, 0x0000000000000000ULL }, /* 5 */
+    { 0xF424000000000000ULL, 0x0000000000000000ULL }, /* 6 */
+    { 0x9896800000000000ULL, 0x0000000000000000ULL }, /* 7 */
+    { 0xBEBC200000000000ULL, 0x0000000000000000ULL }, /* 8 */
+    { 0xEE6B280000000000ULL, 0x0000000000000000ULL }, /* 9 */
+    { 0x9502F90000000000ULL, 0x0000000000000000ULL }, /* 10 */
+    { 0xBA43B74000000000ULL, 0x0000000000000000ULL }, /* 11 */
+    { 0xE8D4A51000000000ULL, 0x0000000000000000ULL }, /* 12 */
+    { 0x9184E72A00000000ULL, 0x0000000000000000ULL }, /* 13 */
+    { 0xB5E620F480000000ULL, 0x0000000000000000ULL }, /* 14 */
+    { 0xE35FA931A0000000ULL, 0x0000000000000000ULL }, /* 15 */
+    { 0x8E1BC9BF04000000ULL, 0x0000000000000000ULL }, /* 16 */
+    { 0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL }, /* 17 */
+    { 0xDE0B6B3A76400000ULL, 0x0000000000000000ULL }, /* 18 */
+    { 0x8AC7230489E80000ULL, 0x0000000000000000ULL }, /* 19 */
+    { 0xAD78EBC5AC620000ULL, 0x0000000000000000ULL }, /* 20 */
+    { 0xD8D726B7177A8000ULL, 0x0000000000000000ULL }, /* 21 */
+    { 0x878678326EAC9000ULL, 0x0000000000000000ULL }, /* 22 */
+    { 0xA968163F0A57B400ULL, 0x0000000000000000ULL }, /* 23 */
+    { 0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL }, /* 24 */
+    { 0x84595161401484A0ULL, 0x0000000000000000ULL }, /* 25 */
+    { 0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL }, /* 26 */
+    { 0xCECB8F27F4200F3AULL, 0x0000000000000000ULL }, /* 27 */
+    { 0x813F3978F8940984ULL, 0x4000000000000000ULL }, /* 28 */
+    { 0xA18F07D736B90BE5ULL, 0x5000000000000000ULL }, /* 29 */
+    { 0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL }, /* 30 */
+    { 0xFC6F7C4045812296ULL, 0x4D00000000000000ULL }, /* 31 */
+    { 0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL }, /* 32 */
+    { 0xC5371912364CE305ULL, 0x6C28000000000000ULL }, /* 33 */
+    { 0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL }, /* 34 */
+    { 0x9A130B963A6C115CULL, 0x3C7F400000000000ULL }, /* 35 */
+    { 0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL }, /* 36 */
+    { 0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL }, /* 37 */
+    { 0x96769950B50D88F4ULL, 0x1314448000000000ULL }, /* 38 */
+    { 0xBC143FA4E250EB31ULL, 0x17D955A000000000ULL }, /* 39 */
+    { 0xEB194F8E1AE525FDULL, 0x5DCFAB0800000000ULL }, /* 40 */
+    { 0x92EFD1B8D0CF37BEULL, 0x5AA1CAE500000000ULL }, /* 41 */
+    { 0xB7ABC627050305ADULL, 0xF14A3D9E40000000ULL }, /* 42 */
+    { 0xE596B7B0C643C719ULL, 0x6D9CCD05D0000000ULL }, /* 43 */
+    { 0x8F7E32CE7BEA5C6FULL, 0xE4820023A2000000ULL }, /* 44 */
+    { 0xB35DBF821AE4F38BULL, 0xDDA2802C8A800000ULL }, /* 45 */
+    { 0xE0352F62A19E306EULL, 0xD50B2037AD200000ULL }, /* 46 */
+    { 0x8C213D9DA502DE45ULL, 0x4526F422CC340000ULL }, /* 47 */
+    { 0xAF298D050E4395D6ULL, 0x9670B12B7F410000ULL }, /* 48 */
+    { 0xDAF3F04651D47B4CULL, 0x3C0CDD765F114000ULL }, /* 49 */
+    { 0x88D8762BF324CD0FULL, 0xA5880A69FB6AC800ULL }, /* 50 */
+    { 0xAB0E93B6EFEE0053ULL, 0x8EEA0D047A457A00ULL }, /* 51 */
+    { 0xD5D238A4ABE98068ULL, 0x72A4904598D6D880ULL }, /* 52 */
+    { 0x85A36366EB71F041ULL, 0x47A6DA2B7F864750ULL }, /* 53 */
+    { 0xA70C3C40A64E6C51ULL, 0x999090B65F67D924ULL }, /* 54 */
+    { 0xD0CF4B50CFE20765ULL, 0xFFF4B4E3F741CF6DULL }, /* 55 */
+    { 0x82818F1281ED449FULL, 0xBFF8F10E7A8921A4ULL }, /* 56 */
+    { 0xA321F2D7226895C7ULL, 0xAFF72D52192B6A0DULL }, /* 57 */
+    { 0xCBEA6F8CEB02BB39ULL, 0x9BF4F8A69F764490ULL }, /* 58 */
+    { 0xFEE50B7025C36A08ULL, 0x02F236D04753D5B4ULL }, /* 59 */
+    { 0x9F4F2726179A2245ULL, 0x01D762422C946590ULL }, /* 60 */
+    { 0xC722F0EF9D80AAD6ULL, 0x424D3AD2B7B97EF5ULL }, /* 61 */
+    { 0xF8EBAD2B84E0D58BULL, 0xD2E0898765A7DEB2ULL }, /* 62 */
+    { 0x9B934C3B330C8577ULL, 0x63CC55F49F88EB2FULL }, /* 63 */
+    { 0xC2781F49FFCFA6D5ULL, 0x3CBF6B71C76B25FBULL }, /* 64 */
+    { 0xF316271C7FC3908AULL, 0x8BEF464E3945EF7AULL }, /* 65 */
+    { 0x97EDD871CFDA3A56ULL, 0x97758BF0E3CBB5ACULL }, /* 66 */
+    { 0xBDE94E8E43D0C8ECULL, 0x3D52EEED1CBEA317ULL }, /* 67 */
+    { 0xED63A231D4C4FB27ULL, 0x4CA7AAA863EE4BDDULL }, /* 68 */
+    { 0x945E455F24FB1CF8ULL, 0x8FE8CAA93E74EF6AULL }, /* 69 */
+    { 0xB975D6B6EE39E436ULL, 0xB3E2FD538E122B44ULL }, /* 70 */
+    { 0xE7D34C64A9C85D44ULL, 0x60DBBCA87196B616ULL }, /* 71 */
+    { 0x90E40FBEEA1D3A4AULL, 0xBC8955E946FE31CDULL }, /* 72 */
+    { 0xB51D13AEA4A488DDULL, 0x6BABAB6398BDBE41ULL }, /* 73 */
+    { 0xE264589A4DCDAB14ULL, 0xC696963C7EED2DD1ULL }, /* 74 */
+    { 0x8D7EB76070A08AECULL, 0xFC1E1DE5CF543CA2ULL }, /* 75 */
+    { 0xB0DE65388CC8ADA8ULL, 0x3B25A55F43294BCBULL }, /* 76 */
+    { 0xDD15FE86AFFAD912ULL, 0x49EF0EB713F39EBEULL }, /* 77 */
+    { 0x8A2DBF142DFCC7ABULL, 0x6E3569326C784337ULL }, /* 78 */
+    { 0xACB92ED9397BF996ULL, 0x49C2C37F07965404ULL }, /* 79 */
+    { 0xD7E77A8F87DAF7FBULL, 0xDC33745EC97BE906ULL }, /* 80 */
+    { 0x86F0AC99B4E8DAFDULL, 0x69A028BB3DED71A3ULL }, /* 81 */
+    { 0xA8ACD7C0222311BCULL, 0xC40832EA0D68CE0CULL }, /* 82 */
+    { 0xD2D80DB02AABD62BULL, 0xF50A3FA490C30190ULL }, /* 83 */
+    { 0x83C7088E1AAB65DBULL, 0x792667C6DA79E0FAULL }, /* 84 */
+    { 0xA4B8CAB1A1563F52ULL, 0x577001B891185938ULL }, /* 85 */
+    { 0xCDE6FD5E09ABCF26ULL, 0xED4C0226B55E6F86ULL }, /* 86 */
+    { 0x80B05E5AC60B6178ULL, 0x544F8158315B05B4ULL }, /* 87 */
+    { 0xA0DC75F1778E39D6ULL, 0x696361AE3DB1C721ULL }, /* 88 */
+    { 0xC913936DD571C84CULL, 0x03BC3A19CD1E38E9ULL }, /* 89 */
+    { 0xFB5878494ACE3A5FULL, 0x04AB48A04065C723ULL }, /* 90 */
+    { 0x9D174B2DCEC0E47BULL, 0x62EB0D64283F9C76ULL }, /* 91 */
+    { 0xC45D1DF942711D9AULL, 0x3BA5D0BD324F8394ULL }, /* 92 */
+    { 0xF5746577930D6500ULL, 0xCA8F44EC7EE36479ULL }, /* 93 */
+    { 0x9968BF6ABBE85F20ULL, 0x7E998B13CF4E1ECBULL }, /* 94 */
+    { 0xBFC2EF456AE276E8ULL, 0x9E3FEDD8C321A67EULL }, /* 95 */
+    { 0xEFB3AB16C59B14A2ULL, 0xC5CFE94EF3EA101EULL }, /* 96 */
+    { 0x95D04AEE3B80ECE5ULL, 0xBBA1F1D158724A12ULL }, /* 97 */
+    { 0xBB445DA9CA61281FULL, 0x2A8A6E45AE8EDC97ULL }, /* 98 */
+    { 0xEA1575143CF97226ULL, 0xF52D09D71A3293BDULL }, /* 99 */
+    { 0x924D692CA61BE758ULL, 0x593C2626705F9C56ULL }, /* 100 */
+    { 0xB6E0C377CFA2E12EULL, 0x6F8B2FB00C77836CULL }, /* 101 */
+    { 0xE498F455C38B997AULL, 0x0B6DFB9C0F956447ULL }, /* 102 */
+    { 0x8EDF98B59A373FECULL, 0x4724BD4189BD5EACULL }, /* 103 */
+    { 0xB2977EE300C50FE7ULL, 0x58EDEC91EC2CB657ULL }, /* 104 */
+    { 0xDF3D5E9BC0F653E1ULL, 0x2F2967B66737E3EDULL }, /* 105 */
+    { 0x8B865B215899F46CULL, 0xBD79E0D20082EE74ULL }, /* 106 */
+    { 0xAE67F1E9AEC07187ULL, 0xECD8590680A3AA11ULL }, /* 107 */
+    { 0xDA01EE641A708DE9ULL, 0xE80E6F4820CC9495ULL }, /* 108 */
+    { 0x884134FE908658B2ULL, 0x3109058D147FDCDDULL }, /* 109 */
+    { 0xAA51823E34A7EEDEULL, 0xBD4B46F0599FD415ULL }, /* 110 */
+    { 0xD4E5E2CDC1D1EA96ULL, 0x6C9E18AC7007C91AULL }, /* 111 */
+    { 0x850FADC09923329EULL, 0x03E2CF6BC604DDB0ULL }, /* 112 */
+    { 0xA6539930BF6BFF45ULL, 0x84DB8346B786151CULL }, /* 113 */
+    { 0xCFE87F7CEF46FF16ULL, 0xE612641865679A63ULL }, /* 114 */
+    { 0x81F14FAE158C5F6EULL, 0x4FCB7E8F3F60C07EULL }, /* 115 */
+    { 0xA26DA3999AEF7749ULL, 0xE3BE5E330F38F09DULL }, /* 116 */
+    { 0xCB090C8001AB551CULL, 0x5CADF5BFD3072CC5ULL }, /* 117 */
+    { 0xFDCB4FA002162A63ULL, 0x73D9732FC7C8F7F6ULL }, /* 118 */
+    { 0x9E9F11C4014DDA7EULL, 0x2867E7FDDCDD9AFAULL }, /* 119 */
+    { 0xC646D63501A1511DULL, 0xB281E1FD541501B8ULL }, /* 120 */
+    { 0xF7D88BC24209A565ULL, 0x1F225A7CA91A4226ULL }, /* 121 */
+    { 0x9AE757596946075FULL, 0x3375788DE9B06958ULL }, /* 122 */
+    { 0xC1A12D2FC3978937ULL, 0x0052D6B1641C83AEULL }, /* 123 */
+    { 0xF209787BB47D6B84ULL, 0xC0678C5DBD23A49AULL }, /* 124 */
+    { 0x9745EB4D50CE6332ULL, 0xF840B7BA963646E0ULL }, /* 125 */
+    { 0xBD176620A501FBFFULL, 0xB650E5A93BC3D898ULL }, /* 126 */
+    { 0xEC5D3FA8CE427AFFULL, 0xA3E51F138AB4CEBEULL }, /* 127 */
+    { 0x93BA47C980E98CDFULL, 0xC66F336C36B10137ULL }, /* 128 */
+    { 0xB8A8D9BBE123F017ULL, 0xB80B0047445D4184ULL }, /* 129 */
+    { 0xE6D3102AD96CEC1DULL, 0xA60DC059157491E5ULL }, /* 130 */
+    { 0x9043EA1AC7E41392ULL, 0x87C89837AD68DB2FULL }, /* 131 */
+    { 0xB454E4A179DD1877ULL, 0x29BABE4598C311FBULL }, /* 132 */
+    { 0xE16A1DC9D8545E94ULL, 0xF4296DD6FEF3D67AULL }, /* 133 */
+    { 0x8CE2529E2734BB1DULL, 0x1899E4A65F58660CULL }, /* 134 */
+    { 0xB01AE745B101E9E4ULL, 0x5EC05DCFF72E7F8FULL }, /* 135 */
+    { 0xDC21A1171D42645DULL, 0x76707543F4FA1F73ULL }, /* 136 */
+    { 0x899504AE72497EBAULL, 0x6A06494A791C53A8ULL }, /* 137 */
+    { 0xABFA45DA0EDBDE69ULL, 0x0487DB9D17636892ULL }, /* 138 */
+    { 0xD6F8D7509292D603ULL, 0x45A9D2845D3C42B6ULL }, /* 139 */
+    { 0x865B86925B9BC5C2ULL, 0x0B8A2392BA45A9B2ULL }, /* 140 */
+    { 0xA7F26836F282B732ULL, 0x8E6CAC7768D7141EULL }, /* 141 */
+    { 0xD1EF0244AF2364FFULL, 0x3207D795430CD926ULL }, /* 142 */
+    { 0x8335616AED761F1FULL, 0x7F44E6BD49E807B8ULL }, /* 143 */
+    { 0xA402B9C5A8D3A6E7ULL, 0x5F16206C9C6209A6ULL }, /* 144 */
+    { 0xCD036837130890A1ULL, 0x36DBA887C37A8C0FULL }, /* 145 */
+    { 0x802221226BE55A64ULL, 0xC2494954DA2C9789ULL }, /* 146 */
+    { 0xA02AA96B06DEB0FDULL, 0xF2DB9BAA10B7BD6CULL }, /* 147 */
+    { 0xC83553C5C8965D3DULL, 0x6F92829494E5ACC7ULL }, /* 148 */
+    { 0xFA42A8B73ABBF48CULL, 0xCB772339BA1F17F9ULL }, /* 149 */
+    { 0x9C69A97284B578D7ULL, 0xFF2A760414536EFBULL }, /* 150 */
+    { 0xC38413CF25E2D70DULL, 0xFEF5138519684ABAULL }, /* 151 */
+    { 0xF46518C2EF5B8CD1ULL, 0x7EB258665FC25D69ULL }, /* 152 */
+    { 0x98BF2F79D5993802ULL, 0xEF2F773FFBD97A61ULL }, /* 153 */
+    { 0xBEEEFB584AFF8603ULL, 0xAAFB550FFACFD8FAULL }, /* 154 */
+    { 0xEEAABA2E5DBF6784ULL, 0x95BA2A53F983CF38ULL }, /* 155 */
+    { 0x952AB45CFA97A0B2ULL, 0xDD945A747BF26183ULL }, /* 156 */
+    { 0xBA756174393D88DFULL, 0x94F971119AEEF9E4ULL }, /* 157 */
+    { 0xE912B9D1478CEB17ULL, 0x7A37CD5601AAB85DULL }, /* 158 */
+    { 0x91ABB422CCB812EEULL, 0xAC62E055C10AB33AULL }, /* 159 */
+    { 0xB616A12B7FE617AAULL, 0x577B986B314D6009ULL }, /* 160 */
+    { 0xE39C49765FDF9D94ULL, 0xED5A7E85FDA0B80BULL }, /* 161 */
+    { 0x8E41ADE9FBEBC27DULL, 0x14588F13BE847307ULL }, /* 162 */
+    { 0xB1D219647AE6B31CULL, 0x596EB2D8AE258FC8ULL }, /* 163 */
+    { 0xDE469FBD99A05FE3ULL, 0x6FCA5F8ED9AEF3BBULL }, /* 164 */
+    { 0x8AEC23D680043BEEULL, 0x25DE7BB9480D5854ULL }, /* 165 */
+    { 0xADA72CCC20054AE9ULL, 0xAF561AA79A10AE6AULL }, /* 166 */
+    { 0xD910F7FF28069DA4ULL, 0x1B2BA1518094DA04ULL }, /* 167 */
+    { 0x87AA9AFF79042286ULL, 0x90FB44D2F05D0842ULL }, /* 168 */
+    { 0xA99541BF57452B28ULL, 0x353A1607AC744A53ULL }, /* 169 */
+    { 0xD3FA922F2D1675F2ULL, 0x42889B8997915CE8ULL }, /* 170 */
+    { 0x847C9B5D7C2E09B7ULL, 0x69956135FEBADA11ULL }, /* 171 */
+    { 0xA59BC234DB398C25ULL, 0x43FAB9837E699095ULL }, /* 172 */
+    { 0xCF02B2C21207EF2EULL, 0x94F967E45E03F4BBULL }, /* 173 */
+    { 0x8161AFB94B44F57DULL, 0x1D1BE0EEBAC278F5ULL }, /* 174 */
+    { 0xA1BA1BA79E1632DCULL, 0x6462D92A69731732ULL }, /* 175 */
+    { 0xCA28A291859BBF93ULL, 0x7D7B8F7503CFDCFEULL }, /* 176 */
+    { 0xFCB2CB35E702AF78ULL, 0x5CDA735244C3D43EULL }, /* 177 */
+    { 0x9DEFBF01B061ADABULL, 0x3A0888136AFA64A7ULL }, /* 178 */
+    { 0xC56BAEC21C7A1916ULL, 0x088AAA1845B8FDD0ULL }, /* 179 */
+    { 0xF6C69A72A3989F5BULL, 0x8AAD549E57273D45ULL }, /* 180 */
+    { 0x9A3C2087A63F6399ULL, 0x36AC54E2F678864BULL }, /* 181 */
+    { 0xC0CB28A98FCF3C7FULL, 0x84576A1BB416A7DDULL }, /* 182 */
+    { 0xF0FDF2D3F3C30B9FULL, 0x656D44A2A11C51D5ULL }, /* 183 */
+    { 0x969EB7C47859E743ULL, 0x9F644AE5A4B1B325ULL }, /* 184 */
+    { 0xBC4665B596706114ULL, 0x873D5D9F0DDE1FEEULL }, /* 185 */
+    { 0xEB57FF22FC0C7959ULL, 0xA90CB506D155A7EAULL }, /* 186 */
+    { 0x9316FF75DD87CBD8ULL, 0x09A7F12442D588F2ULL }, /* 187 */
+    { 0xB7DCBF5354E9BECEULL, 0x0C11ED6D538AEB2FULL }, /* 188 */
+    { 0xE5D3EF282A242E81ULL, 0x8F1668C8A86DA5FAULL }, /* 189 */
+    { 0x8FA475791A569D10ULL, 0xF96E017D694487BCULL }, /* 190 */
+    { 0xB38D92D760EC4455ULL, 0x37C981DCC395A9ACULL }, /* 191 */
+    { 0xE070F78D3927556AULL, 0x85BBE253F47B1417ULL }, /* 192 */
+    { 0x8C469AB843B89562ULL, 0x93956D7478CCEC8EULL }, /* 193 */
+    { 0xAF58416654A6BABBULL, 0x387AC8D1970027B2ULL }, /* 194 */
+    { 0xDB2E51BFE9D0696AULL, 0x06997B05FCC0319EULL }, /* 195 */
+    { 0x88FCF317F22241E2ULL, 0x441FECE3BDF81F03ULL }, /* 196 */
+    { 0xAB3C2FDDEEAAD25AULL, 0xD527E81CAD7626C3ULL }, /* 197 */
+    { 0xD60B3BD56A5586F1ULL, 0x8A71E223D8D3B074ULL }, /* 198 */
+    { 0x85C7056562757456ULL, 0xF6872D5667844E49ULL }, /* 199 */
+    { 0xA738C6BEBB12D16CULL, 0xB428F8AC016561DBULL }, /* 200 */
+    { 0xD106F86E69D785C7ULL, 0xE13336D701BEBA52ULL }, /* 201 */
+    { 0x82A45B450226B39CULL, 0xECC0024661173473ULL }, /* 202 */
+    { 0xA34D721642B06084ULL, 0x27F002D7F95D0190ULL }, /* 203 */
+    { 0xCC20CE9BD35C78A5ULL, 0x31EC038DF7B441F4ULL }, /* 204 */
+    { 0xFF290242C83396CEULL, 0x7E67047175A15271ULL }, /* 205 */
+    { 0x9F79A169BD203E41ULL, 0x0F0062C6E984D386ULL }, /* 206 */
+    { 0xC75809C42C684DD1ULL, 0x52C07B78A3E60868ULL }, /* 207 */
+    { 0xF92E0C3537826145ULL, 0xA7709A56CCDF8A82ULL }, /* 208 */
+    { 0x9BBCC7A142B17CCBULL, 0x88A66076400BB691ULL }, /* 209 */
+    { 0xC2ABF989935DDBFEULL, 0x6ACFF893D00EA435ULL }, /* 210 */
+    { 0xF356F7EBF83552FEULL, 0x0583F6B8C4124D43ULL }, /* 211 */
+    { 0x98165AF37B2153DEULL, 0xC3727A337A8B704AULL }, /* 212 */
+    { 0xBE1BF1B059E9A8D6ULL, 0x744F18C0592E4C5CULL }, /* 213 */
+    { 0xEDA2EE1C7064130CULL, 0x1162DEF06F79DF73ULL }, /* 214 */
+    { 0x9485D4D1C63E8BE7ULL, 0x8ADDCB5645AC2BA8ULL }, /* 215 */
+    { 0xB9A74A0637CE2EE1ULL, 0x6D953E2BD7173692ULL }, /* 216 */
+    { 0xE8111C87C5C1BA99ULL, 0xC8FA8DB6CCDD0437ULL }, /* 217 */
+    { 0x910AB1D4DB9914A0ULL, 0x1D9C9892400A22A2ULL }, /* 218 */
+    { 0xB54D5E4A127F59C8ULL, 0x2503BEB6D00CAB4BULL }, /* 219 */
+    { 0xE2A0B5DC971F303AULL, 0x2E44AE64840FD61DULL }, /* 220 */
+    { 0x8DA471A9DE737E24ULL, 0x5CEAECFED289E5D2ULL }, /* 221 */
+    { 0xB10D8E1456105DADULL, 0x7425A83E872C5F47ULL }, /* 222 */
+    { 0xDD50F1996B947518ULL, 0xD12F124E28F77719ULL }, /* 223 */
+    { 0x8A5296FFE33CC92FULL, 0x82BD6B70D99AAA6FULL }, /* 224 */
+    { 0xACE73CBFDC0BFB7BULL, 0x636CC64D1001550BULL }, /* 225 */
+    { 0xD8210BEFD30EFA5AULL, 0x3C47F7E05401AA4EULL }, /* 226 */
+    { 0x8714A775E3E95C78ULL, 0x65ACFAEC34810A71ULL }, /* 227 */
+    { 0xA8D9D1535CE3B396ULL, 0x7F1839A741A14D0DULL }, /* 228 */
+    { 0xD31045A8341CA07CULL, 0x1EDE48111209A050ULL }, /* 229 */
+    { 0x83EA2B892091E44DULL, 0x934AED0AAB460432ULL }, /* 230 */
+    { 0xA4E4B66B68B65D60ULL, 0xF81DA84D5617853FULL }, /* 231 */
+    { 0xCE1DE40642E3F4B9ULL, 0x36251260AB9D668EULL }, /* 232 */
+    { 0x80D2AE83E9CE78F3ULL, 0xC1D72B7C6B426019ULL }, /* 233 */
+    { 0xA1075A24E4421730ULL, 0xB24CF65B8612F81FULL }, /* 234 */
+    { 0xC94930AE1D529CFCULL, 0xDEE033F26797B627ULL }, /* 235 */
+    { 0xFB9B7CD9A4A7443CULL, 0x169840EF017DA3B1ULL }, /* 236 */
+    { 0x9D412E0806E88AA5ULL, 0x8E1F289560EE864EULL }, /* 237 */
+    { 0xC491798A08A2AD4EULL, 0xF1A6F2BAB92A27E2ULL }, /* 238 */
+    { 0xF5B5D7EC8ACB58A2ULL, 0xAE10AF696774B1DBULL }, /* 239 */
+    { 0x9991A6F3D6BF1765ULL, 0xACCA6DA1E0A8EF29ULL }, /* 240 */
+    { 0xBFF610B0CC6EDD3FULL, 0x17FD090A58D32AF3ULL }, /* 241 */
+    { 0xEFF394DCFF8A948EULL, 0xDDFC4B4CEF07F5B0ULL }, /* 242 */
+    { 0x95F83D0A1FB69CD9ULL, 0x4ABDAF101564F98EULL }, /* 243 */
+    { 0xBB764C4CA7A4440FULL, 0x9D6D1AD41ABE37F1ULL }, /* 244 */
+    { 0xEA53DF5FD18D5513ULL, 0x84C86189216DC5EDULL }, /* 245 */
+    { 0x92746B9BE2F8552CULL, 0x32FD3CF5B4E49BB4ULL }, /* 246 */
+    { 0xB7118682DBB66A77ULL, 0x3FBC8C33221DC2A1ULL }, /* 247 */
+    { 0xE4D5E82392A40515ULL, 0x0FABAF3FEAA5334AULL }, /* 248 */
+    { 0x8F05B1163BA6832DULL, 0x29CB4D87F2A7400EULL }, /* 249 */
+    { 0xB2C71D5BCA9023F8ULL, 0x743E20E9EF511012ULL }, /* 250 */
+    { 0xDF78E4B2BD342CF6ULL, 0x914DA9246B255416ULL }, /* 251 */
+    { 0x8BAB8EEFB6409C1AULL, 0x1AD089B6C2F7548EULL }, /* 252 */
+    { 0xAE9672ABA3D0C320ULL, 0xA184AC2473B529B1ULL }, /* 253 */
+    { 0xDA3C0F568CC4F3E8ULL, 0xC9E5D72D90A2741EULL }, /* 254 */
+    { 0x8865899617FB1871ULL, 0x7E2FA67C7A658892ULL }, /* 255 */
+    { 0xAA7EEBFB9DF9DE8DULL, 0xDDBB901B98FEEAB7ULL }, /* 256 */
+    { 0xD51EA6FA85785631ULL, 0x552A74227F3EA565ULL }, /* 257 */
+    { 0x8533285C936B35DEULL, 0xD53A88958F87275FULL }, /* 258 */
+    { 0xA67FF273B8460356ULL, 0x8A892ABAF368F137ULL }, /* 259 */
+    { 0xD01FEF10A657842CULL, 0x2D2B7569B0432D85ULL }, /* 260 */
+    { 0x8213F56A67F6B29BULL, 0x9C3B29620E29FC73ULL }, /* 261 */
+    { 0xA298F2C501F45F42ULL, 0x8349F3BA91B47B8FULL }, /* 262 */
+    { 0xCB3F2F7642717713ULL, 0x241C70A936219A73ULL }, /* 263 */
+    { 0xFE0EFB53D30DD4D7ULL, 0xED238CD383AA0110ULL }, /* 264 */
+    { 0x9EC95D1463E8A506ULL, 0xF4363804324A40AAULL }, /* 265 */
+    { 0xC67BB4597CE2CE48ULL, 0xB143C6053EDCD0D5ULL }, /* 266 */
+    { 0xF81AA16FDC1B81DAULL, 0xDD94B7868E94050AULL }, /* 267 */
+    { 0x9B10A4E5E9913128ULL, 0xCA7CF2B4191C8326ULL }, /* 268 */
+    { 0xC1D4CE1F63F57D72ULL, 0xFD1C2F611F63A3F0ULL }, /* 269 */
+    { 0xF24A01A73CF2DCCFULL, 0xBC633B39673C8CECULL }, /* 270 */
+    { 0x976E41088617CA01ULL, 0xD5BE0503E085D813ULL }, /* 271 */
+    { 0xBD49D14AA79DBC82ULL, 0x4B2D8644D8A74E18ULL }, /* 272 */
+    { 0xEC9C459D51852BA2ULL, 0xDDF8E7D60ED1219EULL }, /* 273 */
+    { 0x93E1AB8252F33B45ULL, 0xCABB90E5C942B503ULL }, /* 274 */
+    { 0xB8DA1662E7B00A17ULL, 0x3D6A751F3B936243ULL }, /* 275 */
+    { 0xE7109BFBA19C0C9DULL, 0x0CC512670A783AD4ULL }, /* 276 */
+    { 0x906A617D450187E2ULL, 0x27FB2B80668B24C5ULL }, /* 277 */
+    { 0xB484F9DC9641E9DAULL, 0xB1F9F660802DEDF6ULL }, /* 278 */
+    { 0xE1A63853BBD26451ULL, 0x5E7873F8A0396973ULL }, /* 279 */
+    { 0x8D07E33455637EB2ULL, 0xDB0B487B6423E1E8ULL }, /* 280 */
+    { 0xB049DC016ABC5E5FULL, 0x91CE1A9A3D2CDA62ULL }, /* 281 */
+    { 0xDC5C5301C56B75F7ULL, 0x7641A140CC7810FBULL }, /* 282 */
+    { 0x89B9B3E11B6329BAULL, 0xA9E904C87FCB0A9DULL }, /* 283 */
+    { 0xAC2820D9623BF429ULL, 0x546345FA9FBDCD44ULL }, /* 284 */
+    { 0xD732290FBACAF133ULL, 0xA97C177947AD4095ULL }, /* 285 */
+    { 0x867F59A9D4BED6C0ULL, 0x49ED8EABCCCC485DULL }, /* 286 */
+    { 0xA81F301449EE8C70ULL, 0x5C68F256BFFF5A74ULL }, /* 287 */
+    { 0xD226FC195C6A2F8CULL, 0x73832EEC6FFF3111ULL }, /* 288 */
+    { 0x83585D8FD9C25DB7ULL, 0xC831FD53C5FF7EABULL }, /* 289 */
+    { 0xA42E74F3D032F525ULL, 0xBA3E7CA8B77F5E55ULL }, /* 290 */
+    { 0xCD3A1230C43FB26FULL, 0x28CE1BD2E55F35EBULL }, /* 291 */
+    { 0x80444B5E7AA7CF85ULL, 0x7980D163CF5B81B3ULL }, /* 292 */
+    { 0xA0555E361951C366ULL, 0xD7E105BCC332621FULL }, /* 293 */
+    { 0xC86AB5C39FA63440ULL, 0x8DD9472BF3FEFAA7ULL }, /* 294 */
+    { 0xFA856334878FC150ULL, 0xB14F98F6F0FEB951ULL }, /* 295 */
+    { 0x9C935E00D4B9D8D2ULL, 0x6ED1BF9A569F33D3ULL }, /* 296 */
+    { 0xC3B8358109E84F07ULL, 0x0A862F80EC4700C8ULL }, /* 297 */
+    { 0xF4A642E14C6262C8ULL, 0xCD27BB612758C0FAULL }, /* 298 */
+    { 0x98E7E9CCCFBD7DBDULL, 0x8038D51CB897789CULL }, /* 299 */
+    { 0xBF21E44003ACDD2CULL, 0xE0470A63E6BD56C3ULL }, /* 300 */
+    { 0xEEEA5D5004981478ULL, 0x1858CCFCE06CAC74ULL }, /* 301 */
+    { 0x95527A5202DF0CCBULL, 0x0F37801E0C43EBC8ULL }, /* 302 */
+    { 0xBAA718E68396CFFDULL, 0xD30560258F54E6BAULL }, /* 303 */
+    { 0xE950DF20247C83FDULL, 0x47C6B82EF32A2069ULL }, /* 304 */
+    { 0x91D28B7416CDD27EULL, 0x4CDC331D57FA5441ULL }, /* 305 */
+    { 0xB6472E511C81471DULL, 0xE0133FE4ADF8E952ULL }, /* 306 */
+    { 0xE3D8F9E563A198E5ULL, 0x58180FDDD97723A6ULL }, /* 307 */
+    { 0x8E679C2F5E44FF8FULL, 0x570F09EAA7EA7648ULL }, /* 308 */
+    { 0xB201833B35D63F73ULL, 0x2CD2CC6551E513DAULL }, /* 309 */
+    { 0xDE81E40A034BCF4FULL, 0xF8077F7EA65E58D1ULL }, /* 310 */
+    { 0x8B112E86420F6191ULL, 0xFB04AFAF27FAF782ULL }, /* 311 */
+    { 0xADD57A27D29339F6ULL, 0x79C5DB9AF1F9B563ULL }, /* 312 */
+    { 0xD94AD8B1C7380874ULL, 0x18375281AE7822BCULL }, /* 313 */
+    { 0x87CEC76F1C830548ULL, 0x8F2293910D0B15B5ULL }, /* 314 */
+    { 0xA9C2794AE3A3C69AULL, 0xB2EB3875504DDB22ULL }, /* 315 */
+    { 0xD433179D9C8CB841ULL, 0x5FA60692A46151EBULL }, /* 316 */
+    { 0x849FEEC281D7F328ULL, 0xDBC7C41BA6BCD333ULL }, /* 317 */
+    { 0xA5C7EA73224DEFF3ULL, 0x12B9B522906C0800ULL }, /* 318 */
+    { 0xCF39E50FEAE16BEFULL, 0xD768226B34870A00ULL }, /* 319 */
+    { 0x81842F29F2CCE375ULL, 0xE6A1158300D46640ULL }, /* 320 */
+    { 0xA1E53AF46F801C53ULL, 0x60495AE3C1097FD0ULL }, /* 321 */
+    { 0xCA5E89B18B602368ULL, 0x385BB19CB14BDFC4ULL }, /* 322 */
+    { 0xFCF62C1DEE382C42ULL, 0x46729E03DD9ED7B5ULL }, /* 323 */
+    { 0x9E19DB92B4E31BA9ULL, 0x6C07A2C26A8346D1ULL }, /* 324 */
+    { 0xC5A05277621BE293ULL, 0xC7098B7305241885ULL }, /* 325 */
+    { 0xF70867153AA2DB38ULL, 0xB8CBEE4FC66D1EA7ULL }, /* 326 */
+};
 
-                        if (prev == NULL)
-                        {
-                            return NULL;
-                        }
+static const double js_pow10_exact_[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+struct js_num {
+    lz_json_ntype type;
+    union {
+        int64_t  i;
+        uint64_t u;
+        double   d;
+    };
+};
 
+static inline double
+js_double_from_bits_(uint64_t bits)
+{
+    double d;
 
-                        buf[0]         = '\0';
-                        buf_idx        = 0;
-                        state          = path_state_reading_array_end;
+    memcpy(&d, &bits, sizeof(d));
 
-                        break;
-                    default:
-                        buf[buf_idx++] = ch;
-                        buf[buf_idx]   = '\0';
-                        break;
-                } /* switch */
-                break;
-            case path_state_reading_array_end:
-                state = path_state_reading_key;
-                break;
-        }         /* switch */
+    return d;
+}
 
-        if (ch == '\0')
-        {
-            break;
-        }
-    }
+static inline uint64_t
+js_double_to_bits_(double d)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &d, sizeof(bits));
 
-    return (prev != js) ? prev : NULL;
-} /* js_get_path_ */
+    return bits;
+}
 
+/* man * 10^exp10 rounded to the nearest double, returns -1 if that cannot be
+ * decided from the 128-bit approximation.
+ */
 static int
-js_add_(lz_json * obj, const char * key, lz_json * val)
+js_eisel_lemire_(uint64_t man, int exp10, bool neg, double * out)
 {
-    if (obj == NULL)
+    unsigned __int128 x;
+    unsigned __int128 y;
+    uint64_t          x_hi;
+    uint64_t          x_lo;
+    uint64_t          merged_hi;
+    uint64_t          merged_lo;
+    uint64_t          ret_man;
+    uint64_t          ret_exp2;
+    uint64_t          msb;
+    int               clz;
+
+    if (man == 0)
+    {
+        *out = neg ? -0.0 : 0.0;
+        return 0;
+    }
+
+    if (exp10 < JS_POW10_MIN || exp10 > 308)
     {
         return -1;
     }
 
-    if (key == NULL)
+    clz      = __builtin_clzll(man);
+    man    <<= clz;
+    ret_exp2 = (uint64_t)((((int64_t)217706 * exp10) >> 16) + 64 + 1023) - (uint64_t)clz;
+
+    x        = (unsigned __int128)man * js_pow10_[exp10 - JS_POW10_MIN].hi;
+    x_hi     = (uint64_t)(x >> 64);
+    x_lo     = (uint64_t)x;
+
+    /* the low bits are all ones, so the part of the product left out of the
+     * approximation may carry into the bits we keep.
+     */
+    if ((x_hi & 0x1FF) == 0x1FF && x_lo + man < man)
     {
-        if (obj->type != lz_json_vtype_array)
+        y         = (unsigned __int128)man * js_pow10_[exp10 - JS_POW10_MIN].lo;
+        merged_hi = x_hi;
+        merged_lo = x_lo + (uint64_t)(y >> 64);
+
+        if (merged_lo < x_lo)
+        {
+            merged_hi++;
+        }
+
+        if ((merged_hi & 0x1FF) == 0x1FF && merged_lo + 1 == 0 && (uint64_t)y + man < man)
         {
             return -1;
         }
 
-        return js_array_add_(obj, val);
+        x_hi = merged_hi;
+        x_lo = merged_lo;
     }
 
-    return js_object_add_(obj, key, val);
-}
-
-static int
-js_addbuf_vprintf_(struct __jbuf * jbuf, const char * fmt, va_list ap)
-{
-    char tmpbuf[jbuf->buf_len - jbuf->buf_idx];
-    int  sres;
+    msb       = x_hi >> 63;
+    ret_man   = x_hi >> (msb + 9);
+    ret_exp2 -= 1 ^ msb;
 
-    if (lz_unlikely(jbuf == NULL))
+    /* exactly half way between two doubles */
+    if (x_lo == 0 && (x_hi & 0x1FF) == 0 && (ret_man & 3) == 1)
     {
         return -1;
     }
 
-    sres = vsnprintf(tmpbuf, sizeof(tmpbuf), fmt, ap);
+    ret_man += ret_man & 1;
+    ret_man >>= 1;
+
+    if (ret_man >> 53)
+    {
+        ret_man >>= 1;
+        ret_exp2 += 1;
+    }
 
-    if (sres >= sizeof(tmpbuf) || sres < 0)
+    /* subnormals, infinities */
+    if (ret_exp2 - 1 >= 0x7FF - 1)
     {
         return -1;
     }
 
-    return js_addbuf_(jbuf, tmpbuf, (size_t)sres);
-}
+    *out = js_double_from_bits_((ret_exp2 << 52) | (ret_man & 0x000FFFFFFFFFFFFFULL) |
+                                (neg ? 0x8000000000000000ULL : 0));
 
-static int
-js_addbuf_printf_(struct __jbuf * jbuf, const char * fmt, ...)
+    return 0;
+} /* js_eisel_lemire_ */
+
+/* the slow path: hands every digit to strtod(), written without a decimal
+ * point so the locale does not matter.
+ */
+static double
+js_strtod_(const char * data, size_t len, int64_t exp10)
 {
-    va_list ap;
-    int     sres;
+    char   sbuf[256];
+    char * buf;
+    size_t i;
+    size_t n;
+    double d;
 
-    if (lz_unlikely(jbuf == NULL))
+    buf = (len + 32 <= sizeof(sbuf)) ? sbuf : malloc(len + 32);
+
+    if (buf == NULL)
     {
-        return -1;
+        return NAN;
     }
 
-    va_start(ap, fmt);
+    for (i = 0, n = 0; i < len; i++)
     {
-        sres = js_addbuf_vprintf_(jbuf, fmt, ap);
+        if (isdigit((unsigned char)data[i]) || data[i] == '-')
+        {
+            buf[n++] = data[i];
+        }
+    }
+
+    snprintf(&buf[n], 32, "e%lld", (long long)exp10);
+
+    d = strtod(buf, NULL);
+
+    if (buf != sbuf)
+    {
+        free(buf);
     }
-    va_end(ap);
 
-    return sres;
+    return d;
 }
 
-static int
-js_addbuf_(struct __jbuf * jbuf, const char * buf, size_t len)
+/* parses the JSON number at the start of `data`, returns the number of bytes
+ * it is made of, or -1 if there is none.
+ */
+static ssize_t
+js_num_parse_(const char * data, size_t len, struct js_num * num)
 {
-    if (lz_unlikely(jbuf == NULL))
+    const char * p;
+    const char * end;
+    const char * mant_end;
+    uint64_t     man;
+    uint64_t     ival;
+    int64_t      exp10;
+    int64_t      exp_part;
+    int64_t      nfrac;
+    int          ndigits;
+    bool         neg;
+    bool         exp_neg;
+    bool         truncated;
+    double       d;
+    double       d_up;
+
+    p         = data;
+    end       = data + len;
+    man       = 0;
+    exp10     = 0;
+    exp_part  = 0;
+    nfrac     = 0;
+    ndigits   = 0;
+    neg       = false;
+    truncated = false;
+
+    if (p < end && *p == '-')
     {
-        return -1;
+        neg = true;
+        p++;
     }
 
-    if (len == 0 || buf == NULL)
+    if (p == end || !isdigit((unsigned char)*p))
     {
-        return 0;
+        return -1;
     }
 
-    if ((jbuf->buf_idx + len) > jbuf->buf_len)
+    /* no leading zeros */
+    if (*p == '0')
     {
-        /* should we allocate this buffer ourselves? If so, let it roll! */
-        if (jbuf->dynamic == 1)
+        p++;
+    } else {
+        for (; p < end && isdigit((unsigned char)*p); p++)
         {
-            /* give daddy a little more memory, just one memory */
-            jbuf->buf = realloc(jbuf->buf, (size_t)(jbuf->buf_len + len + 32));
-
-            if (lz_unlikely(jbuf->buf == NULL))
+            if (ndigits < 19)
             {
-                return -1;
+                man = man * 10 + (uint64_t)(*p - '0');
+                ndigits++;
+            } else {
+                truncated |= (*p != '0');
+                exp10++;
             }
+        }
+    }
 
-            jbuf->buf_len += len + 32;
-        } else {
+    mant_end = p;
+
+    if (p < end && *p == '.')
+    {
+        p++;
+
+        if (p == end || !isdigit((unsigned char)*p))
+        {
             return -1;
         }
+
+        for (; p < end && isdigit((unsigned char)*p); p++, nfrac++)
+        {
+            if (ndigits < 19)
+            {
+                man = man * 10 + (uint64_t)(*p - '0');
+                exp10--;
+
+                /* leading zeros are not significant */
+                if (man != 0)
+                {
+                    ndigits++;
+                }
+            } else {
+                truncated |= (*p != '0');
+            }
+        }
     }
 
-    memcpy(&jbuf->buf[jbuf->buf_idx], buf, len);
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        exp_neg = false;
+        p++;
 
-    jbuf->buf_idx += len;
-    jbuf->written += len;
+        if (p < end && (*p == '+' || *p == '-'))
+        {
+            exp_neg = (*p == '-');
+            p++;
+        }
 
-    return 0;
-}
+        if (p == end || !isdigit((unsigned char)*p))
+        {
+            return -1;
+        }
 
-static const char digits[] =
-    "0001020304050607080910111213141516171819"
-    "2021222324252627282930313233343536373839"
-    "4041424344454647484950515253545556575859"
-    "6061626364656667686970717273747576777879"
-    "8081828384858687888990919293949596979899";
+        for (; p < end && isdigit((unsigned char)*p); p++)
+        {
+            /* anything past this is zero or infinity anyway */
+            if (exp_part < 100000)
+            {
+                exp_part = exp_part * 10 + (*p - '0');
+            }
+        }
 
-static int
-js_addbuf_number_(struct __jbuf * jbuf, unsigned int num)
-{
-    char     buf[32]; /* 18446744073709551615 64b, 20 characters */
-    char   * buffer          = (char *)buf;
-    char   * buffer_end      = buffer + 32;
-    char   * buffer_end_save = buffer + 32;
-    unsigned index;
+        if (exp_neg == true)
+        {
+            exp_part = -exp_part;
+        }
 
-    if (lz_unlikely(jbuf == NULL))
-    {
-        return -1;
+        exp10 += exp_part;
     }
 
-    *--buffer_end = '\0';
-
-    while (num >= 100)
+    if (p == mant_end)
     {
-        index         = (num % 100) * 2;
-        num          /= 100;
+        /* an integer; ndigits stops counting at 19, but 20 digits may fit */
+        for (ival = 0, p = data + neg; p < mant_end; p++)
+        {
+            if (__builtin_mul_overflow(ival, 10, &ival) ||
+                __builtin_add_overflow(ival, (uint64_t)(*p - '0'), &ival))
+            {
+                break;
+            }
+        }
+
+        if (p == mant_end && (neg == false || ival <= (uint64_t)INT64_MAX + 1))
+        {
+            if (neg == true)
+            {
+                num->type = lz_json_ntype_int;
+                num->i    = (int64_t)(0 - ival);
+            } else if (ival <= INT64_MAX)
+            {
+                num->type = lz_json_ntype_int;
+                num->i    = (int64_t)ival;
+            } else {
+                num->type = lz_json_ntype_uint;
+                num->u    = ival;
+            }
+
+            return (ssize_t)(mant_end - data);
+        }
 
-        *--buffer_end = digits[index + 1];
-        *--buffer_end = digits[index];
+        p = mant_end;
     }
 
-    if (num < 10)
+    num->type = lz_json_ntype_double;
+
+    if (truncated == false && man <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+        d      = (double)man;
+        d      = (exp10 < 0) ? d / js_pow10_exact_[-exp10] : d * js_pow10_exact_[exp10];
+        num->d = neg ? -d : d;
+    } else if (truncated == false && js_eisel_lemire_(man, (int)exp10, neg, &d) == 0)
     {
-        *--buffer_end = (char)('0' + num);
+        num->d = d;
+    } else if (truncated == true &&
+               js_eisel_lemire_(man, (int)exp10, neg, &d) == 0 &&
+               js_eisel_lemire_(man + 1, (int)exp10, neg, &d_up) == 0 && d == d_up)
+    {
+        /* the digits which did not fit cannot change the result */
+        num->d = d;
     } else {
-        index         = (unsigned)(num * 2);
-
-        *--buffer_end = digits[index + 1];
-        *--buffer_end = digits[index];
+        num->d = js_strtod_(data, (size_t)(mant_end - data) + (nfrac ? nfrac + 1 : 0),
+                            exp_part - nfrac);
     }
 
-    return js_addbuf_(jbuf, buffer_end,
-                      (size_t)(buffer_end_save - buffer_end - 1));
+    return (ssize_t)(p - data);
+} /* js_num_parse_ */
+
+static inline uint64_t
+js_round_to_odd_(uint64_t g_hi, uint64_t g_lo, uint64_t cp)
+{
+    unsigned __int128 x = (unsigned __int128)g_lo * cp;
+    unsigned __int128 y = (unsigned __int128)g_hi * cp + (uint64_t)(x >> 64);
+
+    return (uint64_t)(y >> 64) | ((uint64_t)y > 1);
 }
 
-static int
-js_number_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+/* finds the shortest `*dec` * 10^`*exp10` which reads back as the positive,
+ * finite and non-zero double `d`, choosing the closest one on a tie.
+ */
+static void
+js_schubfach_(double d, uint64_t * dec, int * exp10)
 {
-    if (json->type != lz_json_vtype_number)
+    uint64_t bits;
+    uint64_t ieee_man;
+    uint64_t ieee_exp;
+    uint64_t c;
+    uint64_t g_hi;
+    uint64_t g_lo;
+    uint64_t vbl;
+    uint64_t vb;
+    uint64_t vbr;
+    uint64_t lower;
+    uint64_t upper;
+    uint64_t s;
+    uint64_t sp;
+    int32_t  q;
+    int32_t  k;
+    int32_t  h;
+    bool     even;
+    bool     closer;
+    bool     u_in;
+    bool     w_in;
+
+    bits     = js_double_to_bits_(d);
+    ieee_man = bits & 0x000FFFFFFFFFFFFFULL;
+    ieee_exp = (bits >> 52) & 0x7FF;
+
+    if (ieee_exp != 0)
     {
-        return -1;
+        c = ieee_man | (1ULL << 52);
+        q = (int32_t)ieee_exp - 1075;
+
+        /* integers below 2^53 are exact */
+        if (q <= 0 && q > -53 && (c & ((1ULL << -q) - 1)) == 0)
+        {
+            *dec   = c >> -q;
+            *exp10 = 0;
+            goto trim;
+        }
+    } else {
+        c = ieee_man;
+        q = 1 - 1075;
     }
 
-    return js_addbuf_number_(jbuf, json->number);
-}
+    even   = (c & 1) == 0;
+    closer = (ieee_man == 0 && ieee_exp > 1);
 
-static int
-js_escape_string_(const char * str, size_t len, struct __jbuf * jbuf)
-{
-    unsigned char ch;
-    size_t        i;
+    /* k = floor(log10(2^q)), or of 3/4 * 2^q when the gap below is smaller */
+    k      = (q * 1262611 - (closer ? 524031 : 0)) >> 22;
+    h      = q + ((-k * 1741647) >> 19) + 1;
 
-    if (lz_unlikely(str == NULL || jbuf == NULL))
+    /* the table is rounded down, this wants it rounded up */
+    g_hi   = js_pow10_[-k - JS_POW10_MIN].hi;
+    g_lo   = js_pow10_[-k - JS_POW10_MIN].lo + 1;
+    g_hi  += (g_lo == 0);
+
+    vbl    = js_round_to_odd_(g_hi, g_lo, (4 * c - 2 + closer) << h);
+    vb     = js_round_to_odd_(g_hi, g_lo, (4 * c) << h);
+    vbr    = js_round_to_odd_(g_hi, g_lo, (4 * c + 2) << h);
+
+    lower  = vbl + !even;
+    upper  = vbr - !even;
+    s      = vb / 4;
+
+    if (s >= 10)
     {
-        return -1;
+        sp   = s / 10;
+        u_in = lower <= 40 * sp;
+        w_in = 40 * sp + 40 <= upper;
+
+        if (u_in != w_in)
+        {
+            *dec   = sp + w_in;
+            *exp10 = k + 1;
+            goto trim;
+        }
     }
 
-    for (i = 0; i < len; i++)
+    u_in = lower <= 4 * s;
+    w_in = 4 * s + 4 <= upper;
+
+    if (u_in != w_in)
     {
-        ch = str[i];
+        *dec   = s + w_in;
+        *exp10 = k;
+        goto trim;
+    }
 
-        switch (ch) {
-            default:
-                if (js_addbuf_(jbuf, (const char *)&ch, 1) == -1)
-                {
-                    return -1;
-                }
-
-                break;
-            case '\n':
-                if (js_addbuf_(jbuf, "\\n", 2) == -1)
-                {
-                    return -1;
-                }
+    *dec   = s + (vb > 4 * s + 2 || (vb == 4 * s + 2 && (s & 1)));
+    *exp10 = k;
 
-                break;
-            case '"':
-                if (js_addbuf_(jbuf, "\\\"", 2) == -1)
-                {
-                    return -1;
-                }
-                break;
-            case '\t':
-                if (js_addbuf_(jbuf, "\\t", 2) == -1)
-                {
-                    return -1;
-                }
-                break;
-            case '\r':
-                if (js_addbuf_(jbuf, "\\r", 2) == -1)
-                {
-                    return -1;
-                }
-                break;
-            case '\\':
-                if (js_addbuf_(jbuf, "\\\\", 2) == -1)
-                {
-                    return -1;
-                }
-                break;
-        } /* switch */
+trim:
+    while (*dec % 10 == 0)
+    {
+        *dec   /= 10;
+        *exp10 += 1;
     }
+} /* js_schubfach_ */
 
-    return 0;
-}         /* js_escape_string_ */
+/* converts a number to another type, clamping values which are out of range */
+static int64_t
+js_num_int_(struct js_num * num)
+{
+    switch (num->type) {
+        case lz_json_ntype_int:
+            return num->i;
+        case lz_json_ntype_uint:
+            return (num->u > INT64_MAX) ? INT64_MAX : (int64_t)num->u;
+        default:
+            if (num->d != num->d)
+            {
+                return 0;
+            }
 
-static int
-js_string_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+            if (num->d >= 9223372036854775807.0)
+            {
+                return INT64_MAX;
+            }
+
+            if (num->d <= -9223372036854775808.0)
+            {
+                return INT64_MIN;
+            }
+
+            return (int64_t)num->d;
+    }
+}
+
+static uint64_t
+js_num_uint_(struct js_num * num)
 {
-    const char * str;
+    switch (num->type) {
+        case lz_json_ntype_int:
+            return (num->i < 0) ? 0 : (uint64_t)num->i;
+        case lz_json_ntype_uint:
+            return num->u;
+        default:
+            if (!(num->d > 0))
+            {
+                return 0;
+            }
 
-    if (lz_unlikely(json == NULL))
-    {
-        return -1;
+            if (num->d >= 18446744073709551615.0)
+            {
+                return UINT64_MAX;
+            }
+
+            return (uint64_t)num->d;
     }
+}
 
-    if (json->type != lz_json_vtype_string)
-    {
-        return -1;
+static double
+js_num_double_(struct js_num * num)
+{
+    switch (num->type) {
+        case lz_json_ntype_int:
+            return (double)num->i;
+        case lz_json_ntype_uint:
+            return (double)num->u;
+        default:
+            return num->d;
     }
+}
 
-    str = json->string;
+static lz_json *
+js_num_new_(struct js_num * num)
+{
+    lz_json * js;
 
-    if ((str = json->string) == NULL)
+    if (!(js = js_new_(lz_json_vtype_number)))
     {
-        return -1;
+        return NULL;
     }
 
-    if (js_addbuf_(jbuf, "\"", 1) == -1)
-    {
-        return -1;
+    switch (num->type) {
+        case lz_json_ntype_uint:
+            js->uinteger = num->u;
+            js->flags   |= JS_F_NUM_UINT;
+            break;
+        case lz_json_ntype_double:
+            js->real     = num->d;
+            js->flags   |= JS_F_NUM_DOUBLE;
+            break;
+        default:
+            js->integer  = num->i;
+            break;
     }
 
-    if (jbuf->escape == true)
+    return js;
+}
+
+static lz_json *
+js_int_new_(int64_t val)
+{
+    struct js_num num = { .type = lz_json_ntype_int, .i = val };
+
+    return js_num_new_(&num);
+}
+
+static lz_json *
+js_uint_new_(uint64_t val)
+{
+    struct js_num num = { .type = lz_json_ntype_uint, .u = val };
+
+    if (val <= INT64_MAX)
     {
-        if (js_escape_string_(str, json->slen, jbuf) == -1)
-        {
-            return -1;
-        }
+        num.type = lz_json_ntype_int;
     }
 
-    return js_addbuf_(jbuf, "\"", 1);
+    return js_num_new_(&num);
+}
+
+static lz_json *
+js_double_new_(double val)
+{
+    struct js_num num = { .type = lz_json_ntype_double, .d = val };
+
+    return js_num_new_(&num);
+}
+
+static lz_json *
+js_number_new_(unsigned int val)
+{
+    return js_int_new_((int64_t)val);
 }
 
 static int
-js_boolean_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+js_get_num_(lz_json * js, struct js_num * num)
 {
-    if (lz_unlikely(json == NULL))
+    if (lz_unlikely(js == NULL || js->type != lz_json_vtype_number))
     {
         return -1;
     }
 
-    if (json->type != lz_json_vtype_bool)
+    if (js->flags & JS_F_NUM_DOUBLE)
     {
-        return -1;
+        num->type = lz_json_ntype_double;
+        num->d    = js->real;
+    } else if (js->flags & JS_F_NUM_UINT)
+    {
+        num->type = lz_json_ntype_uint;
+        num->u    = js->uinteger;
+    } else {
+        num->type = lz_json_ntype_int;
+        num->i    = js->integer;
     }
 
-    return js_addbuf_printf_(jbuf, "%s",
-                             js_get_boolean_(json) == true ? "true" : "false");
+    return 0;
 }
 
-static int
-js_null_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+static lz_json_ntype
+js_get_number_type_(lz_json * js)
 {
-    if (lz_unlikely(json == NULL))
+    struct js_num num;
+
+    if (js_get_num_(js, &num) == -1)
     {
         return -1;
     }
 
-    if (json->type != lz_json_vtype_null)
+    return num.type;
+}
+
+static int64_t
+js_get_int_(lz_json * js)
+{
+    struct js_num num;
+
+    if (js_get_num_(js, &num) == -1)
     {
-        return -1;
+        return 0;
     }
 
-    return js_addbuf_printf_(jbuf, "null");
+    return js_num_int_(&num);
 }
 
-static int
-js_array_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+static uint64_t
+js_get_uint_(lz_json * js)
 {
-    lz_tailq      * array;
-    lz_tailq_elem * elem;
-    lz_tailq_elem * temp;
+    struct js_num num;
 
-    if (lz_unlikely(!json || !jbuf))
+    if (js_get_num_(js, &num) == -1)
     {
-        return -1;
+        return 0;
     }
 
-    if (json->type != lz_json_vtype_array)
+    return js_num_uint_(&num);
+}
+
+static double
+js_get_double_(lz_json * js)
+{
+    struct js_num num;
+
+    if (js_get_num_(js, &num) == -1)
     {
-        return -1;
+        return 0;
     }
 
-    array = json->array;
+    return js_num_double_(&num);
+}
 
-    if (js_addbuf_(jbuf, "[", 1) == -1)
+static unsigned int
+js_get_number_(lz_json * js)
+{
+    return (unsigned int)js_get_int_(js);
+}
+
+static lz_json *
+js_boolean_new_(bool boolean)
+{
+    lz_json * js;
+
+    if (!(js = js_new_(lz_json_vtype_bool)))
     {
-        return -1;
+        return NULL;
     }
 
-    for (elem = lz_tailq_first(array); elem; elem = temp)
-    {
-        lz_json * val;
+    js->boolean = boolean;
 
-        if (!(val = (lz_json *)lz_tailq_elem_data(elem)))
-        {
-            return -1;
-        }
+    return js;
+}
 
-        if (js_json_to_buffer_(val, jbuf) == -1)
-        {
-            return -1;
-        }
+static lz_json *
+js_null_new_(void)
+{
+    return js_new_(lz_json_vtype_null);
+}
 
-        if ((temp = lz_tailq_next(elem)))
-        {
-            if (js_addbuf_(jbuf, ",", 1) == -1)
-            {
-                return -1;
-            }
-        }
-    }
+/* 32-bit FNV-1a */
+static inline uint32_t
+js_hash_(const char * key, size_t len)
+{
+    uint32_t hash = 2166136261U;
+    size_t   i;
 
-    if (js_addbuf_(jbuf, "]", 1) == -1)
+    for (i = 0; i < len; i++)
     {
-        return -1;
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619U;
     }
 
-    return 0;
-} /* js_array_to_buffer_ */
+    return hash;
+}
 
-static int
-js_object_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+/* key interning: a table of keys which documents with a recurring schema
+ * can share instead of each object holding copies. A shared key is stored
+ * after its hash and length, and lives as long as the table does.
+ */
+#define JS_KEYS_SLOTS_MIN 256
+#define JS_KEYS_MAX       65536 /* the default number of keys a table takes */
+#define JS_KEYS_KLEN_MAX  256   /* longer keys are never interned */
+
+struct js_key {
+    uint32_t hash;
+    uint32_t len;
+    char     str[];
+};
+
+#define JS_KEY_OF(s) ((const struct js_key *)((s) - offsetof(struct js_key, str)))
+
+struct lz_json_keys_s {
+    struct js_arena * arena;
+    struct js_key  ** slots;
+    uint32_t          mask;
+    uint32_t          len;
+    uint32_t          max;
+};
+
+static lz_json_keys *
+js_keys_new_(size_t max_keys)
 {
-    lz_kvmap     * object;
-    lz_kvmap_ent * ent;
-    lz_kvmap_ent * temp;
+    lz_json_keys * keys;
 
-    if (lz_unlikely(json == NULL))
+    if (!(keys = calloc(1, sizeof(*keys))))
     {
-        return -1;
+        return NULL;
     }
 
-    if (json->type != lz_json_vtype_object)
+    keys->arena = js_arena_new_();
+    keys->slots = calloc(JS_KEYS_SLOTS_MIN, sizeof(struct js_key *));
+    keys->mask  = JS_KEYS_SLOTS_MIN - 1;
+    keys->max   = (max_keys == 0 || max_keys > UINT32_MAX / 4) ? JS_KEYS_MAX : (uint32_t)max_keys;
+
+    if (keys->arena == NULL || keys->slots == NULL)
     {
-        return -1;
+        js_arena_free_(keys->arena);
+        free(keys->slots);
+        free(keys);
+        return NULL;
     }
 
-    object = json->object;
+    return keys;
+}
 
-    if (js_addbuf_(jbuf, "{", 1) == -1)
+static void
+js_keys_free_(lz_json_keys * keys)
+{
+    if (keys == NULL)
     {
-        return -1;
+        return;
     }
 
-    for (ent = lz_kvmap_first(object); ent; ent = temp)
+    js_arena_free_(keys->arena);
+    free(keys->slots);
+    free(keys);
+}
+
+/* doubles the slots, keeping them at most half full */
+static int
+js_keys_grow_(lz_json_keys * keys)
+{
+    struct js_key ** slots;
+    uint32_t         mask;
+    uint32_t         slot;
+    uint32_t         i;
+
+    mask = keys->mask * 2 + 1;
+
+    if (!(slots = calloc((size_t)mask + 1, sizeof(struct js_key *))))
     {
-        const char * key;
-        lz_json    * val;
+        return -1;
+    }
 
-        if (!(key = lz_kvmap_ent_key(ent)))
+    for (i = 0; i <= keys->mask; i++)
+    {
+        if (keys->slots[i] == NULL)
         {
-            return -1;
+            continue;
         }
 
-        if (!(val = (lz_json *)lz_kvmap_ent_val(ent)))
+        for (slot = keys->slots[i]->hash & mask; slots[slot] != NULL; slot = (slot + 1) & mask)
         {
-            return -1;
+            ;
         }
 
-        if (js_addbuf_(jbuf, "\"", 1) == -1)
-        {
-            return -1;
-        }
+        slots[slot] = keys->slots[i];
+    }
 
-        if (js_addbuf_(jbuf, key, lz_kvmap_ent_get_klen(ent)) == -1)
-        {
-            return -1;
-        }
+    free(keys->slots);
 
-        if (js_addbuf_(jbuf, "\":", 2) == -1)
+    keys->slots = slots;
+    keys->mask  = mask;
+
+    return 0;
+}
+
+/* returns the shared copy of `key`, adding it if there is room, or NULL if
+ * the key is to be copied as usual.
+ */
+static const char *
+js_keys_intern_(lz_json_keys * keys, const char * key, size_t klen)
+{
+    struct js_key * ent;
+    uint32_t        hash;
+    uint32_t        slot;
+
+    if (klen > JS_KEYS_KLEN_MAX)
+    {
+        return NULL;
+    }
+
+    hash = js_hash_(key, klen);
+
+    for (slot = hash & keys->mask; (ent = keys->slots[slot]) != NULL; slot = (slot + 1) & keys->mask)
+    {
+        if (ent->hash == hash && ent->len == klen && !memcmp(ent->str, key, klen))
         {
-            return -1;
+            return ent->str;
         }
+    }
+
+    if (keys->len == keys->max)
+    {
+        return NULL;
+    }
 
-        if (js_json_to_buffer_(val, jbuf) == -1)
+    if ((keys->len + 1) * 2 > keys->mask + 1)
+    {
+        if (js_keys_grow_(keys) == -1)
         {
-            return -1;
+            return NULL;
         }
 
-        if ((temp = lz_kvmap_next(ent)))
+        for (slot = hash & keys->mask; keys->slots[slot] != NULL; slot = (slot + 1) & keys->mask)
         {
-            if (js_addbuf_(jbuf, ",", 1) == -1)
-            {
-                return -1;
-            }
+            ;
         }
     }
 
-    if (js_addbuf_(jbuf, "}", 1) == -1)
+    if (!(ent = js_arena_alloc_(keys->arena, sizeof(*ent) + klen + 1)))
     {
-        return -1;
+        return NULL;
     }
 
-    return 0;
-} /* js_object_to_buffer_ */
+    ent->hash = hash;
+    ent->len  = (uint32_t)klen;
 
-static lz_json *
-js_parse_value_(const char * data, size_t len, size_t * n_read)
+    memcpy(ent->str, key, klen);
+    ent->str[klen] = '\0';
+
+    keys->slots[slot] = ent;
+    keys->len        += 1;
+
+    return ent->str;
+} /* js_keys_intern_ */
+
+static void
+js_index_insert_(uint32_t * index, uint32_t mask, uint32_t hash, uint32_t i)
 {
-    if (data == NULL || len == 0)
+    uint32_t slot;
+
+    for (slot = hash & mask; index[slot] != 0; slot = (slot + 1) & mask)
     {
-        return NULL;
+        ;
     }
 
-    switch (data[0]) {
-        case '"':
-            return js_parse_string_(data, len, n_read);
+    index[slot] = i + 1;
+}
+
+static void
+js_object_index_insert_(struct js_object * obj, uint32_t i)
+{
+    js_index_insert_(obj->index, obj->mask, obj->entries[i].hash, i);
+}
+
+/* (re)builds the index for the object's current capacity, which keeps it at
+ * most half full.
+ */
+static int
+js_object_reindex_(lz_json * js)
+{
+    struct js_object * obj = js->object;
+    uint32_t         * index;
+    uint32_t           size;
+    uint32_t           i;
+
+    for (size = 16; size < obj->cap * 2; size *= 2)
+    {
+        ;
+    }
+
+    if (!(index = js_node_alloc_(js, size * sizeof(uint32_t))))
+    {
+        return -1;
+    }
+
+    memset(index, 0, size * sizeof(uint32_t));
+
+    if (obj->index == NULL)
+    {
+        for (i = 0; i < obj->len; i++)
+        {
+            if (!obj->entries[i].shared)
+            {
+                obj->entries[i].hash = js_hash_(obj->entries[i].key, obj->entries[i].klen);
+            }
+        }
+    } else if (!(js->flags & JS_F_ARENA))
+    {
+        free(obj->index);
+    }
+
+    obj->index = index;
+    obj->mask  = size - 1;
+
+    for (i = 0; i < obj->len; i++)
+    {
+        js_object_index_insert_(obj, i);
+    }
+
+    return 0;
+}
+
+static int
+js_object_grow_(lz_json * js)
+{
+    struct js_object * obj = js->object;
+    struct js_object * nobj;
+    size_t             size;
+
+    size = sizeof(*obj) + (size_t)obj->cap * 2 * sizeof(struct js_entry);
+
+    if (js->flags & JS_F_ARENA)
+    {
+        if (!(nobj = js_arena_alloc_(js->arena, size)))
+        {
+            return -1;
+        }
+
+        memcpy(nobj, obj, sizeof(*obj) + obj->len * sizeof(struct js_entry));
+    } else if (!(nobj = realloc(obj, size)))
+    {
+        return -1;
+    }
+
+    nobj->cap *= 2;
+    js->object = nobj;
+
+    if (nobj->index != NULL && js_object_reindex_(js) == -1)
+    {
+        /* the old index is too small for the new capacity, fall back to
+         * searching linearly until the next rebuild.
+         */
+        if (!(js->flags & JS_F_ARENA))
+        {
+            free(nobj->index);
+        }
+
+        nobj->index = NULL;
+    }
+
+    return 0;
+} /* js_object_grow_ */
+
+/* returns the number of `key` among the first `len` of `keys`, or -1. `hash`
+ * is only looked at if there is an index.
+ */
+static ssize_t
+js_entries_find_(const struct js_entry * keys, uint32_t len, const uint32_t * index, uint32_t mask,
+                 const char * key, size_t klen, uint32_t hash)
+{
+    const struct js_entry * ent;
+    uint32_t                slot;
+    uint32_t                i;
+
+    if (index == NULL)
+    {
+        for (i = 0; i < len; i++)
+        {
+            ent = &keys[i];
+
+            if (ent->klen == klen && !memcmp(ent->key, key, klen))
+            {
+                return (ssize_t)i;
+            }
+        }
+
+        return -1;
+    }
+
+    for (slot = hash & mask; index[slot] != 0; slot = (slot + 1) & mask)
+    {
+        i   = index[slot] - 1;
+        ent = &keys[i];
+
+        if (ent->hash == hash && ent->klen == klen && (ent->key == key || !memcmp(ent->key, key, klen)))
+        {
+            /* the index of a shape covers keys its objects may not have */
+            return (i < len) ? (ssize_t)i : -1;
+        }
+    }
+
+    return -1;
+}
+
+/* returns the entry number of `key`, or -1. `hash` is only looked at if the
+ * object has an index.
+ */
+static ssize_t
+js_object_find_hashed_(struct js_object * obj, const char * key, size_t klen, uint32_t hash)
+{
+    if (obj->shape != NULL)
+    {
+        return js_entries_find_(obj->shape->keys, obj->len, obj->shape->index,
+                                obj->shape->mask, key, klen, hash);
+    }
+
+    return js_entries_find_(obj->entries, obj->len, obj->index, obj->mask, key, klen, hash);
+}
+
+/* returns the entry number of `key`, or -1 */
+static ssize_t
+js_object_find_(struct js_object * obj, const char * key, size_t klen)
+{
+    const uint32_t * index = obj->shape ? obj->shape->index : obj->index;
+
+    return js_object_find_hashed_(obj, key, klen, index ? js_hash_(key, klen) : 0);
+}
+
+static lz_json *
+js_object_find_val_(lz_json * js, const char * key, size_t klen)
+{
+    ssize_t i;
+
+    if (lz_unlikely(js == NULL || key == NULL || js->type != lz_json_vtype_object) ||
+        js_lazy_(js) == -1)
+    {
+        return NULL;
+    }
+
+    if ((i = js_object_find_(js->object, key, klen)) == -1)
+    {
+        return NULL;
+    }
+
+    return js_object_val_(js->object, (uint32_t)i);
+}
+
+static inline struct js_arena *
+js_node_arena_(lz_json * js)
+{
+    return (js->flags & JS_F_ARENA) ? js->arena : NULL;
+}
+
+/* makes a shape of the keys of `js`, a plain object, carved from the same
+ * place as the object. The shape has a copy of the keys, and the text
+ * js_object_to_buffer_() writes for them.
+ */
+static struct js_shape *
+js_shape_new_(lz_json * js)
+{
+    struct js_object * obj = js->object;
+    struct js_shape  * shape;
+    struct js_entry  * ent;
+    char             * str;
+    char             * text;
+    size_t             klens;
+    uint32_t           n_slots;
+    uint32_t           i;
+    bool               escape;
+
+    for (klens = 0, i = 0; i < obj->len; i++)
+    {
+        klens += obj->entries[i].klen + 1;
+    }
+
+    n_slots = 0;
+
+    if (obj->len > JS_OBJECT_LINEAR)
+    {
+        for (n_slots = 16; n_slots < obj->len * 2; n_slots *= 2)
+        {
+            ;
+        }
+    }
+
+    /* each key's text is a separator, its quotes and a colon around it */
+    if (!(shape = js_node_alloc_(js, sizeof(*shape) + obj->len * sizeof(struct js_entry) +
+                                 (n_slots + obj->len + 1) * sizeof(uint32_t) +
+                                 klens + klens + obj->len * 3)))
+    {
+        return NULL;
+    }
+
+    shape->arena    = js_node_arena_(js);
+    shape->refs     = 0;
+    shape->len      = obj->len;
+    shape->mask     = n_slots ? n_slots - 1 : 0;
+    shape->index    = n_slots ? (uint32_t *)&shape->keys[obj->len] : NULL;
+    shape->text_off = (uint32_t *)&shape->keys[obj->len] + n_slots;
+
+    str         = (char *)(shape->text_off + obj->len + 1);
+    text        = str + klens;
+    shape->text = text;
+    escape      = false;
+
+    for (i = 0; i < obj->len; i++)
+    {
+        ent         = &shape->keys[i];
+        ent->key    = str;
+        ent->klen   = obj->entries[i].klen;
+        ent->shared = 0;
+        ent->hash   = js_hash_(obj->entries[i].key, ent->klen);
+        ent->val    = NULL;
+
+        memcpy(str, obj->entries[i].key, ent->klen);
+        str[ent->klen] = '\0';
+        str           += ent->klen + 1;
+
+        shape->text_off[i] = (uint32_t)(text - shape->text);
+
+        *text++ = (i == 0) ? '{' : ',';
+        *text++ = '"';
+        memcpy(text, ent->key, ent->klen);
+        text   += ent->klen;
+        *text++ = '"';
+        *text++ = ':';
+
+        if (js_scan_string_scalar_(ent->key, ent->klen) != ent->klen)
+        {
+            escape = true;
+        }
+    }
+
+    shape->text_off[obj->len] = (uint32_t)(text - shape->text);
+
+    if (escape == true)
+    {
+        shape->text = NULL;
+    }
+
+    if (shape->index != NULL)
+    {
+        memset(shape->index, 0, n_slots * sizeof(uint32_t));
+
+        for (i = 0; i < obj->len; i++)
+        {
+            js_index_insert_(shape->index, shape->mask, shape->keys[i].hash, i);
+        }
+    }
+
+    return shape;
+} /* js_shape_new_ */
+
+/* turns `js`, a plain object whose keys are the first ones of `shape`, into
+ * a shaped one.
+ */
+static int
+js_object_shape_(lz_json * js, struct js_shape * shape)
+{
+    struct js_object * obj = js->object;
+    struct js_object * nobj;
+    uint32_t           i;
+
+    if (!(nobj = js_node_alloc_(js, sizeof(*nobj) + shape->len * sizeof(lz_json *))))
+    {
+        return -1;
+    }
+
+    memset(nobj, 0, sizeof(*nobj));
+    nobj->len   = obj->len;
+    nobj->cap   = shape->len;
+    nobj->shape = shape;
+
+    for (i = 0; i < obj->len; i++)
+    {
+        JS_OBJECT_VALS(nobj)[i] = obj->entries[i].val;
+
+        if (!(js->flags & JS_F_ARENA) && !obj->entries[i].shared)
+        {
+            free(obj->entries[i].key);
+        }
+    }
+
+    /* views copy their keys, so it carries over as it is */
+    nobj->view = obj->view;
+
+    if (!(js->flags & JS_F_ARENA))
+    {
+        free(obj->index);
+        free(obj);
+    }
+
+    __atomic_add_fetch(&shape->refs, 1, __ATOMIC_ACQ_REL);
+    js->object = nobj;
+
+    return 0;
+}
+
+/* turns a shaped object back into a plain one, with room for another key */
+static int
+js_object_unshape_(lz_json * js)
+{
+    struct js_object * obj   = js->object;
+    struct js_shape  * shape = obj->shape;
+    struct js_object * nobj;
+    struct js_entry  * ent;
+    uint32_t           cap;
+    uint32_t           i;
+
+    for (cap = JS_OBJECT_MIN; cap <= obj->len; cap *= 2)
+    {
+        ;
+    }
+
+    if (!(nobj = js_node_alloc_(js, sizeof(*nobj) + cap * sizeof(struct js_entry))))
+    {
+        return -1;
+    }
+
+    memset(nobj, 0, sizeof(*nobj));
+    nobj->cap = cap;
+
+    for (i = 0; i < obj->len; i++)
+    {
+        ent      = &nobj->entries[i];
+        *ent     = shape->keys[i];
+        ent->val = JS_OBJECT_VALS(obj)[i];
+
+        /* an arena shape lasts as long as the object, a heap one may not */
+        if (js->flags & JS_F_ARENA)
+        {
+            continue;
+        }
+
+        if (!(ent->key = malloc(ent->klen + 1)))
+        {
+            while (i-- > 0)
+            {
+                free(nobj->entries[i].key);
+            }
+
+            free(nobj);
+            return -1;
+        }
+
+        memcpy(ent->key, shape->keys[i].key, ent->klen + 1);
+    }
+
+    nobj->len  = obj->len;
+    nobj->view = obj->view;
+
+    if (!(js->flags & JS_F_ARENA))
+    {
+        free(obj);
+    }
+
+    js->object = nobj;
+    js_shape_drop_(shape);
+
+    if (nobj->len > JS_OBJECT_LINEAR)
+    {
+        /* if this fails, lookups stay linear */
+        js_object_reindex_(js);
+    }
+
+    return 0;
+} /* js_object_unshape_ */
+
+/* an object which is expected to get the keys of `shape` */
+static int
+js_object_init_shaped_(lz_json * js, struct js_shape * shape)
+{
+    if (js_node_arena_(js) != shape->arena)
+    {
+        return js_object_init_(js, 0);
+    }
+
+    if (!(js->object = js_node_alloc_(js, sizeof(struct js_object) +
+                                      shape->len * sizeof(lz_json *))))
+    {
+        return -1;
+    }
+
+    memset(js->object, 0, sizeof(struct js_object));
+    js->object->cap   = shape->len;
+    js->object->shape = shape;
+
+    __atomic_add_fetch(&shape->refs, 1, __ATOMIC_ACQ_REL);
+
+    return 0;
+}
+
+static lz_json *
+js_object_new_shaped_(struct js_shape * shape)
+{
+    lz_json * js;
+
+    if (!(js = js_new_(lz_json_vtype_object)))
+    {
+        return NULL;
+    }
+
+    if (js_object_init_shaped_(js, shape) == -1)
+    {
+        lz_safe_free(js, js_free_);
+
+        return NULL;
+    }
+
+    return js;
+}
+
+/* the shape the next element of `parent` is likely to have: the one of its
+ * last element, if that got all of its shape's keys.
+ */
+static struct js_shape *
+js_shape_next_(lz_json * parent)
+{
+    struct js_object * obj;
+    lz_json          * last;
+
+    if (parent->type != lz_json_vtype_array || parent->array->len == 0)
+    {
+        return NULL;
+    }
+
+    last = parent->array->items[parent->array->len - 1];
+
+    if (last->type != lz_json_vtype_object || (last->flags & JS_F_LAZY))
+    {
+        return NULL;
+    }
+
+    obj = last->object;
+
+    if (obj->shape == NULL || obj->len != obj->shape->len)
+    {
+        return NULL;
+    }
+
+    return obj->shape;
+}
+
+/* called once `js`, the last element of the array `arr`, is complete: if it
+ * has the same keys as the element before it, both end up with one shape.
+ */
+static int
+js_shape_share_(lz_json * arr, lz_json * js)
+{
+    struct js_object      * obj = js->object;
+    struct js_object      * pobj;
+    struct js_shape       * shape;
+    const struct js_entry * keys;
+    lz_json               * prev;
+    uint32_t                i;
+
+    if (obj->shape != NULL || obj->len == 0 || obj->len > JS_SHAPE_MAX || arr->array->len < 2)
+    {
+        return 0;
+    }
+
+    prev = arr->array->items[arr->array->len - 2];
+
+    if (prev->type != lz_json_vtype_object || (prev->flags & JS_F_LAZY) ||
+        js_node_arena_(prev) != js_node_arena_(js) || prev->object->len != obj->len)
+    {
+        return 0;
+    }
+
+    pobj = prev->object;
+    keys = JS_OBJECT_KEYS(pobj);
+
+    for (i = 0; i < obj->len; i++)
+    {
+        if (keys[i].klen != obj->entries[i].klen || keys[i].klen > JS_SHAPE_KLEN_MAX ||
+            memcmp(keys[i].key, obj->entries[i].key, keys[i].klen))
+        {
+            return 0;
+        }
+    }
+
+    if ((shape = pobj->shape) == NULL)
+    {
+        if (!(shape = js_shape_new_(prev)))
+        {
+            return -1;
+        }
+
+        if (js_object_shape_(prev, shape) == -1)
+        {
+            if (shape->arena == NULL)
+            {
+                free(shape);
+            }
+
+            return -1;
+        }
+    }
+
+    return js_object_shape_(js, shape);
+} /* js_shape_share_ */
+
+/* how js_object_put_() stores a key */
+#define JS_KEY_COPY     0
+#define JS_KEY_BORROWED 1 /* referenced, only arena objects can do this since their keys are never freed */
+#define JS_KEY_SHARED   2 /* referenced, from js_keys_intern_() */
+
+/* adds `val` under `key`; if the key already exists its value is replaced
+ * (and freed), so the last one added wins.
+ */
+static int
+js_object_put_(lz_json * dst, const char * key, size_t klen, lz_json * val, int how)
+{
+    struct js_object * obj;
+    struct js_entry  * ent;
+    lz_json         ** slot;
+    lz_json          * old;
+    ssize_t            i;
+    char             * kcopy;
+    uint32_t           hash;
+
+    if (lz_unlikely(dst == NULL || key == NULL || val == NULL))
+    {
+        return -1;
+    }
+
+    if (dst->type != lz_json_vtype_object || klen >= JS_KLEN_MAX || js_lazy_(dst) == -1)
+    {
+        return -1;
+    }
+
+    /* an arena object must be able to free values from outside of it */
+    if (js_owns_(dst, val) && js_arena_track_(dst) == -1)
+    {
+        return -1;
+    }
+
+    obj = dst->object;
+
+    /* a shaped object takes its shape's next key, which it cannot have yet */
+    if (obj->shape != NULL && obj->len < obj->shape->len)
+    {
+        ent = &obj->shape->keys[obj->len];
+
+        if (ent->klen == klen && (ent->key == key || !memcmp(ent->key, key, klen)))
+        {
+            if (obj->view != NULL && !lz_kvmap_add_wklen(obj->view, ent->key, klen, val, NULL))
+            {
+                return -1;
+            }
+
+            JS_OBJECT_VALS(obj)[obj->len] = val;
+            obj->len += 1;
+
+            return 0;
+        }
+    }
+
+    if (how == JS_KEY_SHARED)
+    {
+        hash = JS_KEY_OF(key)->hash;
+        i    = js_object_find_hashed_(obj, key, klen, hash);
+    } else {
+        hash = 0;
+        i    = js_object_find_(obj, key, klen);
+    }
+
+    if (i != -1)
+    {
+        slot  = obj->shape ? &JS_OBJECT_VALS(obj)[i] : &obj->entries[i].val;
+        old   = *slot;
+        *slot = val;
+
+        /* the view has no way to replace a value, so it goes along with the
+         * old one, and is rebuilt when next asked for.
+         */
+        lz_safe_free(obj->view, lz_kvmap_free);
+
+        if (old != val && js_owns_(dst, old))
+        {
+            js_free_(old);
+        }
+
+        return 0;
+    }
+
+    if (obj->shape != NULL && js_object_unshape_(dst) == -1)
+    {
+        return -1;
+    }
+
+    if (dst->object->len == dst->object->cap && js_object_grow_(dst) == -1)
+    {
+        return -1;
+    }
+
+    if (how != JS_KEY_COPY)
+    {
+        kcopy = (char *)key;
+    } else if (!(kcopy = js_node_alloc_(dst, klen + 1)))
+    {
+        return -1;
+    } else {
+        memcpy(kcopy, key, klen);
+        kcopy[klen] = '\0';
+    }
+
+    obj = dst->object;
+
+    if (obj->view != NULL && !lz_kvmap_add_wklen(obj->view, kcopy, klen, val, NULL))
+    {
+        if (how == JS_KEY_COPY && !(dst->flags & JS_F_ARENA))
+        {
+            free(kcopy);
+        }
+
+        return -1;
+    }
+
+    ent         = &obj->entries[obj->len];
+    ent->key    = kcopy;
+    ent->klen   = (uint32_t)klen;
+    ent->shared = (how == JS_KEY_SHARED);
+    ent->hash   = hash;
+    ent->val    = val;
+
+    if (obj->index != NULL)
+    {
+        if (!ent->shared)
+        {
+            ent->hash = js_hash_(key, klen);
+        }
+
+        js_object_index_insert_(obj, obj->len);
+    }
+
+    obj->len += 1;
+
+    if (obj->index == NULL && obj->len > JS_OBJECT_LINEAR)
+    {
+        /* if this fails, lookups stay linear */
+        js_object_reindex_(dst);
+    }
+
+    return 0;
+} /* js_object_put_ */
+
+static int
+js_object_add_klen_(lz_json * dst, const char * key, size_t klen, lz_json * val)
+{
+    return js_object_put_(dst, key, klen, val, JS_KEY_COPY);
+}
+
+static int
+js_object_add_(lz_json * dst, const char * key, lz_json * val)
+{
+    if (lz_unlikely(key == NULL))
+    {
+        return -1;
+    }
+
+    return js_object_add_klen_(dst, key, strlen(key), val);
+}
+
+/* lz_json_get_object() hands out an lz_kvmap of the entries, which is built
+ * the first time it is asked for.
+ */
+static lz_kvmap *
+js_get_object_(lz_json * js)
+{
+    struct js_object * obj;
+    lz_kvmap         * view;
+    uint32_t           i;
+
+    if (lz_unlikely(js == NULL || js->type != lz_json_vtype_object) || js_lazy_(js) == -1)
+    {
+        return NULL;
+    }
+
+    obj = js->object;
+
+    if (obj->view != NULL)
+    {
+        return obj->view;
+    }
+
+    if (js_arena_track_(js) == -1 || !(view = lz_kvmap_new(10)))
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < obj->len; i++)
+    {
+        if (!lz_kvmap_add_wklen(view, JS_OBJECT_KEYS(obj)[i].key,
+                                JS_OBJECT_KEYS(obj)[i].klen, js_object_val_(obj, i), NULL))
+        {
+            lz_kvmap_free(view);
+            return NULL;
+        }
+    }
+
+    obj->view = view;
+
+    return view;
+} /* js_get_object_ */
+
+static const char *
+js_object_get_key_(lz_json * js, int index, size_t * klen)
+{
+    if (lz_unlikely(js == NULL || js->type != lz_json_vtype_object) || js_lazy_(js) == -1)
+    {
+        return NULL;
+    }
+
+    if (index < 0 || (uint32_t)index >= js->object->len)
+    {
+        return NULL;
+    }
+
+    if (klen != NULL)
+    {
+        *klen = JS_OBJECT_KEYS(js->object)[index].klen;
+    }
+
+    return JS_OBJECT_KEYS(js->object)[index].key;
+}
+
+static lz_json *
+js_object_get_val_(lz_json * js, int index)
+{
+    if (lz_unlikely(js == NULL || js->type != lz_json_vtype_object) || js_lazy_(js) == -1)
+    {
+        return NULL;
+    }
+
+    if (index < 0 || (uint32_t)index >= js->object->len)
+    {
+        return NULL;
+    }
+
+    return js_object_val_(js->object, (uint32_t)index);
+}
+
+static int
+js_array_grow_(lz_json * js)
+{
+    struct js_array * arr = js->array;
+    struct js_array * narr;
+    size_t            size;
+
+    size = sizeof(*arr) + arr->cap * 2 * sizeof(lz_json *);
+
+    if (js->flags & JS_F_ARENA)
+    {
+        if (!(narr = js_arena_alloc_(js->arena, size)))
+        {
+            return -1;
+        }
+
+        memcpy(narr, arr, sizeof(*arr) + arr->len * sizeof(lz_json *));
+    } else if (!(narr = realloc(arr, size)))
+    {
+        return -1;
+    }
+
+    narr->cap *= 2;
+    js->array  = narr;
+
+    return 0;
+}
+
+static int
+js_array_add_(lz_json * dst, lz_json * src)
+{
+    struct js_array * arr;
+
+    if (lz_unlikely(dst == NULL || src == NULL))
+    {
+        return -1;
+    }
+
+    if (dst->type != lz_json_vtype_array || js_lazy_(dst) == -1)
+    {
+        return -1;
+    }
+
+    if (dst->array->len == dst->array->cap && js_array_grow_(dst) == -1)
+    {
+        return -1;
+    }
+
+    /* an arena array must be able to free values from outside of it */
+    if (js_owns_(dst, src) && js_arena_track_(dst) == -1)
+    {
+        return -1;
+    }
+
+    arr = dst->array;
+
+    if (arr->view != NULL && !lz_tailq_append(arr->view, src, 1, NULL))
+    {
+        return -1;
+    }
+
+    arr->items[arr->len++] = src;
+
+    return 0;
+}
+
+/* lz_json_get_array() hands out an lz_tailq of the values, which is built
+ * the first time it is asked for and kept up to date after that.
+ */
+static lz_tailq *
+js_get_array_(lz_json * js)
+{
+    struct js_array * arr;
+    size_t            i;
+
+    if (lz_unlikely(js == NULL || js->type != lz_json_vtype_array) || js_lazy_(js) == -1)
+    {
+        return NULL;
+    }
+
+    arr = js->array;
+
+    if (arr->view != NULL)
+    {
+        return arr->view;
+    }
+
+    if (js_arena_track_(js) == -1 || !(arr->view = lz_tailq_new()))
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < arr->len; i++)
+    {
+        if (!lz_tailq_append(arr->view, arr->items[i], 1, NULL))
+        {
+            lz_safe_free(arr->view, lz_tailq_free);
+            return NULL;
+        }
+    }
+
+    return arr->view;
+}
+
+/* structural scanners: find the next byte which ends a run of plain string
+ * characters ('"', '\\' or a control character), or the first byte which is
+ * not whitespace. On x86 these look at 16 or 32 bytes at a time, the widest
+ * version the CPU supports is picked by js_simd_init_().
+ */
+#define js_isspace_(ch) \
+    ((ch) == ' ' || (ch) == '\n' || (ch) == '\r' || (ch) == '\t')
+
+static size_t
+js_scan_string_scalar_(const char * data, size_t len)
+{
+    unsigned char ch;
+    size_t        i;
+
+    for (i = 0; i < len; i++)
+    {
+        ch = data[i];
+
+        if (ch == '"' || ch == '\\' || ch < 0x20)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+static size_t
+js_skip_space_scalar_(const char * data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (!js_isspace_(data[i]))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+#ifdef JS_SIMD_X86
+__attribute__((target("sse2")))
+static size_t
+js_scan_string_sse2_(const char * data, size_t len)
+{
+    const __m128i quote  = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i ctrl   = _mm_set1_epi8(0x1F);
+    size_t        i;
+
+    for (i = 0; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i m;
+        int     mask;
+
+        /* v <= 0x1f (unsigned) is min(v, 0x1f) == v */
+        m    = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+        m    = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+        mask = _mm_movemask_epi8(m);
+
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+
+    return i + js_scan_string_scalar_(data + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static size_t
+js_skip_space_sse2_(const char * data, size_t len)
+{
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i tb = _mm_set1_epi8('\t');
+    size_t        i;
+
+    for (i = 0; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i m;
+        int     mask;
+
+        m    = _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl));
+        m    = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tb)));
+        mask = ~_mm_movemask_epi8(m) & 0xFFFF;
+
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz((unsigned int)mask);
+        }
+    }
+
+    return i + js_skip_space_scalar_(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t
+js_scan_string_avx2_(const char * data, size_t len)
+{
+    const __m256i quote  = _mm256_set1_epi8('"');
+    const __m256i bslash = _mm256_set1_epi8('\\');
+    const __m256i ctrl   = _mm256_set1_epi8(0x1F);
+    size_t        i;
+
+    if (len < 32)
+    {
+        return js_scan_string_sse2_(data, len);
+    }
+
+    for (i = 0; i + 32 <= len; i += 32)
+    {
+        __m256i  v = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i  m;
+        uint32_t mask;
+
+        m    = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash));
+        m    = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v));
+        mask = (uint32_t)_mm256_movemask_epi8(m);
+
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + js_scan_string_sse2_(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t
+js_skip_space_avx2_(const char * data, size_t len)
+{
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i tb = _mm256_set1_epi8('\t');
+    size_t        i;
+
+    if (len < 32)
+    {
+        return js_skip_space_sse2_(data, len);
+    }
+
+    for (i = 0; i + 32 <= len; i += 32)
+    {
+        __m256i  v = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i  m;
+        uint32_t mask;
+
+        m    = _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl));
+        m    = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+                                                  _mm256_cmpeq_epi8(v, tb)));
+        mask = ~(uint32_t)_mm256_movemask_epi8(m);
+
+        if (mask != 0)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + js_skip_space_sse2_(data + i, len - i);
+}
+
+static size_t (* js_scan_string_)(const char *, size_t) = js_scan_string_sse2_;
+static size_t (* js_skip_space_)(const char *, size_t)  = js_skip_space_sse2_;
+#else
+static size_t (* js_scan_string_)(const char *, size_t) = js_scan_string_scalar_;
+static size_t (* js_skip_space_)(const char *, size_t)  = js_skip_space_scalar_;
+#endif
+
+/* stage 1 of lz_json_doc parsing: classify 64 bytes into bitmasks */
+struct js_masks {
+    uint64_t quote;
+    uint64_t bslash;
+    uint64_t space;
+    uint64_t op;
+};
+
+static void
+js_classify_scalar_(const char * block, struct js_masks * m)
+{
+    uint64_t bit;
+    int      i;
+
+    memset(m, 0, sizeof(*m));
+
+    for (i = 0; i < 64; i++)
+    {
+        bit = 1ULL << i;
+
+        switch (block[i]) {
+            case '"':
+                m->quote  |= bit;
+                break;
+            case '\\':
+                m->bslash |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                m->space  |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                m->op     |= bit;
+                break;
+        }
+    }
+}
+
+#ifdef JS_SIMD_X86
+__attribute__((target("sse2")))
+static void
+js_classify_sse2_(const char * block, struct js_masks * m)
+{
+    int i;
+
+    memset(m, 0, sizeof(*m));
+
+    for (i = 0; i < 64; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(block + i));
+        __m128i s;
+        __m128i o;
+
+        s = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+        s = _mm_or_si128(s, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        s = _mm_or_si128(s, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+
+        o = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+        o = _mm_or_si128(o, _mm_cmpeq_epi8(v, _mm_set1_epi8('[')));
+        o = _mm_or_si128(o, _mm_cmpeq_epi8(v, _mm_set1_epi8(']')));
+        o = _mm_or_si128(o, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+        o = _mm_or_si128(o, _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+
+        m->quote  |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << i;
+        m->bslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+        m->space  |= (uint64_t)(uint16_t)_mm_movemask_epi8(s) << i;
+        m->op     |= (uint64_t)(uint16_t)_mm_movemask_epi8(o) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+static void
+js_classify_avx2_(const char * block, struct js_masks * m)
+{
+    int i;
+
+    memset(m, 0, sizeof(*m));
+
+    for (i = 0; i < 64; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(block + i));
+        __m256i s;
+        __m256i o;
+
+        s = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+        s = _mm256_or_si256(s, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        s = _mm256_or_si256(s, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+
+        o = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')));
+        o = _mm256_or_si256(o, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('[')));
+        o = _mm256_or_si256(o, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(']')));
+        o = _mm256_or_si256(o, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')));
+        o = _mm256_or_si256(o, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')));
+
+        m->quote  |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << i;
+        m->bslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << i;
+        m->space  |= (uint64_t)(uint32_t)_mm256_movemask_epi8(s) << i;
+        m->op     |= (uint64_t)(uint32_t)_mm256_movemask_epi8(o) << i;
+    }
+}
+
+static void (* js_classify_)(const char *, struct js_masks *) = js_classify_sse2_;
+#else
+static void (* js_classify_)(const char *, struct js_masks *) = js_classify_scalar_;
+#endif
+
+static void
+js_simd_init_(void)
+{
+#ifdef JS_SIMD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        js_scan_string_ = js_scan_string_avx2_;
+        js_skip_space_  = js_skip_space_avx2_;
+        js_classify_    = js_classify_avx2_;
+    } else if (!__builtin_cpu_supports("sse2"))
+    {
+        js_scan_string_ = js_scan_string_scalar_;
+        js_skip_space_  = js_skip_space_scalar_;
+        js_classify_    = js_classify_scalar_;
+    }
+#endif
+}
+
+/* string scanner state, carried between chunks by the push parser */
+#define JS_STR_F_BACKSLASH 0x01 /* the last byte seen was an unescaped '\\' */
+#define JS_STR_F_ESCAPED   0x02 /* the body contains escape sequences */
+#define JS_STR_F_INVALID   0x04 /* the body contains raw control characters */
+#define JS_STR_F_STASHED   0x08 /* the token was stashed between two feeds */
+
+/* returns the offset of the closing quote of a string body, or `len` if the
+ * string does not end within `data`.
+ */
+static size_t
+js_string_end_(const char * data, size_t len, int * flags)
+{
+    unsigned char ch;
+    size_t        i;
+
+    i = 0;
+
+    if (len > 0 && (*flags & JS_STR_F_BACKSLASH))
+    {
+        *flags &= ~JS_STR_F_BACKSLASH;
+        i       = 1;
+    }
+
+    while (i < len)
+    {
+        i += js_scan_string_(data + i, len - i);
+
+        if (i == len)
+        {
+            break;
+        }
+
+        ch = data[i];
+
+        if (ch == '"')
+        {
+            return i;
+        }
+
+        if (ch == '\\')
+        {
+            *flags |= JS_STR_F_ESCAPED;
+
+            if (i + 1 == len)
+            {
+                /* the escaped byte is in the next chunk */
+                *flags |= JS_STR_F_BACKSLASH;
+                return len;
+            }
+
+            i += 2;
+            continue;
+        }
+
+        *flags |= JS_STR_F_INVALID;
+        i      += 1;
+    }
+
+    return len;
+}
+
+/* returns true if the `len` bytes at `data` are well formed UTF-8: no stray
+ * continuation bytes, truncated or overlong sequences, surrogates or code
+ * points past U+10FFFF.
+ */
+static bool
+js_utf8_valid_(const char * data, size_t len)
+{
+    const unsigned char * s;
+    unsigned char         lo;
+    unsigned char         hi;
+    uint64_t              word;
+    size_t                i;
+    size_t                n;
+
+    s = (const unsigned char *)data;
+    i = 0;
+
+    while (i < len)
+    {
+        if (len - i >= 8)
+        {
+            memcpy(&word, &s[i], sizeof(word));
+
+            if (!(word & 0x8080808080808080ULL))
+            {
+                i += 8;
+                continue;
+            }
+        }
+
+        if (s[i] < 0x80)
+        {
+            i += 1;
+            continue;
+        }
+
+        lo = 0x80;
+        hi = 0xbf;
+
+        if (s[i] >= 0xc2 && s[i] <= 0xdf)
+        {
+            n = 1;
+        } else if (s[i] >= 0xe0 && s[i] <= 0xef) {
+            n = 2;
+
+            if (s[i] == 0xe0)
+            {
+                lo = 0xa0;
+            } else if (s[i] == 0xed) {
+                hi = 0x9f;
+            }
+        } else if (s[i] >= 0xf0 && s[i] <= 0xf4) {
+            n = 3;
+
+            if (s[i] == 0xf0)
+            {
+                lo = 0x90;
+            } else if (s[i] == 0xf4) {
+                hi = 0x8f;
+            }
+        } else {
+            return false;
+        }
+
+        if (len - i <= n || s[i + 1] < lo || s[i + 1] > hi)
+        {
+            return false;
+        }
+
+        switch (n) {
+            case 3:
+                if ((s[i + 3] & 0xc0) != 0x80)
+                {
+                    return false;
+                }
+            /* fallthrough */
+            case 2:
+                if ((s[i + 2] & 0xc0) != 0x80)
+                {
+                    return false;
+                }
+        }
+
+        i += n + 1;
+    }
+
+    return true;
+} /* js_utf8_valid_ */
+
+static lz_json *
+js_parse_string_(const char * data, size_t len, size_t * n_read)
+{
+    size_t end;
+    int    flags;
+
+    if (!data || !len || *data != '"')
+    {
+        /* *n_read = 0; */
+        return NULL;
+    }
+
+    flags = 0;
+    end   = js_string_end_(data + 1, len - 1, &flags);
+
+    if (end == len - 1 || (flags & JS_STR_F_INVALID) ||
+        !js_utf8_valid_(data + 1, end))
+    {
+        *n_read += end;
+        return NULL;
+    }
+
+    *n_read += end + 1;
+
+    return js_string_new_raw_(data + 1, end, (flags & JS_STR_F_ESCAPED) != 0);
+}
+
+static lz_json *
+js_parse_number_(const char * data, size_t len, size_t * n_read)
+{
+    struct js_num num;
+    ssize_t       end;
+
+    if (!data || !len)
+    {
+        return NULL;
+    }
+
+    if ((end = js_num_parse_(data, len, &num)) == -1)
+    {
+        return NULL;
+    }
+
+    /* like the other scalars, n_read is moved to the last byte of the value */
+    *n_read += (size_t)end - 1;
+
+    return js_num_new_(&num);
+}
+
+#define J_TRUE_CMP   0x657572
+#define J_FALSE_CMP  0x65736c61
+#define J_TRUE_MASK  0xFFFFFF
+#define J_FALSE_MASK 0xFFFFFFFF
+
+static lz_json *
+js_parse_boolean_(const char * data, size_t len, size_t * n_read)
+{
+    lz_json * js;
+
+    if (lz_unlikely(len < 4))
+    {
+        /* need at LEAST 'true' */
+        *n_read = 0;
+        return NULL;
+    }
+
+    js = NULL;
+
+    /* here we cast our data string to an integer, mask it by the
+     * number of words we want to see, then match the integer version
+     * of the string.
+     */
+    switch (*data) {
+        case 't':
+            if ((*((uint32_t *)(data + 1)) & J_TRUE_MASK) == J_TRUE_CMP)
+            {
+                *n_read += 3;
+
+                if (!(js = js_boolean_new_(true)))
+                {
+                    return NULL;
+                }
+            }
+
+            break;
+        case 'f':
+            if (len < 5)
+            {
+                return NULL;
+            }
+
+            if ((*((uint32_t *)(data + 1)) & J_FALSE_MASK) == J_FALSE_CMP)
+            {
+                *n_read += 4;
+
+                if (!(js = js_boolean_new_(false)))
+                {
+                    return NULL;
+                }
+            }
+
+            break;
+        default:
+            return NULL;
+    } /* switch */
+
+    return js;
+}     /* js_parse_boolean_ */
+
+static lz_json *
+js_parse_null_(const char * data, size_t len, size_t * n_read)
+{
+    if (data == NULL || len < 4)
+    {
+        return NULL;
+    }
+
+    if (!lz_str30_cmp(data, 'n', 'u', 'l', 'l'))
+    {
+        return NULL;
+    }
+
+    *n_read += 4;
+
+    return js_null_new_();
+}
+
+/* incremental (push) parser: the object and array state machines are kept on
+ * an explicit stack so that parsing can be suspended at the end of any chunk
+ * and resumed with the next one. A scalar token which straddles two chunks is
+ * stashed in `tok` until it is complete.
+ *
+ * The parser itself builds nothing, it only emits lz_json_events; the tree
+ * builder further down is just one consumer of those events.
+ */
+#define JS_PARSER_INLINE_DEPTH 32
+
+#define JS_EMIT(p, cb, ...) \
+    ((p)->events->cb ? (p)->events->cb((p)->arg, ## __VA_ARGS__) : 0)
+
+enum js_tok_type {
+    js_tok_none = 0,
+    js_tok_string,
+    js_tok_number,
+    js_tok_literal
+};
+
+struct js_frame {
+    lz_json_vtype type;
+    union {
+        lz_j_obj_state obj;
+        lz_j_arr_state arr;
+    } state;
+};
+
+struct js_builder {
+    lz_json        ** stack;
+    size_t            stack_idx;
+    size_t            stack_len;
+    lz_json         * root;
+    char            * key;
+    size_t            key_idx;
+    size_t            key_len;
+    const char      * key_view; /* LZ_JSON_PARSE_ZEROCOPY: the key in the input */
+    lz_json_keys    * keys;     /* interns object keys, if set */
+    struct js_arena * arena;
+    int               flags;
+};
+
+static int js_builder_raw_(struct js_builder *, const char *, size_t, int, bool);
+
+struct lz_json_parser_s {
+    const lz_json_events * events;
+    void                 * arg;
+    struct js_builder    * builder;
+    struct js_frame      * stack;
+    size_t                 stack_idx;
+    size_t                 stack_len;
+    lz_j_state             state;
+    char                 * tok;
+    size_t                 tok_idx;
+    size_t                 tok_len;
+    enum js_tok_type       tok_type;
+    int                    tok_flags;
+    size_t                 n_read;
+    bool                   error;
+    bool                   stopped;
+    struct js_frame        stack_inline[JS_PARSER_INLINE_DEPTH];
+};
+
+static void
+js_parser_init_(lz_json_parser * p, const lz_json_events * events, void * arg)
+{
+    memset(p, 0, offsetof(lz_json_parser, stack_inline));
+
+    p->events    = events;
+    p->arg       = arg;
+    p->stack     = p->stack_inline;
+    p->stack_len = JS_PARSER_INLINE_DEPTH;
+    p->state     = lz_j_s_start;
+}
+
+static void
+js_parser_reset_(lz_json_parser * p)
+{
+    p->stack_idx   = 0;
+    p->state       = lz_j_s_start;
+    p->tok_idx     = 0;
+    p->tok_type    = js_tok_none;
+    p->tok_flags   = 0;
+    p->n_read      = 0;
+    p->error       = false;
+    p->stopped     = false;
+}
+
+static void
+js_parser_deinit_(lz_json_parser * p)
+{
+    if (p->stack != p->stack_inline)
+    {
+        lz_safe_free(p->stack, free);
+    }
+
+    lz_safe_free(p->tok, free);
+}
+
+static int
+js_parser_reserve_(lz_json_parser * p, size_t len)
+{
+    size_t nlen;
+    char * ntok;
+
+    if (len <= p->tok_len)
+    {
+        return 0;
+    }
+
+    nlen = p->tok_len ? p->tok_len : 64;
+
+    while (nlen < len)
+    {
+        nlen *= 2;
+    }
+
+    if (!(ntok = realloc(p->tok, nlen)))
+    {
+        return -1;
+    }
+
+    p->tok     = ntok;
+    p->tok_len = nlen;
+
+    return 0;
+}
+
+static int
+js_parser_stash_(lz_json_parser * p, const char * data, size_t len)
+{
+    if (js_parser_reserve_(p, p->tok_idx + len) == -1)
+    {
+        return -1;
+    }
+
+    memcpy(&p->tok[p->tok_idx], data, len);
+    p->tok_idx += len;
+
+    return 0;
+}
+
+/* the return value of an event callback: 0 to continue, 1 to stop the
+ * parse early, anything else is an error.
+ */
+static int
+js_parser_check_(lz_json_parser * p, int res)
+{
+    switch (res) {
+        case 0:
+            return 0;
+        case 1:
+            p->stopped = true;
+            p->state   = lz_j_s_end;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/* moves the frame on the top of the stack past the value which is about to
+ * be emitted. Returns -1 if a value is not valid here.
+ */
+static int
+js_parser_value_(lz_json_parser * p)
+{
+    struct js_frame * frame;
+
+    if (p->stack_idx == 0)
+    {
+        /* only objects and arrays are valid at the top level */
+        return -1;
+    }
+
+    frame = &p->stack[p->stack_idx - 1];
+
+    if (frame->type == lz_json_vtype_array)
+    {
+        frame->state.arr = lz_j_arr_s_comma;
+    } else {
+        frame->state.obj = lz_j_obj_s_comma;
+    }
+
+    return 0;
+}
+
+static int
+js_parser_push_(lz_json_parser * p, unsigned char ch)
+{
+    struct js_frame * frame;
+
+    if (p->stack_idx > 0 && js_parser_value_(p) == -1)
+    {
+        return -1;
+    }
+
+    if (p->stack_idx == p->stack_len)
+    {
+        size_t            nlen = p->stack_len * 2;
+        struct js_frame * nstack;
+
+        if (p->stack == p->stack_inline)
+        {
+            if ((nstack = malloc(nlen * sizeof(*nstack))))
+            {
+                memcpy(nstack, p->stack, p->stack_len * sizeof(*nstack));
+            }
+        } else {
+            nstack = realloc(p->stack, nlen * sizeof(*nstack));
+        }
+
+        if (nstack == NULL)
+        {
+            return -1;
+        }
+
+        p->stack     = nstack;
+        p->stack_len = nlen;
+    }
+
+    frame = &p->stack[p->stack_idx++];
+
+    if (ch == '{')
+    {
+        frame->type      = lz_json_vtype_object;
+        frame->state.obj = lz_j_obj_s_key;
+
+        return js_parser_check_(p, JS_EMIT(p, on_object_start));
+    }
+
+    frame->type      = lz_json_vtype_array;
+    frame->state.arr = lz_j_arr_s_val;
+
+    return js_parser_check_(p, JS_EMIT(p, on_array_start));
+} /* js_parser_push_ */
+
+static int
+js_parser_pop_(lz_json_parser * p)
+{
+    lz_json_vtype type;
+
+    type          = p->stack[p->stack_idx - 1].type;
+    p->stack_idx -= 1;
+
+    if (p->stack_idx == 0)
+    {
+        p->state = lz_j_s_end;
+    }
+
+    if (type == lz_json_vtype_object)
+    {
+        return js_parser_check_(p, JS_EMIT(p, on_object_end));
+    }
+
+    return js_parser_check_(p, JS_EMIT(p, on_array_end));
+}
+
+static int
+js_parser_string_(lz_json_parser * p, const char * data, size_t len, int flags)
+{
+    struct js_frame * frame;
+    ssize_t           slen;
+    bool              key;
+
+    /* `data` points at the opening quote, `len` includes both quotes */
+    data += 1;
+    len  -= 2;
+
+    if ((flags & JS_STR_F_INVALID) || !js_utf8_valid_(data, len))
+    {
+        return -1;
+    }
+
+    frame = p->stack_idx ? &p->stack[p->stack_idx - 1] : NULL;
+    key   = (frame != NULL &&
+             frame->type == lz_json_vtype_object &&
+             frame->state.obj == lz_j_obj_s_key);
+
+    if (key == true)
+    {
+        frame->state.obj = lz_j_obj_s_delim;
+    } else if (js_parser_value_(p) == -1)
+    {
+        return -1;
+    }
+
+    if (p->builder != NULL)
+    {
+        /* the tree builder decodes straight into its final destination.
+         * A token stashed between two feeds is not part of the input.
+         */
+        if (data == p->tok + 1)
+        {
+            flags |= JS_STR_F_STASHED;
+        }
+
+        return js_builder_raw_(p->builder, data, len, flags, key);
+    }
+
+    if (flags & JS_STR_F_ESCAPED)
+    {
+        /* a stashed token is decoded in place, anything else goes to the
+         * scratch buffer which is reused for the life of the parser.
+         */
+        if (data != p->tok + 1 && js_parser_reserve_(p, len) == -1)
+        {
+            return -1;
+        }
+
+        if ((slen = js_unescape_(p->tok, data, len)) == -1)
+        {
+            return -1;
+        }
+
+        data = p->tok;
+        len  = (size_t)slen;
+    }
+
+    if (key == true)
+    {
+        return js_parser_check_(p, JS_EMIT(p, on_key, data, len));
+    }
+
+    return js_parser_check_(p, JS_EMIT(p, on_string, data, len));
+} /* js_parser_string_ */
+
+/* emits the event for a complete scalar token */
+static int
+js_parser_token_(lz_json_parser * p, enum js_tok_type type,
+                 const char * data, size_t len, int flags)
+{
+    if (type == js_tok_string)
+    {
+        return js_parser_string_(p, data, len, flags);
+    }
+
+    if (js_parser_value_(p) == -1)
+    {
+        return -1;
+    }
+
+    switch (type) {
+        case js_tok_number:
+            return js_parser_check_(p, JS_EMIT(p, on_number, data, len));
+        case js_tok_literal:
+            if (len == 4 && !memcmp(data, "true", 4))
+            {
+                return js_parser_check_(p, JS_EMIT(p, on_boolean, true));
+            }
+
+            if (len == 5 && !memcmp(data, "false", 5))
+            {
+                return js_parser_check_(p, JS_EMIT(p, on_boolean, false));
+            }
+
+            if (len == 4 && !memcmp(data, "null", 4))
+            {
+                return js_parser_check_(p, JS_EMIT(p, on_null));
+            }
+
+            return -1;
+        default:
+            return -1;
+    }
+} /* js_parser_token_ */
+
+/* the end of the characters a number can be made of, js_num_parse_() checks
+ * they are in the right order.
+ */
+static size_t
+js_number_end_(const char * data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        switch (data[i]) {
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+            case '-': case '+': case '.': case 'e': case 'E':
+                continue;
+        }
+
+        break;
+    }
+
+    return i;
+}
+
+/* continues a token stashed by the previous feed, returns the number of
+ * bytes of `data` it consumed.
+ */
+static ssize_t
+js_parser_resume_(lz_json_parser * p, const char * data, size_t len)
+{
+    enum js_tok_type type;
+    size_t           end;
+    size_t           need;
+    bool             complete;
+
+    switch (p->tok_type) {
+        case js_tok_string:
+            end      = js_string_end_(data, len, &p->tok_flags);
+            complete = (end < len);
+
+            if (complete == true)
+            {
+                end += 1;
+            }
+            break;
+        case js_tok_number:
+            end      = js_number_end_(data, len);
+            complete = (end < len);
+            break;
+        case js_tok_literal:
+            need     = (p->tok[0] == 'f' ? 5 : 4) - p->tok_idx;
+            end      = (need < len) ? need : len;
+            complete = (end == need);
+            break;
+        default:
+            return 0;
+    }
+
+    if (js_parser_stash_(p, data, end) == -1)
+    {
+        return -1;
+    }
+
+    if (complete == false)
+    {
+        return (ssize_t)end;
+    }
+
+    type        = p->tok_type;
+    p->tok_type = js_tok_none;
+
+    if (js_parser_token_(p, type, p->tok, p->tok_idx, p->tok_flags) == -1)
+    {
+        return -1;
+    }
+
+    p->tok_idx = 0;
+
+    return (ssize_t)end;
+} /* js_parser_resume_ */
+
+/* starts a scalar token at data[0], stashing it if it runs past the chunk */
+static ssize_t
+js_parser_scalar_(lz_json_parser * p, const char * data, size_t len)
+{
+    enum js_tok_type type;
+    size_t           end;
+    int              flags = 0;
+
+    switch (data[0]) {
+        case '"':
+            type = js_tok_string;
+            end  = js_string_end_(&data[1], len - 1, &flags) + 1;
+
+            if (end < len)
+            {
+                end += 1;
+            } else {
+                end  = 0;
+            }
+            break;
+        case 't':
+        case 'n':
+            type = js_tok_literal;
+            end  = (len >= 4) ? 4 : 0;
+            break;
+        case 'f':
+            type = js_tok_literal;
+            end  = (len >= 5) ? 5 : 0;
+            break;
+        default:
+            if (!isdigit((unsigned char)data[0]) && data[0] != '-')
+            {
+                return -1;
+            }
+
+            type = js_tok_number;
+            end  = js_number_end_(data, len);
+
+            if (end == len)
+            {
+                end = 0;
+            }
+            break;
+    } /* switch */
+
+    if (end == 0)
+    {
+        /* incomplete, keep what we have for the next feed */
+        if (js_parser_stash_(p, data, len) == -1)
+        {
+            return -1;
+        }
+
+        p->tok_type  = type;
+        p->tok_flags = flags;
+
+        return (ssize_t)len;
+    }
+
+    if (js_parser_token_(p, type, data, end, flags) == -1)
+    {
+        return -1;
+    }
+
+    return (ssize_t)end;
+} /* js_parser_scalar_ */
+
+static ssize_t
+js_parser_scan_(lz_json_parser * p, const char * data, size_t len)
+{
+    unsigned char     ch;
+    size_t            i;
+    ssize_t           b_read;
+    struct js_frame * frame;
+
+    if (lz_unlikely(p == NULL || p->error == true))
+    {
+        return -1;
+    }
+
+    if (data == NULL || len == 0 || p->state == lz_j_s_end)
+    {
+        return 0;
+    }
+
+    i = 0;
+
+    if (p->tok_type != js_tok_none)
+    {
+        if ((b_read = js_parser_resume_(p, data, len)) == -1)
+        {
+            goto error;
+        }
+
+        i = (size_t)b_read;
+    }
+
+    while (i < len && p->state != lz_j_s_end)
+    {
+        ch = data[i];
+
+        if (js_isspace_(ch))
+        {
+            i += js_skip_space_(&data[i], len - i);
+            continue;
+        }
+
+        if (p->stack_idx == 0)
+        {
+            if (ch != '{' && ch != '[')
+            {
+                goto error;
+            }
+
+            if (js_parser_push_(p, ch) == -1)
+            {
+                goto error;
+            }
+
+            i++;
+            continue;
+        }
+
+        frame = &p->stack[p->stack_idx - 1];
+
+        if (frame->type == lz_json_vtype_object)
+        {
+            switch (frame->state.obj) {
+                case lz_j_obj_s_key:
+                    if (ch == '}')
+                    {
+                        if (js_parser_pop_(p) == -1)
+                        {
+                            goto error;
+                        }
+
+                        i++;
+                        continue;
+                    }
+
+                    if (ch != '"')
+                    {
+                        goto error;
+                    }
+                    break;
+                case lz_j_obj_s_delim:
+                    if (ch != ':')
+                    {
+                        goto error;
+                    }
+
+                    frame->state.obj = lz_j_obj_s_val;
+                    i++;
+                    continue;
+                case lz_j_obj_s_comma:
+                    switch (ch) {
+                        case ',':
+                            frame->state.obj = lz_j_obj_s_key;
+                            break;
+                        case '}':
+                            if (js_parser_pop_(p) == -1)
+                            {
+                                goto error;
+                            }
+                            break;
+                        default:
+                            goto error;
+                    }
+
+                    i++;
+                    continue;
+                default:
+                    break;
+            } /* switch */
+        } else {
+            switch (frame->state.arr) {
+                case lz_j_arr_s_val:
+                    if (ch == ']')
+                    {
+                        if (js_parser_pop_(p) == -1)
+                        {
+                            goto error;
+                        }
+
+                        i++;
+                        continue;
+                    }
+                    break;
+                case lz_j_arr_s_comma:
+                    switch (ch) {
+                        case ',':
+                            frame->state.arr = lz_j_arr_s_val;
+                            break;
+                        case ']':
+                            if (js_parser_pop_(p) == -1)
+                            {
+                                goto error;
+                            }
+                            break;
+                        default:
+                            goto error;
+                    }
+
+                    i++;
+                    continue;
+                default:
+                    break;
+            } /* switch */
+        }
+
+        /* a key or a value starts here */
+        if (ch == '{' || ch == '[')
+        {
+            if (js_parser_push_(p, ch) == -1)
+            {
+                goto error;
+            }
+
+            i++;
+            continue;
+        }
+
+        if ((b_read = js_parser_scalar_(p, &data[i], len - i)) == -1)
+        {
+            goto error;
+        }
+
+        i += (size_t)b_read;
+    }
+
+    p->n_read += i;
+
+    return (ssize_t)i;
+error:
+    p->n_read += i;
+    p->error   = true;
+
+    return -1;
+} /* js_parser_scan_ */
+
+static ssize_t
+js_parser_feed_(lz_json_parser * p, const char * data, size_t len)
+{
+    struct js_builder * b;
+    struct js_arena   * prev;
+    ssize_t             res;
+
+    if (p == NULL || (b = p->builder) == NULL || !(b->flags & LZ_JSON_PARSE_ARENA))
+    {
+        return js_parser_scan_(p, data, len);
+    }
+
+    /* every document gets an arena of its own, which its root takes over */
+    if (b->arena == NULL && !(b->arena = js_arena_new_()))
+    {
+        p->error = true;
+        return -1;
+    }
+
+    prev = js_arena_enter_(b->arena);
+    res  = js_parser_scan_(p, data, len);
+
+    js_arena_enter_(prev);
+
+    return res;
+}
+
+/* zero-copy strings are never freed on their own, and lazy containers are
+ * filled in later, so both need an arena.
+ */
+static inline int
+js_parse_flags_(int flags)
+{
+    if (flags & (LZ_JSON_PARSE_ZEROCOPY | LZ_JSON_PARSE_LAZY))
+    {
+        flags |= LZ_JSON_PARSE_ARENA;
+    }
+
+    return flags;
+}
+
+/* the tree builder: turns parser events into lz_json contexts. Containers are
+ * attached to their parent as soon as they are opened, so a partial tree can
+ * always be released through the root.
+ */
+static void
+js_builder_clear_(struct js_builder * b)
+{
+    b->stack_idx = 0;
+    b->key_idx   = 0;
+    b->key_view  = NULL;
+
+    if (b->arena != NULL)
+    {
+        /* a partial tree goes along with its arena */
+        b->root = NULL;
+        lz_safe_free(b->arena, js_arena_free_);
+    }
+
+    lz_safe_free(b->root, js_free_);
+}
+
+static void
+js_builder_deinit_(struct js_builder * b)
+{
+    js_builder_clear_(b);
+
+    lz_safe_free(b->stack, free);
+    lz_safe_free(b->key, free);
+}
+
+static int
+js_builder_value_(struct js_builder * b, lz_json * val)
+{
+    lz_json    * parent;
+    const char * key;
+    const char * ikey;
+    int          res;
+
+    if (val == NULL)
+    {
+        return -1;
+    }
+
+    if (b->stack_idx == 0)
+    {
+        b->root = val;
+        return 0;
+    }
+
+    parent = b->stack[b->stack_idx - 1];
+
+    if (parent->type == lz_json_vtype_array)
+    {
+        if (js_array_add_(parent, val) == -1)
+        {
+            lz_safe_free(val, js_free_);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    key = (b->key_view != NULL) ? b->key_view : b->key;
+
+    if (b->keys != NULL && (ikey = js_keys_intern_(b->keys, key, b->key_idx)))
+    {
+        res = js_object_put_(parent, ikey, b->key_idx, val, JS_KEY_SHARED);
+    } else if (b->key_view != NULL)
+    {
+        res = js_object_put_(parent, key, b->key_idx, val, JS_KEY_BORROWED);
+    } else {
+        res = js_object_put_(parent, key, b->key_idx, val, JS_KEY_COPY);
+    }
+
+    if (res == -1)
+    {
+        lz_safe_free(val, js_free_);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+js_builder_open_(struct js_builder * b, lz_json * js)
+{
+    if (b->stack_idx == b->stack_len)
+    {
+        size_t     nlen   = b->stack_len ? b->stack_len * 2 : 16;
+        lz_json ** nstack = realloc(b->stack, nlen * sizeof(*nstack));
+
+        if (nstack == NULL)
+        {
+            lz_safe_free(js, js_free_);
+            return -1;
+        }
+
+        b->stack     = nstack;
+        b->stack_len = nlen;
+    }
+
+    if (js_builder_value_(b, js) == -1)
+    {
+        return -1;
+    }
+
+    b->stack[b->stack_idx++] = js;
+
+    return 0;
+}
+
+/* an object following one with a complete shape in an array starts out
+ * with that shape.
+ */
+static int
+js_builder_object_start_(void * arg)
+{
+    struct js_builder * b     = arg;
+    struct js_shape   * shape = NULL;
+
+    if (b->stack_idx > 0)
+    {
+        shape = js_shape_next_(b->stack[b->stack_idx - 1]);
+    }
+
+    return js_builder_open_(b, shape ? js_object_new_shaped_(shape) : js_object_new_());
+}
+
+static int
+js_builder_array_start_(void * arg)
+{
+    return js_builder_open_(arg, js_array_new_());
+}
+
+static int
+js_builder_end_(void * arg)
+{
+    struct js_builder * b = arg;
+    lz_json           * js;
+
+    b->stack_idx -= 1;
+    js            = b->stack[b->stack_idx];
+
+    if (js->type == lz_json_vtype_object && b->stack_idx > 0 &&
+        b->stack[b->stack_idx - 1]->type == lz_json_vtype_array)
+    {
+        /* if this fails, the object simply stays as it is */
+        js_shape_share_(b->stack[b->stack_idx - 1], js);
+    }
+
+    return 0;
+}
+
+static int
+js_builder_setkey_(struct js_builder * b, const char * key, size_t len, bool escaped)
+{
+    ssize_t klen;
+
+    b->key_view = NULL;
+
+    if (len + 1 > b->key_len)
+    {
+        char * nkey;
+
+        if (!(nkey = realloc(b->key, len + 64)))
+        {
+            return -1;
+        }
+
+        b->key     = nkey;
+        b->key_len = len + 64;
+    }
+
+    if (escaped == true)
+    {
+        if ((klen = js_unescape_(b->key, key, len)) == -1)
+        {
+            return -1;
+        }
+    } else {
+        memcpy(b->key, key, len);
+        klen = (ssize_t)len;
+    }
+
+    b->key[klen] = '\0';
+    b->key_idx   = (size_t)klen;
+
+    return 0;
+}
+
+static int
+js_builder_key_(void * arg, const char * key, size_t len)
+{
+    return js_builder_setkey_(arg, key, len, false);
+}
+
+static int
+js_builder_string_(void * arg, const char * str, size_t len)
+{
+    return js_builder_value_(arg, js_string_new_len_(str, len));
+}
+
+static int
+js_builder_raw_(struct js_builder * b, const char * raw, size_t len,
+                int flags, bool key)
+{
+    bool escaped = (flags & JS_STR_F_ESCAPED) != 0;
+
+    if ((b->flags & LZ_JSON_PARSE_ZEROCOPY) && !(flags & (JS_STR_F_ESCAPED | JS_STR_F_STASHED)))
+    {
+        if (key == true)
+        {
+            b->key_view = raw;
+            b->key_idx  = len;
+            return 0;
+        }
+
+        return js_builder_value_(b, js_string_new_view_(raw, len));
+    }
+
+    if (key == true)
+    {
+        return js_builder_setkey_(b, raw, len, escaped);
+    }
+
+    return js_builder_value_(b, js_string_new_raw_(raw, len, escaped));
+}
+
+static int
+js_builder_number_(void * arg, const char * text, size_t len)
+{
+    struct js_num num;
+
+    if (js_num_parse_(text, len, &num) != (ssize_t)len)
+    {
+        return -1;
+    }
+
+    return js_builder_value_(arg, js_num_new_(&num));
+}
+
+static int
+js_builder_boolean_(void * arg, bool boolean)
+{
+    return js_builder_value_(arg, js_boolean_new_(boolean));
+}
+
+static int
+js_builder_null_(void * arg)
+{
+    return js_builder_value_(arg, js_null_new_());
+}
+
+static const lz_json_events js_builder_events_ = {
+    .on_object_start = js_builder_object_start_,
+    .on_object_end   = js_builder_end_,
+    .on_array_start  = js_builder_array_start_,
+    .on_array_end    = js_builder_end_,
+    .on_key          = js_builder_key_,
+    .on_string       = js_builder_string_,
+    .on_number       = js_builder_number_,
+    .on_boolean      = js_builder_boolean_,
+    .on_null         = js_builder_null_
+};
+
+static lz_json_parser *
+js_parser_new_events_(const lz_json_events * events, void * arg)
+{
+    lz_json_parser * p;
+
+    if (lz_unlikely(events == NULL))
+    {
+        return NULL;
+    }
+
+    if (!(p = malloc(sizeof(*p))))
+    {
+        return NULL;
+    }
+
+    js_parser_init_(p, events, arg);
+
+    return p;
+}
+
+static lz_json_parser *
+js_parser_new_flags_(int flags)
+{
+    lz_json_parser    * p;
+    struct js_builder * b;
+
+    if (!(b = calloc(1, sizeof(*b))))
+    {
+        return NULL;
+    }
+
+    b->flags = js_parse_flags_(flags);
+
+    if (!(p = js_parser_new_events_(&js_builder_events_, b)))
+    {
+        free(b);
+        return NULL;
+    }
+
+    p->builder = b;
+
+    return p;
+}
+
+static lz_json_parser *
+js_parser_new_(void)
+{
+    return js_parser_new_flags_(0);
+}
+
+static void
+js_parser_free_(lz_json_parser * p)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    if (p->builder != NULL)
+    {
+        js_builder_deinit_(p->builder);
+        free(p->builder);
+    }
+
+    js_parser_deinit_(p);
+    free(p);
+}
+
+static bool
+js_parser_complete_(lz_json_parser * p)
+{
+    if (lz_unlikely(p == NULL))
+    {
+        return false;
+    }
+
+    return p->state == lz_j_s_end && p->error == false;
+}
+
+/* objects built from then on take their keys from `keys` (NULL to stop) */
+static int
+js_parser_set_keys_(lz_json_parser * p, lz_json_keys * keys)
+{
+    if (lz_unlikely(p == NULL || p->builder == NULL))
+    {
+        return -1;
+    }
+
+    p->builder->keys = keys;
+
+    return 0;
+}
+
+static lz_json *
+js_parser_finish_(lz_json_parser * p, size_t * n_read)
+{
+    lz_json * js;
+
+    if (lz_unlikely(p == NULL))
+    {
+        return NULL;
+    }
+
+    if (n_read != NULL)
+    {
+        *n_read = p->n_read;
+    }
+
+    js = NULL;
+
+    if (p->builder != NULL)
+    {
+        if (js_parser_complete_(p) == true && p->stopped == false)
+        {
+            js               = p->builder->root;
+            p->builder->root = NULL;
+
+            if (js != NULL && p->builder->arena != NULL)
+            {
+                js->flags        |= JS_F_ARENA_OWNER;
+                p->builder->arena = NULL;
+            }
+        }
+
+        js_builder_clear_(p->builder);
+    }
+
+    js_parser_reset_(p);
+
+    return js;
+}
+
+static int
+js_parse_events_(const char * data, size_t len,
+                 const lz_json_events * events, void * arg, size_t * n_read)
+{
+    lz_json_parser p;
+    int            res;
+
+    if (lz_unlikely(events == NULL))
+    {
+        return -1;
+    }
+
+    js_parser_init_(&p, events, arg);
+
+    js_parser_feed_(&p, data, len);
+
+    if (js_parser_complete_(&p) == false)
+    {
+        res = -1;
+    } else {
+        res = (p.stopped == true) ? 1 : 0;
+    }
+
+    if (n_read != NULL)
+    {
+        *n_read += p.n_read;
+    }
+
+    js_parser_deinit_(&p);
+
+    return res;
+}
+
+/* runs the tree builder over a single object or array at data[0], `consumed`
+ * is set to the number of bytes which made up the value.
+ */
+static lz_json *
+js_parse_tree_(const char * data, size_t len, int flags, size_t * consumed)
+{
+    lz_json_parser    p;
+    struct js_builder b;
+    lz_json         * js;
+
+    memset(&b, 0, sizeof(b));
+    b.flags = js_parse_flags_(flags);
+
+    js_parser_init_(&p, &js_builder_events_, &b);
+    p.builder = &b;
+
+    js_parser_feed_(&p, data, len);
+
+    js = js_parser_finish_(&p, consumed);
+
+    js_builder_deinit_(&b);
+    js_parser_deinit_(&p);
+
+    return js;
+}
+
+static lz_json *
+js_parse_array_(const char * data, size_t len, size_t * n_read)
+{
+    lz_json * js;
+    size_t    b_read;
+
+    if (!data || !len || *data != '[')
+    {
+        return NULL;
+    }
+
+    js = js_parse_tree_(data, len, 0, &b_read);
+
+    /* like the other value parsers, this stops short of the last byte */
+    *n_read += b_read ? b_read - 1 : 0;
+
+    return js;
+}
+
+static lz_json *
+js_parse_object_(const char * data, size_t len, size_t * n_read)
+{
+    lz_json * js;
+    size_t    b_read;
+
+    if (!data || !len || *data != '{')
+    {
+        return NULL;
+    }
+
+    js = js_parse_tree_(data, len, 0, &b_read);
+
+    *n_read += b_read ? b_read - 1 : 0;
+
+    return js;
+}
+
+static lz_json *
+js_parse_buf_flags_(const char * data, size_t len, size_t * n_read, int flags)
+{
+    lz_json * js;
+    size_t    b_read;
+
+    if (lz_unlikely(data == NULL))
+    {
+        return NULL;
+    }
+
+    if (flags & LZ_JSON_PARSE_LAZY)
+    {
+        js = js_parse_lazy_(data, len, flags, &b_read);
+    } else {
+        js = js_parse_tree_(data, len, flags, &b_read);
+    }
+
+    if (js == NULL)
+    {
+        *n_read += b_read;
+        return NULL;
+    }
+
+    /* anything after the top-level value is skipped over */
+    *n_read += len;
+
+    return js;
+}
+
+static lz_json *
+js_parse_buf_(const char * data, size_t len, size_t * n_read)
+{
+    return js_parse_buf_flags_(data, len, n_read, 0);
+}
+
+/* reads all of `fd` into a buffer, for files which cannot be mapped */
+static char *
+js_read_fd_(int fd, size_t * len)
+{
+    char  * buf;
+    char  * nbuf;
+    size_t  cap;
+    ssize_t res;
+
+    cap  = 64 * 1024;
+    *len = 0;
+
+    if (!(buf = malloc(cap)))
+    {
+        return NULL;
+    }
+
+    while ((res = read(fd, buf + *len, cap - *len)) != 0)
+    {
+        if (res == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            free(buf);
+            return NULL;
+        }
+
+        *len += (size_t)res;
+
+        if (*len == cap)
+        {
+            if (!(nbuf = realloc(buf, cap * 2)))
+            {
+                free(buf);
+                return NULL;
+            }
+
+            buf  = nbuf;
+            cap *= 2;
+        }
+    }
+
+    return buf;
+}
+
+/* parses a file straight out of a read-only mapping of it. Without
+ * LZ_JSON_PARSE_ZEROCOPY the mapping goes away once the document is built,
+ * with it the document's arena takes the mapping over and unmaps it when the
+ * root is freed.
+ *
+ * Files which cannot be mapped (pipes, or /proc files without a size) are
+ * read into memory instead, and their strings are always copied.
+ */
+static lz_json *
+js_parse_file_flags_(const char * filename, size_t * bytes_read, int flags)
+{
+    struct stat st;
+    lz_json   * json   = NULL;
+    char      * buf    = NULL;
+    void      * map    = MAP_FAILED;
+    size_t      len    = 0;
+    size_t      n_read = 0;
+    int         fd;
+
+    if (filename == NULL)
+    {
+        return NULL;
+    }
+
+    if ((fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1)
+    {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        len = (size_t)st.st_size;
+#ifdef MAP_POPULATE
+        map = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+#else
+        map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+#endif
+    }
+
+    do {
+        if (map != MAP_FAILED)
+        {
+#ifdef MADV_SEQUENTIAL
+            madvise(map, len, MADV_SEQUENTIAL);
+#endif
+            json = js_parse_buf_flags_(map, len, &n_read, flags);
+
+            if (json != NULL && (flags & LZ_JSON_PARSE_ZEROCOPY) &&
+                (json->flags & JS_F_ARENA_OWNER))
+            {
+                json->arena->map     = map;
+                json->arena->map_len = len;
+                map = MAP_FAILED;
+            }
+
+            break;
+        }
+
+        if (!(buf = js_read_fd_(fd, &len)))
+        {
+            break;
+        }
+
+        json = js_parse_buf_flags_(buf, len, &n_read, flags & ~LZ_JSON_PARSE_ZEROCOPY);
+    } while (0);
+
+    if (map != MAP_FAILED)
+    {
+        munmap(map, len);
+    }
+
+    close(fd);
+
+    *bytes_read = n_read;
+
+    lz_safe_free(buf, free);
+    return json;
+} /* js_parse_file_flags_ */
+
+static lz_json *
+js_parse_file_(const char * filename, size_t * bytes_read)
+{
+    return js_parse_file_flags_(filename, bytes_read, 0);
+}
+
+/* newline delimited JSON: one object or array per line. Every record is
+ * built in the reader's arena, which is reset for the next one, so once the
+ * arena and the read buffer have grown to fit the largest record, reading
+ * does not allocate at all.
+ */
+struct lz_json_ndjson_s {
+    lz_json_parser  * parser;
+    struct js_arena * arena;
+    const char      * data;     /* the buffer being read, or `buf` */
+    size_t            len;
+    size_t            pos;      /* the start of the next line in `data` */
+    size_t            base;     /* the stream offset of data[0] */
+    size_t            offset;   /* the stream offset of the last record */
+    char            * buf;      /* LZ_JSON_NDJSON_FD: the read buffer */
+    size_t            buf_len;
+    int               fd;
+    bool              eof;
+};
+
+#define JS_NDJSON_BUF_MIN (64 * 1024)
+
+static lz_json_ndjson *
+js_ndjson_new_(int flags)
+{
+    lz_json_ndjson * nd;
+
+    if (!(nd = calloc(1, sizeof(*nd))))
+    {
+        return NULL;
+    }
+
+    nd->fd = -1;
+
+    if (!(nd->parser = js_parser_new_flags_(0)) || !(nd->arena = js_arena_new_()))
+    {
+        lz_safe_free(nd->parser, js_parser_free_);
+        free(nd);
+        return NULL;
+    }
+
+    /* the reader enters its own arena around every record, so the builder
+     * must not make one of its own.
+     */
+    nd->parser->builder->flags = flags & LZ_JSON_PARSE_ZEROCOPY;
+
+    return nd;
+}
+
+static lz_json_ndjson *
+js_ndjson_new_buf_(const char * data, size_t len, int flags)
+{
+    lz_json_ndjson * nd;
+
+    if (lz_unlikely(data == NULL) || !(nd = js_ndjson_new_(flags)))
+    {
+        return NULL;
+    }
+
+    nd->data = data;
+    nd->len  = len;
+    nd->eof  = true;
+
+    return nd;
+}
+
+static lz_json_ndjson *
+js_ndjson_new_fd_(int fd, int flags)
+{
+    lz_json_ndjson * nd;
+
+    if (lz_unlikely(fd < 0) || !(nd = js_ndjson_new_(flags)))
+    {
+        return NULL;
+    }
+
+    if (!(nd->buf = malloc(JS_NDJSON_BUF_MIN)))
+    {
+        lz_safe_free(nd->parser, js_parser_free_);
+        lz_safe_free(nd->arena, js_arena_free_);
+        free(nd);
+        return NULL;
+    }
+
+    nd->fd      = fd;
+    nd->data    = nd->buf;
+    nd->buf_len = JS_NDJSON_BUF_MIN;
+
+    return nd;
+}
+
+static void
+js_ndjson_free_(lz_json_ndjson * nd)
+{
+    if (nd == NULL)
+    {
+        return;
+    }
+
+    lz_safe_free(nd->parser, js_parser_free_);
+    lz_safe_free(nd->arena, js_arena_free_);
+    lz_safe_free(nd->buf, free);
+
+    free(nd);
+}
+
+/* reads more of the file, moving the unread part to the front of the buffer
+ * first. Returns 0 at the end of the file.
+ */
+static ssize_t
+js_ndjson_fill_(lz_json_ndjson * nd)
+{
+    ssize_t res;
+    char  * nbuf;
+
+    if (nd->pos > 0)
+    {
+        memmove(nd->buf, nd->buf + nd->pos, nd->len - nd->pos);
+
+        nd->base += nd->pos;
+        nd->len  -= nd->pos;
+        nd->pos   = 0;
+    }
+
+    /* a line longer than the buffer */
+    if (nd->len == nd->buf_len)
+    {
+        if (!(nbuf = realloc(nd->buf, nd->buf_len * 2)))
+        {
+            return -1;
+        }
+
+        nd->buf      = nbuf;
+        nd->data     = nbuf;
+        nd->buf_len *= 2;
+    }
+
+    do {
+        res = read(nd->fd, nd->buf + nd->len, nd->buf_len - nd->len);
+    } while (res == -1 && errno == EINTR);
+
+    if (res > 0)
+    {
+        nd->len += (size_t)res;
+    }
+
+    return res;
+}
+
+static inline bool
+js_ndjson_blank_(const char * data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        switch (data[i]) {
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+                continue;
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/* builds the record on one line in the current arena */
+static lz_json *
+js_ndjson_build_(lz_json_parser * p, const char * line, size_t len)
+{
+    lz_json * js;
+    size_t    consumed;
+
+    js_parser_feed_(p, line, len);
+    js = js_parser_finish_(p, &consumed);
+
+    /* the value must be all there is on the line */
+    if (js != NULL && !js_ndjson_blank_(line + consumed, len - consumed))
+    {
+        return NULL;
+    }
+
+    return js;
+}
+
+/* builds the record on one line, valid until the arena is next reset */
+static lz_json *
+js_ndjson_parse_(lz_json_ndjson * nd, const char * line, size_t len)
+{
+    struct js_arena * prev;
+    lz_json         * js;
+
+    js_arena_reset_(nd->arena);
+
+    prev = js_arena_enter_(nd->arena);
+    js   = js_ndjson_build_(nd->parser, line, len);
+
+    js_arena_enter_(prev);
+
+    return js;
+}
+
+static int
+js_ndjson_next_(lz_json_ndjson * nd, lz_json ** record)
+{
+    const char * line;
+    const char * nl;
+    size_t       len;
+    ssize_t      res;
+
+    if (lz_unlikely(nd == NULL || record == NULL))
+    {
+        return -1;
+    }
+
+    *record = NULL;
+
+    for (;;)
+    {
+        nl = (nd->pos < nd->len) ?
+             memchr(nd->data + nd->pos, '\n', nd->len - nd->pos) : NULL;
+
+        if (nl == NULL && nd->eof == false)
+        {
+            if ((res = js_ndjson_fill_(nd)) == -1)
+            {
+                /* a read error ends the stream */
+                nd->eof = true;
+                nd->pos = nd->len;
+                return -1;
+            }
+
+            nd->eof = (res == 0);
+            continue;
+        }
+
+        if (nl == NULL && nd->pos == nd->len)
+        {
+            return 0;
+        }
+
+        /* the last line may not have a newline */
+        line        = nd->data + nd->pos;
+        len         = (nl != NULL) ? (size_t)(nl - line) : nd->len - nd->pos;
+        nd->offset  = nd->base + nd->pos;
+        nd->pos    += len + (nl != NULL);
+
+        if (js_ndjson_blank_(line, len))
+        {
+            continue;
+        }
+
+        if (!(*record = js_ndjson_parse_(nd, line, len)))
+        {
+            return -1;
+        }
+
+        return 1;
+    }
+} /* js_ndjson_next_ */
+
+static int
+js_ndjson_set_keys_(lz_json_ndjson * nd, lz_json_keys * keys)
+{
+    if (lz_unlikely(nd == NULL))
+    {
+        return -1;
+    }
+
+    return js_parser_set_keys_(nd->parser, keys);
+}
+
+static size_t
+js_ndjson_offset_(lz_json_ndjson * nd)
+{
+    if (lz_unlikely(nd == NULL))
+    {
+        return 0;
+    }
+
+    return nd->offset;
+}
+
+/* parallel NDJSON: the input is cut into chunks at line boundaries, and a
+ * pool of workers parses whole chunks, each into an arena of its own. The
+ * calling thread hands the records to the callback in input order, chunk by
+ * chunk, and each chunk's slot is reused once it has been delivered.
+ *
+ * Workers only run a fixed number of slots ahead of delivery, which bounds
+ * the memory held by parsed but undelivered records.
+ */
+#define JS_PAR_CHUNK_MIN   (64 * 1024)
+#define JS_PAR_CHUNK_MAX   (1024 * 1024)
+#define JS_PAR_SLOTS_EACH  4
+
+struct js_par_slot {
+    size_t            chunk; /* the chunk parsed into this slot, + 1 */
+    struct js_arena * arena;
+    lz_json        ** recs;  /* NULL for a line which was not a valid record */
+    size_t          * offs;
+    size_t            n_recs;
+    size_t            n_alloc;
+};
+
+struct js_par {
+    const char         * data;
+    size_t             * bounds; /* chunk i is data[bounds[i]] to data[bounds[i + 1]] */
+    size_t               n_chunks;
+    struct js_par_slot * slots;
+    size_t               n_slots;
+    size_t               next;      /* the next chunk to parse */
+    size_t               delivered; /* chunks the callback is done with */
+    int                  flags;
+    bool                 error;
+    pthread_mutex_t      lock;
+    pthread_cond_t       cond;
+};
+
+static int
+js_par_push_(struct js_par_slot * slot, lz_json * js, size_t off)
+{
+    lz_json ** recs;
+    size_t   * offs;
+    size_t     n;
+
+    if (slot->n_recs == slot->n_alloc)
+    {
+        n = slot->n_alloc ? slot->n_alloc * 2 : 256;
+
+        if (!(recs = realloc(slot->recs, n * sizeof(*recs))))
+        {
+            return -1;
+        }
+
+        slot->recs = recs;
+
+        if (!(offs = realloc(slot->offs, n * sizeof(*offs))))
+        {
+            return -1;
+        }
+
+        slot->offs    = offs;
+        slot->n_alloc = n;
+    }
+
+    slot->recs[slot->n_recs] = js;
+    slot->offs[slot->n_recs] = off;
+    slot->n_recs++;
+
+    return 0;
+}
+
+static int
+js_par_chunk_(struct js_par * par, lz_json_parser * p, struct js_par_slot * slot, size_t chunk)
+{
+    struct js_arena * prev;
+    const char      * line;
+    const char      * end;
+    const char      * nl;
+    size_t            len;
+    int               res;
+
+    js_arena_reset_(slot->arena);
+
+    slot->n_recs = 0;
+    res          = 0;
+    line         = par->data + par->bounds[chunk];
+    end          = par->data + par->bounds[chunk + 1];
+    prev         = js_arena_enter_(slot->arena);
+
+    for (; line < end; line += len + 1)
+    {
+        nl  = memchr(line, '\n', (size_t)(end - line));
+        len = (nl != NULL) ? (size_t)(nl - line) : (size_t)(end - line);
+
+        if (js_ndjson_blank_(line, len))
+        {
+            continue;
+        }
+
+        if (js_par_push_(slot, js_ndjson_build_(p, line, len),
+                         (size_t)(line - par->data)) == -1)
+        {
+            res = -1;
+            break;
+        }
+    }
+
+    js_arena_enter_(prev);
+
+    return res;
+}
+
+static void *
+js_par_worker_(void * arg)
+{
+    struct js_par      * par = arg;
+    struct js_par_slot * slot;
+    lz_json_parser     * p;
+    size_t               chunk;
+    int                  res;
+
+    if ((p = js_parser_new_flags_(0)) != NULL)
+    {
+        p->builder->flags = par->flags & LZ_JSON_PARSE_ZEROCOPY;
+    }
+
+    pthread_mutex_lock(&par->lock);
+
+    if (p == NULL)
+    {
+        par->error = true;
+        pthread_cond_broadcast(&par->cond);
+    }
+
+    while (par->error == false && par->next < par->n_chunks)
+    {
+        if (par->next >= par->delivered + par->n_slots)
+        {
+            pthread_cond_wait(&par->cond, &par->lock);
+            continue;
+        }
+
+        chunk = par->next++;
+        slot  = &par->slots[chunk % par->n_slots];
+
+        pthread_mutex_unlock(&par->lock);
+
+        res = js_par_chunk_(par, p, slot, chunk);
+
+        pthread_mutex_lock(&par->lock);
+
+        if (res == -1)
+        {
+            par->error = true;
+        }
+
+        slot->chunk = chunk + 1;
+        pthread_cond_broadcast(&par->cond);
+    }
+
+    pthread_mutex_unlock(&par->lock);
+
+    lz_safe_free(p, js_parser_free_);
+
+    return NULL;
+} /* js_par_worker_ */
+
+/* finds where every chunk starts, cutting after a newline */
+static int
+js_par_split_(struct js_par * par, size_t len, size_t n_threads)
+{
+    const char * nl;
+    size_t       chunk_len;
+    size_t       pos;
+    size_t       n;
+
+    chunk_len = len / (n_threads * JS_PAR_SLOTS_EACH);
+    chunk_len = (chunk_len < JS_PAR_CHUNK_MIN) ? JS_PAR_CHUNK_MIN : chunk_len;
+    chunk_len = (chunk_len > JS_PAR_CHUNK_MAX) ? JS_PAR_CHUNK_MAX : chunk_len;
+
+    if (!(par->bounds = malloc((len / chunk_len + 2) * sizeof(size_t))))
+    {
+        return -1;
+    }
+
+    for (n = 0, pos = 0; pos < len; n++)
+    {
+        par->bounds[n] = pos;
+
+        if (len - pos <= chunk_len || !(nl = memchr(par->data + pos + chunk_len, '\n', len - pos - chunk_len)))
+        {
+            pos = len;
+        } else {
+            pos = (size_t)(nl - par->data) + 1;
+        }
+    }
+
+    par->bounds[n] = len;
+    par->n_chunks  = n;
+
+    return 0;
+}
+
+static int
+js_ndjson_parallel_(const char * data, size_t len, int flags, int n_threads,
+                    lz_json_ndjson_cb cb, void * arg)
+{
+    struct js_par        par;
+    struct js_par_slot * slot;
+    pthread_t          * threads;
+    size_t               chunk;
+    size_t               i;
+    int                  n_started;
+    int                  res;
+
+    if (lz_unlikely(data == NULL || cb == NULL))
+    {
+        return -1;
+    }
+
+    if (n_threads <= 0 && (n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+    {
+        n_threads = 1;
+    }
+
+    memset(&par, 0, sizeof(par));
+
+    par.data    = data;
+    par.flags   = flags;
+    par.n_slots = (size_t)n_threads * JS_PAR_SLOTS_EACH;
+    res         = 0;
+    n_started   = 0;
+    threads     = NULL;
+
+    if (js_par_split_(&par, len, (size_t)n_threads) == -1 ||
+        !(par.slots = calloc(par.n_slots, sizeof(struct js_par_slot))) ||
+        !(threads = malloc((size_t)n_threads * sizeof(pthread_t))))
+    {
+        res = -1;
+        goto done;
+    }
+
+    for (i = 0; i < par.n_slots; i++)
+    {
+        if (!(par.slots[i].arena = js_arena_new_()))
+        {
+            res = -1;
+            goto done;
+        }
+    }
+
+    pthread_mutex_init(&par.lock, NULL);
+    pthread_cond_init(&par.cond, NULL);
+
+    for (; n_started < n_threads; n_started++)
+    {
+        if (pthread_create(&threads[n_started], NULL, js_par_worker_, &par) != 0)
+        {
+            break;
+        }
+    }
+
+    if (n_started == 0)
+    {
+        res = -1;
+    }
+
+    for (chunk = 0; res == 0 && chunk < par.n_chunks; chunk++)
+    {
+        slot = &par.slots[chunk % par.n_slots];
+
+        pthread_mutex_lock(&par.lock);
+
+        while (slot->chunk != chunk + 1 && par.error == false)
+        {
+            pthread_cond_wait(&par.cond, &par.lock);
+        }
+
+        if (par.error == true)
+        {
+            res = -1;
+        }
+
+        pthread_mutex_unlock(&par.lock);
+
+        for (i = 0; res == 0 && i < slot->n_recs; i++)
+        {
+            if (cb(slot->recs[i], slot->offs[i], arg) != 0)
+            {
+                res = 1;
+            }
+        }
+
+        pthread_mutex_lock(&par.lock);
+
+        par.delivered = chunk + 1;
+
+        if (res != 0)
+        {
+            /* stops the workers */
+            par.next = par.n_chunks;
+        }
+
+        pthread_cond_broadcast(&par.cond);
+        pthread_mutex_unlock(&par.lock);
+    }
+
+    for (i = 0; i < (size_t)n_started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&par.cond);
+    pthread_mutex_destroy(&par.lock);
+
+done:
+    for (i = 0; par.slots != NULL && i < par.n_slots; i++)
+    {
+        js_arena_free_(par.slots[i].arena);
+        free(par.slots[i].recs);
+        free(par.slots[i].offs);
+    }
+
+    free(par.slots);
+    free(par.bounds);
+    free(threads);
+
+    return res;
+} /* js_ndjson_parallel_ */
+
+static lz_json *
+js_get_array_index_(lz_json * array, int offset)
+{
+    if (lz_unlikely(array == NULL || array->type != lz_json_vtype_array) || js_lazy_(array) == -1)
+    {
+        return NULL;
+    }
+
+    if (offset < 0 || (size_t)offset >= array->array->len)
+    {
+        return NULL;
+    }
+
+    return array->array->items[offset];
+}
+
+/* path syntax shared by the lookup functions: keys are separated by '.', and
+ * an array index is written as "[n]", e.g. "b.[2].foo".
+ */
+struct js_path_seg {
+    const char * key;   /* NULL for an array index */
+    size_t       klen;
+    uint32_t     hash;  /* only set in compiled paths */
+    int          index;
+};
+
+/* splits the next segment off `path`, returns the rest of the path, or NULL
+ * if there are no segments left. A malformed segment (an index which is not
+ * a closed run of digits, an empty key, or anything but '.', '[' or the end
+ * after an index or a '.') is returned as an index of -1, which matches
+ * nothing.
+ */
+static const char *
+js_path_next_(const char * path, struct js_path_seg * seg)
+{
+    const char * start;
+
+    if (path == NULL || *path == '\0')
+    {
+        return NULL;
+    }
+
+    seg->hash = 0;
+
+    if (*path == '[')
+    {
+        start = ++path;
+
+        while (*path != '\0' && *path != ']')
+        {
+            path++;
+        }
+
+        seg->key   = NULL;
+        seg->klen  = 0;
+        seg->index = (path > start && *path == ']') ? 0 : -1;
+
+        for (; start < path && seg->index != -1; start++)
+        {
+            if (!isdigit((unsigned char)*start) || seg->index > (INT_MAX - 9) / 10)
+            {
+                seg->index = -1;
+            } else {
+                seg->index = seg->index * 10 + (*start - '0');
+            }
+        }
+
+        if (*path == ']')
+        {
+            path++;
+        }
+
+        if (*path != '\0' && *path != '.' && *path != '[')
+        {
+            seg->index = -1;
+        }
+    } else {
+        start = path;
+
+        while (*path != '\0' && *path != '.' && *path != '[')
+        {
+            path++;
+        }
+
+        seg->key   = start;
+        seg->klen  = (size_t)(path - start);
+        seg->index = -1;
+    }
+
+    if (seg->key != NULL && seg->klen == 0)
+    {
+        seg->key = NULL;
+    }
+
+    if (*path == '.' && *++path == '\0')
+    {
+        seg->key   = NULL;
+        seg->index = -1;
+    }
+
+    return path;
+}
+
+static lz_json *
+js_get_path_(lz_json * js, const char * path)
+{
+    struct js_path_seg seg;
+    lz_json          * cur;
+
+    if (lz_unlikely(js == NULL || path == NULL))
+    {
+        return NULL;
+    }
+
+    cur = js;
+
+    while ((path = js_path_next_(path, &seg)) != NULL)
+    {
+        if (seg.key != NULL)
+        {
+            cur = js_object_find_val_(cur, seg.key, seg.klen);
+        } else {
+            cur = js_get_array_index_(cur, seg.index);
+        }
+
+        if (cur == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    return (cur != js) ? cur : NULL;
+}
+
+/* a compiled path is one allocation: the segments, then their keys */
+struct lz_json_path_s {
+    size_t             n_segs;
+    struct js_path_seg segs[];
+};
+
+static lz_json_path *
+js_path_compile_(const char * path)
+{
+    struct js_path_seg seg;
+    lz_json_path     * cpath;
+    const char       * rest;
+    char             * keys;
+    size_t             n_segs;
+    size_t             klens;
+
+    if (lz_unlikely(path == NULL))
+    {
+        return NULL;
+    }
+
+    n_segs = 0;
+    klens  = 0;
+
+    for (rest = path; (rest = js_path_next_(rest, &seg)) != NULL; n_segs++)
+    {
+        if (seg.key == NULL && seg.index == -1)
+        {
+            return NULL;
+        }
+
+        klens += seg.klen;
+    }
+
+    if (!(cpath = malloc(sizeof(*cpath) + n_segs * sizeof(seg) + klens)))
+    {
+        return NULL;
+    }
+
+    cpath->n_segs = 0;
+    keys          = (char *)&cpath->segs[n_segs];
+
+    for (rest = path; (rest = js_path_next_(rest, &seg)) != NULL; cpath->n_segs++)
+    {
+        if (seg.key != NULL)
+        {
+            memcpy(keys, seg.key, seg.klen);
+
+            seg.key  = keys;
+            seg.hash = js_hash_(keys, seg.klen);
+            keys    += seg.klen;
+        }
+
+        cpath->segs[cpath->n_segs] = seg;
+    }
+
+    return cpath;
+} /* js_path_compile_ */
+
+/* follows the segments of `path` from the n'th one on, starting at `cur` */
+static lz_json *
+js_path_walk_(const lz_json_path * path, size_t n, lz_json * cur)
+{
+    const struct js_path_seg * seg;
+    ssize_t                    i;
+
+    for (; n < path->n_segs; n++)
+    {
+        seg = &path->segs[n];
+
+        if (seg->key == NULL)
+        {
+            cur = js_get_array_index_(cur, seg->index);
+        } else if (cur->type != lz_json_vtype_object || js_lazy_(cur) == -1 ||
+                   (i = js_object_find_hashed_(cur->object, seg->key, seg->klen, seg->hash)) == -1)
+        {
+            return NULL;
+        } else {
+            cur = js_object_val_(cur->object, (uint32_t)i);
+        }
+
+        if (cur == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    return cur;
+}
+
+/* the same as js_get_path_(), without parsing or hashing anything */
+static lz_json *
+js_path_eval_(const lz_json_path * path, lz_json * js)
+{
+    lz_json * cur;
+
+    if (lz_unlikely(path == NULL || js == NULL))
+    {
+        return NULL;
+    }
+
+    cur = js_path_walk_(path, 0, js);
+
+    return (cur != js) ? cur : NULL;
+}
+
+static void
+js_path_free_(lz_json_path * path)
+{
+    free(path);
+}
+
+/* columnar export: each column is filled row by row, with the rows' values
+ * at its path converted to the column's type. Records sharing a shape have
+ * their first key in the same slot, so each column remembers the slot it
+ * found for the last shape it saw instead of looking the key up again.
+ */
+struct js_column_cache {
+    struct js_shape * shape;
+    ssize_t           slot;
+};
+
+#define JS_COLUMN_BLOB_MIN 256
+
+static void
+js_columns_free_(lz_json_column * cols, size_t n_cols)
+{
+    size_t i;
+
+    if (cols == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < n_cols; i++)
+    {
+        free(cols[i].valid);
+        free(cols[i].ints); /* or any of the others */
+        free(cols[i].blob);
+
+        cols[i].valid    = NULL;
+        cols[i].ints     = NULL;
+        cols[i].blob     = NULL;
+        cols[i].blob_len = 0;
+        cols[i].len      = 0;
+        cols[i].n_null   = 0;
+    }
+}
+
+static int
+js_column_init_(lz_json_column * col, size_t len)
+{
+    size_t width;
+
+    switch (col->type) {
+        case lz_json_ctype_int:
+            width = sizeof(int64_t);
+            break;
+        case lz_json_ctype_double:
+            width = sizeof(double);
+            break;
+        case lz_json_ctype_string:
+            width = sizeof(size_t);
+            break;
+        default:
+            return -1;
+    }
+
+    col->len      = len;
+    col->n_null   = 0;
+    col->blob     = NULL;
+    col->blob_len = 0;
+    col->valid    = calloc((len + 7) / 8 + 1, 1);
+    col->ints     = calloc(len + 1, width);
+
+    if (col->valid == NULL || col->ints == NULL)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* the string column's blob has room for `len` more bytes */
+static int
+js_column_reserve_(lz_json_column * col, size_t * blob_cap, size_t len)
+{
+    size_t ncap;
+    char * nblob;
+
+    if (col->blob_len + len <= *blob_cap)
+    {
+        return 0;
+    }
+
+    for (ncap = *blob_cap ? *blob_cap * 2 : JS_COLUMN_BLOB_MIN; ncap < col->blob_len + len; ncap *= 2)
+    {
+        ;
+    }
+
+    if (!(nblob = realloc(col->blob, ncap)))
+    {
+        return -1;
+    }
+
+    col->blob = nblob;
+    *blob_cap = ncap;
+
+    return 0;
+}
+
+/* stores `val` in row `row`, or leaves the row null if there is no value of
+ * the column's type.
+ */
+static int
+js_column_put_(lz_json_column * col, size_t * blob_cap, size_t row, lz_json * val)
+{
+    struct js_num num;
+    bool          valid = false;
+
+    switch (col->type) {
+        case lz_json_ctype_int:
+            if (js_get_num_(val, &num) == 0 && num.type == lz_json_ntype_int)
+            {
+                col->ints[row] = num.i;
+                valid          = true;
+            }
+            break;
+        case lz_json_ctype_double:
+            if (js_get_num_(val, &num) == 0)
+            {
+                col->doubles[row] = js_num_double_(&num);
+                valid             = true;
+            }
+            break;
+        case lz_json_ctype_string:
+            if (val != NULL && val->type == lz_json_vtype_string && val->string != NULL)
+            {
+                if (js_column_reserve_(col, blob_cap, val->slen) == -1)
+                {
+                    return -1;
+                }
+
+                memcpy(col->blob + col->blob_len, val->string, val->slen);
+                col->blob_len += val->slen;
+                valid          = true;
+            }
+
+            col->offsets[row + 1] = col->blob_len;
+            break;
+        default:
+            return -1;
+    }
+
+    if (valid == true)
+    {
+        col->valid[row / 8] |= (uint8_t)(1 << (row % 8));
+    } else {
+        col->n_null += 1;
+    }
+
+    return 0;
+}
+
+static lz_json *
+js_column_value_(const lz_json_path * path, struct js_column_cache * cache, lz_json * row)
+{
+    const struct js_path_seg * seg;
+    struct js_object         * obj;
+    struct js_shape          * shape;
+
+    if (path->n_segs == 0 || path->segs[0].key == NULL ||
+        row->type != lz_json_vtype_object || (row->flags & JS_F_LAZY) ||
+        (shape = row->object->shape) == NULL)
+    {
+        return js_path_walk_(path, 0, row);
+    }
+
+    seg = &path->segs[0];
+    obj = row->object;
+
+    if (shape != cache->shape)
+    {
+        cache->shape = shape;
+        cache->slot  = js_entries_find_(shape->keys, shape->len, shape->index, shape->mask,
+                                        seg->key, seg->klen, seg->hash);
+    }
+
+    if (cache->slot == -1 || (uint32_t)cache->slot >= obj->len)
+    {
+        return NULL;
+    }
+
+    return js_path_walk_(path, 1, JS_OBJECT_VALS(obj)[cache->slot]);
+}
+
+static int
+js_to_columns_(lz_json * arr, lz_json_column * cols, size_t n_cols)
+{
+    struct js_column_cache * cache;
+    size_t                 * blob_caps;
+    size_t                   len;
+    size_t                   row;
+    size_t                   i;
+
+    if (lz_unlikely(arr == NULL || cols == NULL || n_cols == 0))
+    {
+        return -1;
+    }
+
+    if (arr->type != lz_json_vtype_array || js_lazy_(arr) == -1)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < n_cols; i++)
+    {
+        if (cols[i].path == NULL)
+        {
+            return -1;
+        }
+
+        cols[i].valid = NULL;
+        cols[i].ints  = NULL;
+        cols[i].blob  = NULL;
+    }
+
+    len       = arr->array->len;
+    cache     = calloc(n_cols, sizeof(*cache));
+    blob_caps = calloc(n_cols, sizeof(*blob_caps));
+
+    if (cache == NULL || blob_caps == NULL)
+    {
+        goto error;
+    }
+
+    for (i = 0; i < n_cols; i++)
+    {
+        if (js_column_init_(&cols[i], len) == -1)
+        {
+            goto error;
+        }
+    }
+
+    for (row = 0; row < len; row++)
+    {
+        for (i = 0; i < n_cols; i++)
+        {
+            if (js_column_put_(&cols[i], &blob_caps[i], row,
+                               js_column_value_(cols[i].path, &cache[i], arr->array->items[row])) == -1)
+            {
+                goto error;
+            }
+        }
+    }
+
+    free(cache);
+    free(blob_caps);
+
+    return 0;
+error:
+    free(cache);
+    free(blob_caps);
+
+    js_columns_free_(cols, n_cols);
+
+    return -1;
+} /* js_to_columns_ */
+
+static int
+js_add_(lz_json * obj, const char * key, lz_json * val)
+{
+    if (obj == NULL)
+    {
+        return -1;
+    }
+
+    if (key == NULL)
+    {
+        if (obj->type != lz_json_vtype_array)
+        {
+            return -1;
+        }
+
+        return js_array_add_(obj, val);
+    }
+
+    return js_object_add_(obj, key, val);
+}
+
+/* makes room for at least `len` more bytes in a dynamic buffer, doubling
+ * its size so that appending stays linear overall.
+ */
+static int
+js_addbuf_grow_(struct __jbuf * jbuf, size_t len)
+{
+    char * nbuf;
+    size_t nlen;
+
+    if (jbuf->dynamic != 1)
+    {
+        return -1;
+    }
+
+    nlen = jbuf->buf_len ? jbuf->buf_len * 2 : 256;
+
+    while (nlen < jbuf->buf_idx + len)
+    {
+        nlen *= 2;
+    }
+
+    if (!(nbuf = realloc(jbuf->buf, nlen)))
+    {
+        return -1;
+    }
+
+    jbuf->buf     = nbuf;
+    jbuf->buf_len = nlen;
+
+    return 0;
+}
+
+/* hands what is buffered to the sink, then buffers `buf`, or writes it
+ * straight through if it would not fit anyway.
+ */
+static int
+js_addbuf_flush_(struct __jbuf * jbuf, const char * buf, size_t len)
+{
+    if (jbuf->buf_idx > 0 && jbuf->sink(jbuf->buf, jbuf->buf_idx, jbuf->sink_arg) == -1)
+    {
+        return -1;
+    }
+
+    jbuf->buf_idx  = 0;
+    jbuf->written += len;
+
+    if (len >= jbuf->buf_len)
+    {
+        return jbuf->sink(buf, len, jbuf->sink_arg);
+    }
+
+    memcpy(jbuf->buf, buf, len);
+
+    jbuf->buf_idx = len;
+
+    return 0;
+}
+
+static int
+js_addbuf_(struct __jbuf * jbuf, const char * buf, size_t len)
+{
+    if (lz_unlikely(jbuf == NULL))
+    {
+        return -1;
+    }
+
+    if (len == 0 || buf == NULL)
+    {
+        return 0;
+    }
+
+    if (jbuf->count_only == true)
+    {
+        jbuf->written += len;
+        return 0;
+    }
+
+    if ((jbuf->buf_idx + len) > jbuf->buf_len)
+    {
+        if (jbuf->sink != NULL)
+        {
+            return js_addbuf_flush_(jbuf, buf, len);
+        }
+
+        if (js_addbuf_grow_(jbuf, len) == -1)
+        {
+            return -1;
+        }
+    }
+
+    memcpy(&jbuf->buf[jbuf->buf_idx], buf, len);
+
+    jbuf->buf_idx += len;
+    jbuf->written += len;
+
+    return 0;
+}
+
+static const char digits[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* writes `num` backwards ending at `end`, returns where it starts */
+static char *
+js_utoa_(char * end, uint64_t num)
+{
+    unsigned index;
+
+    while (num >= 100)
+    {
+        index  = (unsigned)(num % 100) * 2;
+        num   /= 100;
+
+        *--end = digits[index + 1];
+        *--end = digits[index];
+    }
+
+    if (num < 10)
+    {
+        *--end = (char)('0' + num);
+    } else {
+        index  = (unsigned)(num * 2);
+
+        *--end = digits[index + 1];
+        *--end = digits[index];
+    }
+
+    return end;
+}
+
+/* writes the shortest text which reads back as the finite double `d`.
+ * Integral values get a ".0" so they are read back as doubles, and very
+ * large or small ones use an exponent. `buf` must hold 32 bytes.
+ */
+static size_t
+js_dtoa_(double d, char * buf)
+{
+    char     dbuf[24];
+    char   * dstart;
+    char   * p;
+    uint64_t dec;
+    int      exp10;
+    int      ndig;
+    int      pt;
+
+    p = buf;
+
+    if (signbit(d))
+    {
+        *p++ = '-';
+        d    = -d;
+    }
+
+    if (d == 0)
+    {
+        memcpy(p, "0.0", 3);
+        return (size_t)(p - buf) + 3;
+    }
+
+    js_schubfach_(d, &dec, &exp10);
+
+    dstart = js_utoa_(dbuf + sizeof(dbuf), dec);
+    ndig   = (int)(dbuf + sizeof(dbuf) - dstart);
+
+    /* the position of the decimal point relative to the digits */
+    pt     = ndig + exp10;
+
+    if (pt > 21 || pt < -5)
+    {
+        *p++ = dstart[0];
+
+        if (ndig > 1)
+        {
+            *p++ = '.';
+            memcpy(p, dstart + 1, ndig - 1);
+            p   += ndig - 1;
+        }
+
+        *p++ = 'e';
+
+        if (pt - 1 < 0)
+        {
+            *p++ = '-';
+        }
+
+        dstart = js_utoa_(dbuf + sizeof(dbuf), (uint64_t)abs(pt - 1));
+        memcpy(p, dstart, dbuf + sizeof(dbuf) - dstart);
+        p     += dbuf + sizeof(dbuf) - dstart;
+    } else if (pt <= 0)
+    {
+        memcpy(p, "0.", 2);
+        memset(p + 2, '0', -pt);
+        memcpy(p + 2 - pt, dstart, ndig);
+        p += 2 - pt + ndig;
+    } else if (pt < ndig)
+    {
+        memcpy(p, dstart, pt);
+        p[pt] = '.';
+        memcpy(p + pt + 1, dstart + pt, ndig - pt);
+        p    += ndig + 1;
+    } else {
+        memcpy(p, dstart, ndig);
+        memset(p + ndig, '0', pt - ndig);
+        memcpy(p + pt, ".0", 2);
+        p += pt + 2;
+    }
+
+    return (size_t)(p - buf);
+} /* js_dtoa_ */
+
+static int
+js_addbuf_number_(struct __jbuf * jbuf, struct js_num * num)
+{
+    char   buf[32]; /* -9223372036854775808, or a double from js_dtoa_() */
+    char * start;
+
+    if (lz_unlikely(jbuf == NULL))
+    {
+        return -1;
+    }
+
+    switch (num->type) {
+        case lz_json_ntype_int:
+            start = js_utoa_(buf + sizeof(buf),
+                             (num->i < 0) ? 0 - (uint64_t)num->i : (uint64_t)num->i);
+
+            if (num->i < 0)
+            {
+                *--start = '-';
+            }
+            break;
+        case lz_json_ntype_uint:
+            start = js_utoa_(buf + sizeof(buf), num->u);
+            break;
+        default:
+            /* JSON has no way to write these */
+            if (!isfinite(num->d))
+            {
+                return js_addbuf_(jbuf, "null", 4);
+            }
+
+            return js_addbuf_(jbuf, buf, js_dtoa_(num->d, buf));
+    }
+
+    return js_addbuf_(jbuf, start, (size_t)(buf + sizeof(buf) - start));
+}
+
+static int
+js_number_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    struct js_num num;
+
+    if (js_get_num_(json, &num) == -1)
+    {
+        return -1;
+    }
+
+    return js_addbuf_number_(jbuf, &num);
+}
+
+/* the character following the backslash for every byte which must be
+ * escaped, 'u' for the ones written as \u00XX.
+ */
+static const char js_escape_lut_[256] = {
+    [0x00 ... 0x07] = 'u',
+    ['\b']          = 'b',
+    ['\t']          = 't',
+    ['\n']          = 'n',
+    [0x0b]          = 'u',
+    ['\f']          = 'f',
+    ['\r']          = 'r',
+    [0x0e ... 0x1f] = 'u',
+    ['"']           = '"',
+    ['\\']          = '\\'
+};
+
+static int
+js_escape_string_(const char * str, size_t len, struct __jbuf * jbuf)
+{
+    static const char hex[] = "0123456789abcdef";
+    unsigned char     ch;
+    size_t            i;
+    size_t            run;
+    char              esc[6];
+
+    if (lz_unlikely(str == NULL || jbuf == NULL))
+    {
+        return -1;
+    }
+
+    i = 0;
+
+    while (i < len)
+    {
+        /* the string scanner stops on exactly the bytes which need escaping,
+         * so everything up to there is copied in one go.
+         */
+        run = js_scan_string_(str + i, len - i);
+
+        if (js_addbuf_(jbuf, str + i, run) == -1)
+        {
+            return -1;
+        }
+
+        if ((i += run) == len)
+        {
+            break;
+        }
+
+        ch     = (unsigned char)str[i++];
+        esc[0] = '\\';
+        esc[1] = js_escape_lut_[ch];
+
+        if (esc[1] != 'u')
+        {
+            if (js_addbuf_(jbuf, esc, 2) == -1)
+            {
+                return -1;
+            }
+
+            continue;
+        }
+
+        esc[2] = '0';
+        esc[3] = '0';
+        esc[4] = hex[ch >> 4];
+        esc[5] = hex[ch & 0xf];
+
+        if (js_addbuf_(jbuf, esc, 6) == -1)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+} /* js_escape_string_ */
+
+/* strings shorter than this are cheaper to copy than to reference */
+#define JS_IOV_REF_MIN 256
+
+/* limits.h only has it with the X/Open extensions, 1024 is what Linux and
+ * the BSDs use.
+ */
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static int
+js_iov_push_(lz_json_iov * iov, const char * base, size_t len)
+{
+    struct iovec * vec;
+    size_t         n;
+
+    if (iov->n_vec == iov->n_alloc)
+    {
+        n = iov->n_alloc ? iov->n_alloc * 2 : 16;
+
+        if (!(vec = realloc(iov->vec, n * sizeof(struct iovec))))
+        {
+            return -1;
+        }
+
+        iov->vec     = vec;
+        iov->n_alloc = n;
+    }
+
+    iov->vec[iov->n_vec].iov_base = (void *)base;
+    iov->vec[iov->n_vec].iov_len  = len;
+    iov->n_vec++;
+
+    return 0;
+}
+
+/* ends the current staged run, if there is one */
+static int
+js_iov_stage_(struct __jbuf * jbuf)
+{
+    lz_json_iov * iov = jbuf->iov;
+
+    if (jbuf->buf_idx > iov->run && js_iov_push_(iov, NULL, jbuf->buf_idx - iov->run) == -1)
+    {
+        return -1;
+    }
+
+    iov->run = jbuf->buf_idx;
+
+    return 0;
+}
+
+/* references `len` bytes of `str` in place of copying them */
+static int
+js_addbuf_ref_(struct __jbuf * jbuf, const char * str, size_t len)
+{
+    if (js_iov_stage_(jbuf) == -1 || js_iov_push_(jbuf->iov, str, len) == -1)
+    {
+        return -1;
+    }
+
+    jbuf->written += len;
+
+    return 0;
+}
+
+/* writes a string body, escaped unless the buffer says otherwise */
+static int
+js_addbuf_string_(struct __jbuf * jbuf, const char * str, size_t len)
+{
+    if (jbuf->iov != NULL && len >= JS_IOV_REF_MIN &&
+        (jbuf->escape == false || js_scan_string_(str, len) == len))
+    {
+        return js_addbuf_ref_(jbuf, str, len);
+    }
+
+    if (jbuf->escape == true)
+    {
+        return js_escape_string_(str, len, jbuf);
+    }
+
+    return js_addbuf_(jbuf, str, len);
+}
+
+static int
+js_string_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    const char * str;
+
+    if (lz_unlikely(json == NULL))
+    {
+        return -1;
+    }
+
+    if (json->type != lz_json_vtype_string)
+    {
+        return -1;
+    }
+
+    str = json->string;
+
+    if ((str = json->string) == NULL)
+    {
+        return -1;
+    }
+
+    if (js_addbuf_(jbuf, "\"", 1) == -1)
+    {
+        return -1;
+    }
+
+    if (js_addbuf_string_(jbuf, str, json->slen) == -1)
+    {
+        return -1;
+    }
+
+    return js_addbuf_(jbuf, "\"", 1);
+}
+
+static int
+js_boolean_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    if (lz_unlikely(json == NULL))
+    {
+        return -1;
+    }
+
+    if (json->type != lz_json_vtype_bool)
+    {
+        return -1;
+    }
+
+    if (json->boolean == true)
+    {
+        return js_addbuf_(jbuf, "true", 4);
+    }
+
+    return js_addbuf_(jbuf, "false", 5);
+}
+
+static int
+js_null_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    if (lz_unlikely(json == NULL))
+    {
+        return -1;
+    }
+
+    if (json->type != lz_json_vtype_null)
+    {
+        return -1;
+    }
+
+    return js_addbuf_(jbuf, "null", 4);
+}
+
+static int
+js_array_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    struct js_array * array;
+    size_t            i;
+
+    if (lz_unlikely(!json || !jbuf))
+    {
+        return -1;
+    }
+
+    if (json->type != lz_json_vtype_array || js_lazy_(json) == -1)
+    {
+        return -1;
+    }
+
+    array = json->array;
+
+    if (js_addbuf_(jbuf, "[", 1) == -1)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < array->len; i++)
+    {
+        if (i > 0 && js_addbuf_(jbuf, ",", 1) == -1)
+        {
+            return -1;
+        }
+
+        if (js_json_to_buffer_(array->items[i], jbuf) == -1)
+        {
+            return -1;
+        }
+    }
+
+    if (js_addbuf_(jbuf, "]", 1) == -1)
+    {
+        return -1;
+    }
+
+    return 0;
+} /* js_array_to_buffer_ */
+
+static int
+js_object_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    struct js_object * obj;
+    struct js_entry  * ent;
+    const uint32_t   * off;
+    uint32_t           i;
+
+    if (lz_unlikely(json == NULL))
+    {
+        return -1;
+    }
+
+    if (json->type != lz_json_vtype_object || js_lazy_(json) == -1)
+    {
+        return -1;
+    }
+
+    obj = json->object;
+
+    /* a shape has the text of its keys, separators included, ready */
+    if (obj->shape != NULL && obj->shape->text != NULL && obj->len > 0)
+    {
+        off = obj->shape->text_off;
+
+        for (i = 0; i < obj->len; i++)
+        {
+            if (js_addbuf_(jbuf, obj->shape->text + off[i], off[i + 1] - off[i]) == -1)
+            {
+                return -1;
+            }
+
+            if (js_json_to_buffer_(JS_OBJECT_VALS(obj)[i], jbuf) == -1)
+            {
+                return -1;
+            }
+        }
+
+        return js_addbuf_(jbuf, "}", 1);
+    }
+
+    if (js_addbuf_(jbuf, "{", 1) == -1)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < obj->len; i++)
+    {
+        ent = &JS_OBJECT_KEYS(obj)[i];
+
+        if (i > 0 && js_addbuf_(jbuf, ",", 1) == -1)
+        {
+            return -1;
+        }
+
+        if (js_addbuf_(jbuf, "\"", 1) == -1)
+        {
+            return -1;
+        }
+
+        if (js_addbuf_string_(jbuf, ent->key, ent->klen) == -1)
+        {
+            return -1;
+        }
+
+        if (js_addbuf_(jbuf, "\":", 2) == -1)
+        {
+            return -1;
+        }
+
+        if (js_json_to_buffer_(js_object_val_(obj, i), jbuf) == -1)
+        {
+            return -1;
+        }
+    }
+
+    if (js_addbuf_(jbuf, "}", 1) == -1)
+    {
+        return -1;
+    }
+
+    return 0;
+} /* js_object_to_buffer_ */
+
+static lz_json *
+js_parse_value_(const char * data, size_t len, size_t * n_read)
+{
+    if (data == NULL || len == 0)
+    {
+        return NULL;
+    }
+
+    switch (data[0]) {
+        case '"':
+            return js_parse_string_(data, len, n_read);
+        case '{':
+            return js_parse_object_(data, len, n_read);
+        case '[':
+            return js_parse_array_(data, len, n_read);
+        default:
+            if (isdigit((unsigned char)data[0]) || data[0] == '-')
+            {
+                return js_parse_number_(data, len, n_read);
+            }
+
+            switch (*data) {
+                case 't':
+                case 'f':
+                    return js_parse_boolean_(data, len, n_read);
+                case 'n':
+                    return js_parse_null_(data, len, n_read);
+            }
+    } /* switch */
+
+    /* *n_read = 0; */
+    return NULL;
+}
+
+static int
+js_json_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    switch (json->type) {
+        case lz_json_vtype_number:
+            return js_number_to_buffer_(json, jbuf);
+        case lz_json_vtype_array:
+            return js_array_to_buffer_(json, jbuf);
+        case lz_json_vtype_object:
+            return js_object_to_buffer_(json, jbuf);
+        case lz_json_vtype_string:
+            return js_string_to_buffer_(json, jbuf);
+        case lz_json_vtype_bool:
+            return js_boolean_to_buffer_(json, jbuf);
+        case lz_json_vtype_null:
+            return js_null_to_buffer_(json, jbuf);
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
+static ssize_t
+js_to_buffer_(lz_json * json, char * buf, size_t buf_len)
+{
+    struct __jbuf jbuf = {
+        .buf     = buf,
+        .buf_idx = 0,
+        .written = 0,
+        .buf_len = buf_len,
+        .dynamic = 0,
+        .escape  = true
+    };
+
+    if (js_json_to_buffer_(json, &jbuf) == -1)
+    {
+        return -1;
+    }
+
+    return jbuf.written;
+}
+
+static ssize_t
+js_serialized_size_(lz_json * json)
+{
+    struct __jbuf jbuf = {
+        .buf        = NULL,
+        .buf_idx    = 0,
+        .written    = 0,
+        .buf_len    = 0,
+        .dynamic    = 0,
+        .escape     = true,
+        .count_only = true
+    };
+
+    if (lz_unlikely(json == NULL))
+    {
+        return -1;
+    }
+
+    if (js_json_to_buffer_(json, &jbuf) == -1)
+    {
+        return -1;
+    }
+
+    return jbuf.written;
+}
+
+static char *
+js_to_buffer_alloc_(lz_json * json, size_t * len)
+{
+    struct __jbuf jbuf = {
+        .buf     = NULL,
+        .buf_idx = 0,
+        .written = 0,
+        .buf_len = 0,
+        .dynamic = 1,
+        .escape  = true
+    };
+
+    if (!json || !len)
+    {
+        return NULL;
+    }
+
+    if (js_json_to_buffer_(json, &jbuf) == -1)
+    {
+        lz_safe_free(jbuf.buf, free);
+        return NULL;
+    }
+
+    *len = jbuf.written;
+
+    return jbuf.buf;
+}
+
+#define JS_SINK_CHUNK 16384
+
+/* serializes through a fixed buffer which is flushed to `cb` as it fills,
+ * so the output never has to be held in memory as a whole.
+ */
+static ssize_t
+js_to_cb_(lz_json * json, lz_json_writecb cb, void * arg)
+{
+    char          chunk[JS_SINK_CHUNK];
+    struct __jbuf jbuf = {
+        .buf      = chunk,
+        .buf_idx  = 0,
+        .written  = 0,
+        .buf_len  = sizeof(chunk),
+        .dynamic  = 0,
+        .escape   = true,
+        .sink     = cb,
+        .sink_arg = arg
+    };
+
+    if (lz_unlikely(json == NULL || cb == NULL))
+    {
+        return -1;
+    }
+
+    if (js_json_to_buffer_(json, &jbuf) == -1)
+    {
+        return -1;
+    }
+
+    if (jbuf.buf_idx > 0 && cb(jbuf.buf, jbuf.buf_idx, arg) == -1)
+    {
+        return -1;
+    }
+
+    return jbuf.written;
+}
+
+static int
+js_sink_fd_(const char * buf, size_t len, void * arg)
+{
+    int     fd = *(int *)arg;
+    ssize_t res;
+
+    while (len > 0)
+    {
+        if ((res = write(fd, buf, len)) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        buf += res;
+        len -= (size_t)res;
+    }
+
+    return 0;
+}
+
+static int
+js_sink_file_(const char * buf, size_t len, void * arg)
+{
+    if (fwrite(buf, 1, len, (FILE *)arg) != len)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static ssize_t
+js_to_fd_(lz_json * json, int fd)
+{
+    return js_to_cb_(json, js_sink_fd_, &fd);
+}
+
+static ssize_t
+js_to_file_(lz_json * json, FILE * fp)
+{
+    if (lz_unlikely(fp == NULL))
+    {
+        return -1;
+    }
+
+    return js_to_cb_(json, js_sink_file_, fp);
+}
+
+static void
+js_iov_free_(lz_json_iov * iov)
+{
+    if (iov == NULL)
+    {
+        return;
+    }
+
+    free(iov->staging);
+    free(iov->vec);
+    free(iov);
+}
+
+static lz_json_iov *
+js_to_iov_(lz_json * json)
+{
+    lz_json_iov * iov;
+    size_t        off;
+    size_t        i;
+    struct __jbuf jbuf = {
+        .buf     = NULL,
+        .buf_idx = 0,
+        .written = 0,
+        .buf_len = 0,
+        .dynamic = 1,
+        .escape  = true
+    };
+
+    if (lz_unlikely(json == NULL))
+    {
+        return NULL;
+    }
+
+    if (!(iov = calloc(1, sizeof(*iov))))
+    {
+        return NULL;
+    }
+
+    jbuf.iov = iov;
+
+    if (js_json_to_buffer_(json, &jbuf) == -1 || js_iov_stage_(&jbuf) == -1)
+    {
+        free(jbuf.buf);
+        js_iov_free_(iov);
+        return NULL;
+    }
+
+    iov->staging = jbuf.buf;
+    iov->len     = (size_t)jbuf.written;
+
+    /* the staging buffer has stopped moving, point the staged runs into it */
+    for (i = 0, off = 0; i < iov->n_vec; i++)
+    {
+        if (iov->vec[i].iov_base == NULL)
+        {
+            iov->vec[i].iov_base = iov->staging + off;
+            off += iov->vec[i].iov_len;
+        }
+    }
+
+    return iov;
+} /* js_to_iov_ */
+
+static const struct iovec *
+js_iov_vec_(lz_json_iov * iov, size_t * n_vec)
+{
+    if (lz_unlikely(iov == NULL || n_vec == NULL))
+    {
+        return NULL;
+    }
+
+    *n_vec = iov->n_vec;
+
+    return iov->vec;
+}
+
+static size_t
+js_iov_len_(lz_json_iov * iov)
+{
+    if (lz_unlikely(iov == NULL))
+    {
+        return 0;
+    }
+
+    return iov->len;
+}
+
+/* writes everything out in batches of at most IOV_MAX, picking up partial
+ * writes from where they stopped.
+ */
+static ssize_t
+js_iov_writev_(lz_json_iov * iov, int fd)
+{
+    struct iovec save;
+    size_t       idx;
+    size_t       off;
+    size_t       total;
+    ssize_t      res;
+    int          cnt;
+
+    if (lz_unlikely(iov == NULL))
+    {
+        return -1;
+    }
+
+    idx   = 0;
+    off   = 0;
+    total = 0;
+
+    while (idx < iov->n_vec)
+    {
+        cnt  = (iov->n_vec - idx > IOV_MAX) ? IOV_MAX : (int)(iov->n_vec - idx);
+        save = iov->vec[idx];
+
+        iov->vec[idx].iov_base = (char *)save.iov_base + off;
+        iov->vec[idx].iov_len  = save.iov_len - off;
+
+        res = writev(fd, &iov->vec[idx], cnt);
+
+        iov->vec[idx] = save;
+
+        if (res == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        total += (size_t)res;
+        res   += (ssize_t)off;
+
+        while (idx < iov->n_vec && (size_t)res >= iov->vec[idx].iov_len)
+        {
+            res -= (ssize_t)iov->vec[idx].iov_len;
+            idx++;
+        }
+
+        off = (size_t)res;
+    }
+
+    return (ssize_t)total;
+} /* js_iov_writev_ */
+
+/* MessagePack: the same values in a binary form, where every string and
+ * container is preceded by its length and numbers are stored as they are in
+ * memory (big-endian), so reading it back needs neither scanning for the
+ * end of anything nor converting digits. Integers take the smallest form
+ * which holds them, doubles stay doubles, and objects are maps with string
+ * keys.
+ */
+#define JS_MP_DEPTH_MAX 1024 /* the reader recurses, so nesting is bounded */
+
+static int
+js_mp_put_(struct __jbuf * jbuf, uint8_t tag, uint64_t val, size_t n)
+{
+    uint8_t buf[9];
+    size_t  i;
+
+    buf[0] = tag;
+
+    for (i = 0; i < n; i++)
+    {
+        buf[n - i] = (uint8_t)(val >> (8 * i));
+    }
+
+    return js_addbuf_(jbuf, (const char *)buf, n + 1);
+}
+
+/* the header of a string, array or map: `fix` holds lengths up to `fix_max`
+ * in the tag itself, the others have a length of 1 (strings only), 2 or 4
+ * bytes.
+ */
+static int
+js_mp_head_(struct __jbuf * jbuf, size_t len, uint8_t fix, size_t fix_max,
+            uint8_t tag8, uint8_t tag16, uint8_t tag32)
+{
+    if (len <= fix_max)
+    {
+        return js_mp_put_(jbuf, (uint8_t)(fix | len), 0, 0);
+    }
+
+    if (tag8 != 0 && len <= UINT8_MAX)
+    {
+        return js_mp_put_(jbuf, tag8, len, 1);
+    }
+
+    if (len <= UINT16_MAX)
+    {
+        return js_mp_put_(jbuf, tag16, len, 2);
+    }
+
+    if (len <= UINT32_MAX)
+    {
+        return js_mp_put_(jbuf, tag32, len, 4);
+    }
+
+    return -1;
+}
+
+static int
+js_mp_string_to_buffer_(struct __jbuf * jbuf, const char * str, size_t len)
+{
+    if (js_mp_head_(jbuf, len, 0xa0, 31, 0xd9, 0xda, 0xdb) == -1)
+    {
+        return -1;
+    }
+
+    return js_addbuf_(jbuf, str, len);
+}
+
+static int
+js_mp_number_to_buffer_(struct __jbuf * jbuf, lz_json * json)
+{
+    struct js_num num;
+    uint64_t      bits;
+
+    js_get_num_(json, &num);
+
+    switch (num.type) {
+        case lz_json_ntype_double:
+            memcpy(&bits, &num.d, sizeof(bits));
+            return js_mp_put_(jbuf, 0xcb, bits, 8);
+        case lz_json_ntype_uint:
+            return js_mp_put_(jbuf, 0xcf, num.u, 8);
+        default:
+            break;
+    }
+
+    if (num.i >= 0)
+    {
+        if (num.i <= 0x7f)
+        {
+            return js_mp_put_(jbuf, (uint8_t)num.i, 0, 0);
+        }
+
+        if (num.i <= UINT8_MAX)
+        {
+            return js_mp_put_(jbuf, 0xcc, (uint64_t)num.i, 1);
+        }
+
+        if (num.i <= UINT16_MAX)
+        {
+            return js_mp_put_(jbuf, 0xcd, (uint64_t)num.i, 2);
+        }
+
+        if (num.i <= UINT32_MAX)
+        {
+            return js_mp_put_(jbuf, 0xce, (uint64_t)num.i, 4);
+        }
+
+        return js_mp_put_(jbuf, 0xcf, (uint64_t)num.i, 8);
+    }
+
+    if (num.i >= -32)
+    {
+        return js_mp_put_(jbuf, (uint8_t)num.i, 0, 0);
+    }
+
+    if (num.i >= INT8_MIN)
+    {
+        return js_mp_put_(jbuf, 0xd0, (uint64_t)num.i, 1);
+    }
+
+    if (num.i >= INT16_MIN)
+    {
+        return js_mp_put_(jbuf, 0xd1, (uint64_t)num.i, 2);
+    }
+
+    if (num.i >= INT32_MIN)
+    {
+        return js_mp_put_(jbuf, 0xd2, (uint64_t)num.i, 4);
+    }
+
+    return js_mp_put_(jbuf, 0xd3, (uint64_t)num.i, 8);
+} /* js_mp_number_to_buffer_ */
+
+static int
+js_mp_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+{
+    struct js_object * obj;
+    struct js_entry  * ent;
+    size_t             i;
+
+    switch (json->type) {
+        case lz_json_vtype_number:
+            return js_mp_number_to_buffer_(jbuf, json);
+        case lz_json_vtype_string:
+            if (json->string == NULL)
+            {
+                return -1;
+            }
+
+            return js_mp_string_to_buffer_(jbuf, json->string, json->slen);
+        case lz_json_vtype_bool:
+            return js_mp_put_(jbuf, json->boolean ? 0xc3 : 0xc2, 0, 0);
+        case lz_json_vtype_null:
+            return js_mp_put_(jbuf, 0xc0, 0, 0);
+        case lz_json_vtype_array:
+            if (js_lazy_(json) == -1 ||
+                js_mp_head_(jbuf, json->array->len, 0x90, 15, 0, 0xdc, 0xdd) == -1)
+            {
+                return -1;
+            }
+
+            for (i = 0; i < json->array->len; i++)
+            {
+                if (js_mp_to_buffer_(json->array->items[i], jbuf) == -1)
+                {
+                    return -1;
+                }
+            }
+
+            return 0;
+        case lz_json_vtype_object:
+            if (js_lazy_(json) == -1 ||
+                js_mp_head_(jbuf, json->object->len, 0x80, 15, 0, 0xde, 0xdf) == -1)
+            {
+                return -1;
+            }
+
+            obj = json->object;
+
+            for (i = 0; i < obj->len; i++)
+            {
+                ent = &JS_OBJECT_KEYS(obj)[i];
+
+                if (js_mp_string_to_buffer_(jbuf, ent->key, ent->klen) == -1)
+                {
+                    return -1;
+                }
+
+                if (js_mp_to_buffer_(js_object_val_(obj, (uint32_t)i), jbuf) == -1)
+                {
+                    return -1;
+                }
+            }
+
+            return 0;
+        default:
+            return -1;
+    }
+} /* js_mp_to_buffer_ */
+
+static ssize_t
+js_to_msgpack_(lz_json * json, char * buf, size_t buf_len)
+{
+    struct __jbuf jbuf = {
+        .buf     = buf,
+        .buf_idx = 0,
+        .written = 0,
+        .buf_len = buf_len,
+        .dynamic = 0,
+        .escape  = false
+    };
+
+    if (lz_unlikely(json == NULL))
+    {
+        return -1;
+    }
+
+    if (js_mp_to_buffer_(json, &jbuf) == -1)
+    {
+        return -1;
+    }
+
+    return jbuf.written;
+}
+
+static char *
+js_to_msgpack_alloc_(lz_json * json, size_t * len)
+{
+    struct __jbuf jbuf = {
+        .buf     = NULL,
+        .buf_idx = 0,
+        .written = 0,
+        .buf_len = 0,
+        .dynamic = 1,
+        .escape  = false
+    };
+
+    if (!json || !len)
+    {
+        return NULL;
+    }
+
+    if (js_mp_to_buffer_(json, &jbuf) == -1)
+    {
+        lz_safe_free(jbuf.buf, free);
+        return NULL;
+    }
+
+    *len = jbuf.written;
+
+    return jbuf.buf;
+}
+
+static ssize_t
+js_to_msgpack_cb_(lz_json * json, lz_json_writecb cb, void * arg)
+{
+    char          chunk[JS_SINK_CHUNK];
+    struct __jbuf jbuf = {
+        .buf      = chunk,
+        .buf_idx  = 0,
+        .written  = 0,
+        .buf_len  = sizeof(chunk),
+        .dynamic  = 0,
+        .escape   = false,
+        .sink     = cb,
+        .sink_arg = arg
+    };
+
+    if (lz_unlikely(json == NULL || cb == NULL))
+    {
+        return -1;
+    }
+
+    if (js_mp_to_buffer_(json, &jbuf) == -1)
+    {
+        return -1;
+    }
+
+    if (jbuf.buf_idx > 0 && cb(jbuf.buf, jbuf.buf_idx, arg) == -1)
+    {
+        return -1;
+    }
+
+    return jbuf.written;
+}
+
+struct js_mp_reader {
+    const uint8_t * data;
+    size_t          len;
+    size_t          pos;
+    bool            zerocopy;
+};
+
+static int
+js_mp_get_(struct js_mp_reader * rd, size_t n, uint64_t * val)
+{
+    size_t i;
+
+    if (rd->len - rd->pos < n)
+    {
+        return -1;
+    }
+
+    for (*val = 0, i = 0; i < n; i++)
+    {
+        *val = (*val << 8) | rd->data[rd->pos++];
+    }
+
+    return 0;
+}
+
+/* the body of a string of `len` bytes, at the current position */
+static const char *
+js_mp_body_(struct js_mp_reader * rd, uint64_t len)
+{
+    const char * body;
+
+    if (rd->len - rd->pos < len)
+    {
+        return NULL;
+    }
+
+    body     = (const char *)rd->data + rd->pos;
+    rd->pos += (size_t)len;
+
+    return body;
+}
+
+/* the length of a string which starts with `tag`, -1 if it is not a string */
+static int
+js_mp_strlen_(struct js_mp_reader * rd, uint8_t tag, uint64_t * len)
+{
+    if ((tag & 0xe0) == 0xa0)
+    {
+        *len = tag & 0x1f;
+        return 0;
+    }
+
+    switch (tag) {
+        case 0xd9: /* str 8 */
+        case 0xc4: /* bin 8 */
+            return js_mp_get_(rd, 1, len);
+        case 0xda: /* str 16 */
+        case 0xc5: /* bin 16 */
+            return js_mp_get_(rd, 2, len);
+        case 0xdb: /* str 32 */
+        case 0xc6: /* bin 32 */
+            return js_mp_get_(rd, 4, len);
+        default:
+            return -1;
+    }
+}
+
+static lz_json * js_mp_value_(struct js_mp_reader *, size_t, struct js_shape *);
+
+static lz_json *
+js_mp_array_(struct js_mp_reader * rd, uint64_t n, size_t depth)
+{
+    lz_json * js;
+    lz_json * val;
+    uint64_t  i;
+
+    /* every value takes at least a byte, which bounds the allocation */
+    if (n > rd->len - rd->pos || !(js = js_new_(lz_json_vtype_array)))
+    {
+        return NULL;
+    }
+
+    if (js_array_init_(js, (size_t)n) == -1)
+    {
+        lz_safe_free(js, js_free_);
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (!(val = js_mp_value_(rd, depth + 1, js_shape_next_(js))))
+        {
+            lz_safe_free(js, js_free_);
+            return NULL;
+        }
+
+        if (js_array_add_(js, val) == -1)
+        {
+            lz_safe_free(val, js_free_);
+            lz_safe_free(js, js_free_);
+            return NULL;
+        }
+
+        if (val->type == lz_json_vtype_object)
+        {
+            /* if this fails, the object simply stays as it is */
+            js_shape_share_(js, val);
+        }
+    }
+
+    return js;
+}
+
+static lz_json *
+js_mp_map_(struct js_mp_reader * rd, uint64_t n, size_t depth, struct js_shape * shape)
+{
+    const char * key;
+    lz_json    * js;
+    lz_json    * val;
+    uint64_t     klen;
+    uint64_t     i;
+    int          res;
+
+    if (n > (rd->len - rd->pos) / 2 || !(js = js_new_(lz_json_vtype_object)))
+    {
+        return NULL;
+    }
+
+    if (shape != NULL)
+    {
+        res = js_object_init_shaped_(js, shape);
+    } else {
+        res = js_object_init_(js, (uint32_t)n);
+    }
+
+    if (res == -1)
+    {
+        lz_safe_free(js, js_free_);
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (rd->pos == rd->len ||
+            js_mp_strlen_(rd, rd->data[rd->pos++], &klen) == -1 ||
+            !(key = js_mp_body_(rd, klen)) || !(val = js_mp_value_(rd, depth + 1, NULL)))
+        {
+            lz_safe_free(js, js_free_);
+            return NULL;
+        }
+
+        if (js_object_put_(js, key, (size_t)klen, val,
+                           rd->zerocopy ? JS_KEY_BORROWED : JS_KEY_COPY) == -1)
+        {
+            lz_safe_free(val, js_free_);
+            lz_safe_free(js, js_free_);
+            return NULL;
+        }
+    }
+
+    return js;
+} /* js_mp_map_ */
+
+/* reads the value at the current position. A map takes `shape`, if set, as
+ * the keys it is expected to have.
+ */
+static lz_json *
+js_mp_value_(struct js_mp_reader * rd, size_t depth, struct js_shape * shape)
+{
+    const char * body;
+    uint64_t     val;
+    uint32_t     bits32;
+    uint8_t      tag;
+    double       real;
+    float        real32;
+
+    if (rd->pos == rd->len || depth > JS_MP_DEPTH_MAX)
+    {
+        return NULL;
+    }
+
+    tag = rd->data[rd->pos++];
+
+    if (tag <= 0x7f)
+    {
+        return js_int_new_(tag);
+    }
+
+    if (tag >= 0xe0)
+    {
+        return js_int_new_((int8_t)tag);
+    }
+
+    switch (tag & 0xf0) {
+        case 0x80:
+            return js_mp_map_(rd, tag & 0x0f, depth, shape);
+        case 0x90:
+            return js_mp_array_(rd, tag & 0x0f, depth);
+        default:
+            break;
+    }
+
+    if (js_mp_strlen_(rd, tag, &val) == 0)
+    {
+        if (!(body = js_mp_body_(rd, val)))
+        {
+            return NULL;
+        }
+
+        if (rd->zerocopy == true)
+        {
+            return js_string_new_view_(body, (size_t)val);
+        }
+
+        return js_string_new_raw_(body, (size_t)val, false);
+    }
+
+    switch (tag) {
+        case 0xc0:
+            return js_null_new_();
+        case 0xc2:
+            return js_boolean_new_(false);
+        case 0xc3:
+            return js_boolean_new_(true);
+        case 0xca:
+            if (js_mp_get_(rd, 4, &val) == -1)
+            {
+                return NULL;
+            }
+
+            bits32 = (uint32_t)val;
+            memcpy(&real32, &bits32, sizeof(real32));
+
+            return js_double_new_(real32);
+        case 0xcb:
+            if (js_mp_get_(rd, 8, &val) == -1)
+            {
+                return NULL;
+            }
+
+            memcpy(&real, &val, sizeof(real));
+
+            return js_double_new_(real);
+        case 0xcc:
+        case 0xcd:
+        case 0xce:
+        case 0xcf:
+            if (js_mp_get_(rd, (size_t)1 << (tag - 0xcc), &val) == -1)
+            {
+                return NULL;
+            }
+
+            return js_uint_new_(val);
+        case 0xd0:
+            return (js_mp_get_(rd, 1, &val) == -1) ? NULL : js_int_new_((int8_t)val);
+        case 0xd1:
+            return (js_mp_get_(rd, 2, &val) == -1) ? NULL : js_int_new_((int16_t)val);
+        case 0xd2:
+            return (js_mp_get_(rd, 4, &val) == -1) ? NULL : js_int_new_((int32_t)val);
+        case 0xd3:
+            return (js_mp_get_(rd, 8, &val) == -1) ? NULL : js_int_new_((int64_t)val);
+        case 0xdc:
+        case 0xdd:
+            if (js_mp_get_(rd, (tag == 0xdc) ? 2 : 4, &val) == -1)
+            {
+                return NULL;
+            }
+
+            return js_mp_array_(rd, val, depth);
+        case 0xde:
+        case 0xdf:
+            if (js_mp_get_(rd, (tag == 0xde) ? 2 : 4, &val) == -1)
+            {
+                return NULL;
+            }
+
+            return js_mp_map_(rd, val, depth, shape);
+        default:
+            /* 0xc1 is never used, and extension types have no equivalent */
+            return NULL;
+    }
+} /* js_mp_value_ */
+
+static lz_json *
+js_from_msgpack_(const char * data, size_t len, size_t * n_read, int flags)
+{
+    struct js_mp_reader rd;
+    struct js_arena   * arena;
+    struct js_arena   * prev;
+    lz_json           * js;
+
+    if (lz_unlikely(data == NULL))
+    {
+        return NULL;
+    }
+
+    flags = js_parse_flags_(flags);
+
+    rd.data     = (const uint8_t *)data;
+    rd.len      = len;
+    rd.pos      = 0;
+    rd.zerocopy = (flags & LZ_JSON_PARSE_ZEROCOPY) ? true : false;
+
+    if (!(flags & LZ_JSON_PARSE_ARENA))
+    {
+        js = js_mp_value_(&rd, 0, NULL);
+    } else if (!(arena = js_arena_new_()))
+    {
+        return NULL;
+    } else {
+        prev = js_arena_enter_(arena);
+        js   = js_mp_value_(&rd, 0, NULL);
+
+        js_arena_enter_(prev);
+
+        if (js == NULL)
+        {
+            js_arena_free_(arena);
+            return NULL;
+        }
+
+        js->flags |= JS_F_ARENA_OWNER;
+    }
+
+    if (js != NULL && n_read != NULL)
+    {
+        *n_read = rd.pos;
+    }
+
+    return js;
+} /* js_from_msgpack_ */
+
+static void
+js_print_(FILE * out, lz_json * json) {
+    if (json == NULL) {
+        fputs("{\"error\":-1}\n", out);
+        return;
+    }
+
+    if (js_to_file_(json, out) != -1) {
+        fputc('\n', out);
+    }
+}
+
+/* numbers are equal if their values are, whichever way they are stored */
+static int
+js_number_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    struct js_num n1;
+    struct js_num n2;
+
+    if (js_get_num_(j1, &n1) == -1 || js_get_num_(j2, &n2) == -1)
+    {
+        return -1;
+    }
+
+    if (n1.type == lz_json_ntype_double || n2.type == lz_json_ntype_double)
+    {
+        return (js_num_double_(&n1) == js_num_double_(&n2)) ? 0 : -1;
+    }
+
+    /* a uint is always above INT64_MAX, so it can only match another uint */
+    if (n1.type != n2.type || n1.u != n2.u)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/* returns the key of `ent` as a C string for lz_json_key_filtercb. A key
+ * borrowed from the input (LZ_JSON_PARSE_ZEROCOPY) is followed by its closing
+ * quote instead of a NUL, it is copied to `buf`, or the heap if it does not
+ * fit there.
+ */
+static char *
+js_entry_cstr_(struct js_entry * ent, char * buf, size_t buf_len)
+{
+    char * key;
+
+    if (ent->key[ent->klen] == '\0')
+    {
+        return ent->key;
+    }
+
+    if (ent->klen < buf_len)
+    {
+        key = buf;
+    } else if (!(key = malloc(ent->klen + 1)))
+    {
+        return NULL;
+    }
+
+    memcpy(key, ent->key, ent->klen);
+    key[ent->klen] = '\0';
+
+    return key;
+}
+
+static int
+js_array_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    size_t i;
+
+    if (j1 == NULL || j2 == NULL)
+    {
+        return -1;
+    }
+
+    if (j1->type != lz_json_vtype_array || j2->type != lz_json_vtype_array)
+    {
+        return -1;
+    }
+
+    /* a lazy array which fails to expand is unequal to anything */
+    if (js_lazy_(j1) == -1 || js_lazy_(j2) == -1)
+    {
+        return -1;
+    }
+
+    if (j1->array->len != j2->array->len)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < j1->array->len; i++)
+    {
+        if (js_compare_(j1->array->items[i], j2->array->items[i], cb) == -1)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+} /* _lz_j_array_compare */
+
+static int
+js_object_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    struct js_object * obj;
+    struct js_entry  * ent;
+    lz_json          * j1_val;
+    lz_json          * j2_val;
+    char             * key;
+    char               kbuf[256];
+    bool               same;
+    bool               skip;
+    uint32_t           i;
+
+    if (j1 == NULL || j2 == NULL)
+    {
+        return -1;
+    }
+
+    if (j1->type != lz_json_vtype_object || j2->type != lz_json_vtype_object)
+    {
+        return -1;
+    }
+
+    if (js_lazy_(j1) == -1 || js_lazy_(j2) == -1)
+    {
+        return -1;
+    }
+
+    obj = j1->object;
+
+    /* objects of one shape, with as many keys, have them in the same places */
+    same = (obj->shape != NULL && obj->shape == j2->object->shape && obj->len == j2->object->len);
+
+    for (i = 0; i < obj->len; i++)
+    {
+        ent    = &JS_OBJECT_KEYS(obj)[i];
+        j1_val = js_object_val_(obj, i);
+
+        if (cb != NULL)
+        {
+            if (!(key = js_entry_cstr_(ent, kbuf, sizeof(kbuf))))
+            {
+                return -1;
+            }
+
+            skip = ((cb)(key, j1_val) == 1);
+
+            if (key != ent->key && key != kbuf)
+            {
+                free(key);
+            }
+
+            if (skip == true)
+            {
+                /* the key filter callback returned 1, which means we can ignore the
+                 * comparison of this field.
+                 */
+                continue;
+            }
+        }
+
+        if (same == true)
+        {
+            j2_val = JS_OBJECT_VALS(j2->object)[i];
+        } else if (!(j2_val = js_object_find_val_(j2, ent->key, ent->klen)))
+        {
+            return -1;
+        }
+
+        if (js_compare_(j1_val, j2_val, cb) == -1)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+} /* _lz_j_object_compare */
+
+static int
+js_string_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    const char * j1_str;
+    const char * j2_str;
+
+    if (!(j1_str = js_get_string_(j1)))
+    {
+        return -1;
+    }
+
+    if (!(j2_str = js_get_string_(j2)))
+    {
+        return -1;
+    }
+
+    if (j1->slen != j2->slen || memcmp(j1_str, j2_str, j1->slen))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+js_boolean_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    if (!j1 || !j2)
+    {
+        return -1;
+    }
+
+    if (j1->type != lz_json_vtype_bool)
+    {
+        return -1;
+    }
+
+    if (j2->type != lz_json_vtype_bool)
+    {
+        return -1;
+    }
+
+    if (js_get_boolean_(j1) != js_get_boolean_(j2))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+js_null_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    if (lz_unlikely(!j1 || !j2))
+    {
+        return -1;
+    }
+
+    if (j1->type != lz_json_vtype_null || j2->type != lz_json_vtype_null)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+js_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+{
+    ssize_t size;
+
+    if (lz_unlikely(j1 == NULL || j2 == NULL))
+    {
+        return -1;
+    }
+
+    if (j1->type != j2->type)
+    {
+        return -1;
+    }
+
+    /* -1 on both sides is two failures, not a match */
+    if ((size = js_get_size_(j1)) == -1 || size != js_get_size_(j2))
+    {
+        return -1;
+    }
+
+    switch (j1->type) {
+        case lz_json_vtype_number:
+            return js_number_compare_(j1, j2, cb);
+        case lz_json_vtype_array:
+            return js_array_compare_(j1, j2, cb);
+        case lz_json_vtype_object:
+            return js_object_compare_(j1, j2, cb);
+        case lz_json_vtype_string:
+            return js_string_compare_(j1, j2, cb);
+        case lz_json_vtype_bool:
+            return js_boolean_compare_(j1, j2, cb);
+        case lz_json_vtype_null:
+            return js_null_compare_(j2, j2, cb);
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
+/* two-stage parsing into a read-only lz_json_doc.
+ *
+ * stage 1 classifies the input 64 bytes at a time into bitmasks, masks out
+ * everything inside strings, and records the offset of every structural
+ * character ({}[]:,) and of the first byte of every scalar.
+ *
+ * stage 2 walks that index and fills a flat tape of tagged 64-bit words
+ * instead of allocating a node per value. The top byte of a word is its tag
+ * and the low 56 bits its payload:
+ *
+ *   '{' '['  low 32 bits: the tape index just past the matching close,
+ *            bits 32-55: the number of entries (saturated)
+ *   '}' ']'  the tape index of the matching open
+ *   '"'      offset of the string in the string buffer, which holds a 32-bit
+ *            length, the decoded bytes and a NUL
+ *   'i' 'u' 'd'
+ *            an int64_t, uint64_t or the bits of a double, the value is the
+ *            following word
+ *   't' 'f' 'n'
+ */
+#define JS_TAPE_WORD(tag, val) (((uint64_t)(tag) << 56) | (uint64_t)(val))
+#define JS_TAPE_TAG(w)         ((unsigned char)((w) >> 56))
+#define JS_TAPE_VAL(w)         ((w) & 0x00FFFFFFFFFFFFFFULL)
+#define JS_TAPE_COUNT_MAX      0xFFFFFFULL
+
+struct lz_json_doc_s {
+    uint64_t * tape;
+    size_t     tape_len;
+    char     * strings;
+    size_t     strings_len;
+    bool       image;   /* tape and strings are read in place from an image */
+    void     * map;     /* the image was mapped by js_doc_map_file_() */
+    size_t     map_len;
+};
+
+/* returns the bits of the characters which are escaped by a backslash,
+ * `prev` carries an escape over from the previous block.
+ */
+static uint64_t
+js_find_escaped_(uint64_t bslash, uint64_t * prev)
+{
+    const uint64_t even = 0x5555555555555555ULL;
+    uint64_t       follows;
+    uint64_t       odd_starts;
+    uint64_t       seq;
+
+    bslash    &= ~*prev;
+    follows    = (bslash << 1) | *prev;
+
+    /* runs of backslashes which start on an odd bit carry past their end
+     * when added, which flips the parity of the escaped character.
+     */
+    odd_starts = bslash & ~even & ~follows;
+    *prev      = __builtin_add_overflow(odd_starts, bslash, &seq) ? 1 : 0;
+
+    return (even ^ (seq << 1)) & follows;
+}
+
+static uint64_t
+js_prefix_xor_(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+
+/* stage 1: returns a malloc'd array of structural offsets */
+static uint32_t *
+js_doc_index_(const char * data, size_t len, size_t * n_idx)
+{
+    uint32_t      * idx;
+    size_t          n;
+    size_t          pos;
+    uint64_t        prev_escaped;
+    uint64_t        prev_in_string;
+    uint64_t        prev_scalar;
+    char            tail[64];
+    struct js_masks m;
+
+    if (len >= UINT32_MAX)
+    {
+        return NULL;
+    }
+
+    if (!(idx = malloc((len + 1) * sizeof(uint32_t))))
+    {
+        return NULL;
+    }
+
+    n              = 0;
+    prev_escaped   = 0;
+    prev_in_string = 0;
+    prev_scalar    = 0;
+
+    for (pos = 0; pos < len; pos += 64)
+    {
+        const char * block = data + pos;
+        uint64_t     quote;
+        uint64_t     in_string;
+        uint64_t     scalar;
+        uint64_t     structurals;
+
+        if (len - pos < 64)
+        {
+            /* pad the last block with whitespace, which is never indexed */
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, len - pos);
+            block = tail;
+        }
+
+        js_classify_(block, &m);
+
+        quote          = m.quote & ~js_find_escaped_(m.bslash, &prev_escaped);
+
+        /* set from an opening quote up to (not including) its closing one */
+        in_string      = js_prefix_xor_(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+        scalar         = ~(m.op | m.space | quote | in_string);
+        structurals    = (m.op & ~in_string) | (quote & in_string) |
+                         (scalar & ~((scalar << 1) | prev_scalar));
+        prev_scalar    = scalar >> 63;
+
+        while (structurals != 0)
+        {
+            idx[n++]     = (uint32_t)(pos + (size_t)__builtin_ctzll(structurals));
+            structurals &= structurals - 1;
+        }
+    }
+
+    *n_idx = n;
+
+    return idx;
+} /* js_doc_index_ */
+
+struct js_doc_frame {
+    size_t        open;
+    size_t        count;
+    lz_json_vtype type;
+    union {
+        lz_j_obj_state obj;
+        lz_j_arr_state arr;
+    } state;
+};
+
+/* stage 2 helper: writes the scalar at data[pos] to the tape, returns the
+ * offset just past it or -1 on error.
+ */
+static ssize_t
+js_doc_scalar_(lz_json_doc * doc, const char * data, size_t len, size_t pos)
+{
+    struct js_num num;
+    size_t        end;
+    size_t        slen;
+    uint32_t      len32;
+    ssize_t       dlen;
+    int           flags;
+
+    switch (data[pos]) {
+        case '"':
+            flags = 0;
+            end   = js_string_end_(&data[pos + 1], len - pos - 1, &flags);
+
+            if (end == len - pos - 1 || (flags & JS_STR_F_INVALID) ||
+                !js_utf8_valid_(&data[pos + 1], end))
+            {
+                return -1;
+            }
+
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD('"', doc->strings_len);
+
+            slen = doc->strings_len + sizeof(uint32_t);
+
+            if (flags & JS_STR_F_ESCAPED)
+            {
+                if ((dlen = js_unescape_(&doc->strings[slen], &data[pos + 1], end)) == -1)
+                {
+                    return -1;
+                }
+            } else {
+                memcpy(&doc->strings[slen], &data[pos + 1], end);
+                dlen = (ssize_t)end;
+            }
+
+            len32 = (uint32_t)dlen;
+            memcpy(&doc->strings[doc->strings_len], &len32, sizeof(len32));
+
+            doc->strings[slen + (size_t)dlen] = '\0';
+            doc->strings_len = slen + (size_t)dlen + 1;
+
+            return (ssize_t)(pos + end + 2);
+        case 't':
+            if (len - pos < 4 || memcmp(&data[pos], "true", 4))
+            {
+                return -1;
+            }
+
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD('t', 0);
+            return (ssize_t)(pos + 4);
+        case 'f':
+            if (len - pos < 5 || memcmp(&data[pos], "false", 5))
+            {
+                return -1;
+            }
+
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD('f', 0);
+            return (ssize_t)(pos + 5);
+        case 'n':
+            if (len - pos < 4 || memcmp(&data[pos], "null", 4))
+            {
+                return -1;
+            }
+
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD('n', 0);
+            return (ssize_t)(pos + 4);
+        default:
+            end = pos + js_number_end_(&data[pos], len - pos);
+
+            if (js_num_parse_(&data[pos], end - pos, &num) != (ssize_t)(end - pos))
+            {
+                return -1;
+            }
+
+            switch (num.type) {
+                case lz_json_ntype_int:
+                    doc->tape[doc->tape_len++] = JS_TAPE_WORD('i', 0);
+                    doc->tape[doc->tape_len++] = (uint64_t)num.i;
+                    break;
+                case lz_json_ntype_uint:
+                    doc->tape[doc->tape_len++] = JS_TAPE_WORD('u', 0);
+                    doc->tape[doc->tape_len++] = num.u;
+                    break;
+                default:
+                    doc->tape[doc->tape_len++] = JS_TAPE_WORD('d', 0);
+                    doc->tape[doc->tape_len++] = js_double_to_bits_(num.d);
+                    break;
+            }
+
+            return (ssize_t)end;
+    } /* switch */
+}     /* js_doc_scalar_ */
+
+static void
+js_doc_free_(lz_json_doc * doc)
+{
+    if (doc == NULL)
+    {
+        return;
+    }
+
+    if (doc->map != NULL)
+    {
+        munmap(doc->map, doc->map_len);
+    }
+
+    if (doc->image == false)
+    {
+        lz_safe_free(doc->tape, free);
+        lz_safe_free(doc->strings, free);
+    }
+
+    free(doc);
+}
+
+static lz_json_doc *
+js_doc_parse_buf_(const char * data, size_t len, size_t * n_read)
+{
+    lz_json_doc         * doc;
+    uint32_t            * idx;
+    size_t                n_idx;
+    size_t                k;
+    size_t                pos;
+    size_t                next;
+    ssize_t               end;
+    unsigned char         ch;
+    struct js_doc_frame * stack;
+    struct js_doc_frame * frame;
+    size_t                depth;
+    size_t                stack_len;
+    bool                  done;
+
+    if (lz_unlikely(data == NULL || len == 0))
+    {
+        return NULL;
+    }
+
+    if (!(idx = js_doc_index_(data, len, &n_idx)))
+    {
+        return NULL;
+    }
+
+    stack     = NULL;
+    depth     = 0;
+    stack_len = 0;
+    done      = false;
+    pos       = 0;
+
+    if (!(doc = calloc(1, sizeof(*doc))))
+    {
+        free(idx);
+        return NULL;
+    }
+
+    /* every index entry makes at most two words (numbers), and no string can
+     * take more than its raw length plus the length prefix and NUL.
+     */
+    doc->tape    = malloc((2 * n_idx + 1) * sizeof(uint64_t));
+    doc->strings = malloc(len + 5 * n_idx + 1);
+
+    if (doc->tape == NULL || doc->strings == NULL)
+    {
+        goto error;
+    }
+
+    for (k = 0; k < n_idx && done == false; k++)
+    {
+        pos   = idx[k];
+        ch    = data[pos];
+        frame = depth ? &stack[depth - 1] : NULL;
+
+        if (frame != NULL)
+        {
+            if (frame->type == lz_json_vtype_object)
+            {
+                switch (frame->state.obj) {
+                    case lz_j_obj_s_key:
+                        if (ch == '}')
+                        {
+                            goto close;
+                        }
+
+                        if (ch != '"' || (end = js_doc_scalar_(doc, data, len, pos)) == -1)
+                        {
+                            goto error;
+                        }
+
+                        frame->state.obj = lz_j_obj_s_delim;
+                        goto check_scalar;
+                    case lz_j_obj_s_delim:
+                        if (ch != ':')
+                        {
+                            goto error;
+                        }
+
+                        frame->state.obj = lz_j_obj_s_val;
+                        continue;
+                    case lz_j_obj_s_comma:
+                        if (ch == ',')
+                        {
+                            frame->state.obj = lz_j_obj_s_key;
+                            continue;
+                        }
+
+                        if (ch == '}')
+                        {
+                            goto close;
+                        }
+
+                        goto error;
+                    default:
+                        frame->state.obj = lz_j_obj_s_comma;
+                        break;
+                } /* switch */
+            } else {
+                switch (frame->state.arr) {
+                    case lz_j_arr_s_comma:
+                        if (ch == ',')
+                        {
+                            frame->state.arr = lz_j_arr_s_val;
+                            continue;
+                        }
+
+                        if (ch == ']')
+                        {
+                            goto close;
+                        }
+
+                        goto error;
+                    default:
+                        if (ch == ']')
+                        {
+                            goto close;
+                        }
+
+                        frame->state.arr = lz_j_arr_s_comma;
+                        break;
+                }
+            }
+
+            frame->count += 1;
+        } else if (ch != '{' && ch != '[')
+        {
+            goto error;
+        }
+
+        /* a value starts here */
+        if (ch == '{' || ch == '[')
+        {
+            if (depth == stack_len)
+            {
+                size_t                nlen   = stack_len ? stack_len * 2 : 32;
+                struct js_doc_frame * nstack = realloc(stack, nlen * sizeof(*nstack));
+
+                if (nstack == NULL)
+                {
+                    goto error;
+                }
+
+                stack     = nstack;
+                stack_len = nlen;
+            }
+
+            frame        = &stack[depth++];
+            frame->open  = doc->tape_len;
+            frame->count = 0;
+
+            if (ch == '{')
+            {
+                frame->type      = lz_json_vtype_object;
+                frame->state.obj = lz_j_obj_s_key;
+            } else {
+                frame->type      = lz_json_vtype_array;
+                frame->state.arr = lz_j_arr_s_val;
+            }
+
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD(ch, 0);
+            continue;
+        }
+
+        if ((end = js_doc_scalar_(doc, data, len, pos)) == -1)
+        {
+            goto error;
+        }
+
+check_scalar:
+        /* only whitespace may sit between a scalar and the next structural */
+        next = (k + 1 < n_idx) ? idx[k + 1] : len;
+
+        if ((size_t)end > next ||
+            js_skip_space_(&data[end], next - (size_t)end) != next - (size_t)end)
+        {
+            goto error;
+        }
+
+        continue;
+close:
+        depth -= 1;
+
+        if ((ch == '}') != (frame->type == lz_json_vtype_object))
+        {
+            goto error;
+        }
+
+        doc->tape[frame->open] = JS_TAPE_WORD(frame->type == lz_json_vtype_object ? '{' : '[',
+                                              (doc->tape_len + 1) |
+                                              ((frame->count < JS_TAPE_COUNT_MAX ?
+                                                frame->count : JS_TAPE_COUNT_MAX) << 32));
+        doc->tape[doc->tape_len++] = JS_TAPE_WORD(ch, frame->open);
+
+        if (depth == 0)
+        {
+            done = true;
+        }
+    }
+
+    if (done == false)
+    {
+        goto error;
+    }
+
+    if (n_read != NULL)
+    {
+        /* trailing whitespace is consumed, as lz_json_parse_buf() does */
+        *n_read += pos + 1 + js_skip_space_(&data[pos + 1], len - pos - 1);
+    }
+
+    free(idx);
+    free(stack);
+
+    return doc;
+error:
+    if (n_read != NULL)
+    {
+        *n_read += pos;
+    }
+
+    free(idx);
+    free(stack);
+    js_doc_free_(doc);
+
+    return NULL;
+} /* js_doc_parse_buf_ */
+
+static inline bool
+js_doc_ref_ok_(lz_json_doc * doc, ssize_t ref)
+{
+    return doc != NULL && ref >= 0 && (size_t)ref < doc->tape_len;
+}
+
+/* the tape index of the value following the one at `ref` */
+static size_t
+js_doc_next_(lz_json_doc * doc, size_t ref)
+{
+    uint64_t w = doc->tape[ref];
+
+    switch (JS_TAPE_TAG(w)) {
         case '{':
-            return js_parse_object_(data, len, n_read);
         case '[':
-            return js_parse_array_(data, len, n_read);
+            return (size_t)(w & 0xFFFFFFFFULL);
+        case 'i':
+        case 'u':
+        case 'd':
+            return ref + 2;
+        default:
+            return ref + 1;
+    }
+}
+
+static ssize_t
+js_doc_root_(lz_json_doc * doc)
+{
+    if (lz_unlikely(doc == NULL || doc->tape_len == 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static lz_json_vtype
+js_doc_get_type_(lz_json_doc * doc, ssize_t ref)
+{
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return -1;
+    }
+
+    switch (JS_TAPE_TAG(doc->tape[ref])) {
+        case '{':
+            return lz_json_vtype_object;
+        case '[':
+            return lz_json_vtype_array;
+        case '"':
+            return lz_json_vtype_string;
+        case 'i':
+        case 'u':
+        case 'd':
+            return lz_json_vtype_number;
+        case 't':
+        case 'f':
+            return lz_json_vtype_bool;
+        case 'n':
+            return lz_json_vtype_null;
         default:
-            if (isdigit(data[0]))
+            return -1;
+    }
+}
+
+static ssize_t
+js_doc_get_size_(lz_json_doc * doc, ssize_t ref)
+{
+    uint64_t w;
+    uint32_t slen;
+    size_t   count;
+    size_t   i;
+    size_t   end;
+
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return -1;
+    }
+
+    w = doc->tape[ref];
+
+    switch (JS_TAPE_TAG(w)) {
+        case '"':
+            memcpy(&slen, &doc->strings[JS_TAPE_VAL(w)], sizeof(slen));
+            return (ssize_t)slen;
+        case '{':
+        case '[':
+            count = (size_t)((w >> 32) & JS_TAPE_COUNT_MAX);
+
+            if (count < JS_TAPE_COUNT_MAX)
             {
-                return js_parse_number_(data, len, n_read);
+                return (ssize_t)count;
+            }
+
+            /* too many to fit in the word, count them */
+            end = (size_t)(w & 0xFFFFFFFFULL) - 1;
+
+            for (i = (size_t)ref + 1, count = 0; i < end; count++)
+            {
+                if (JS_TAPE_TAG(w) == '{')
+                {
+                    i += 1;
+                }
+
+                i = js_doc_next_(doc, i);
+            }
+
+            return (ssize_t)count;
+        default:
+            return 0;
+    } /* switch */
+}
+
+static const char *
+js_doc_get_string_(lz_json_doc * doc, ssize_t ref)
+{
+    uint64_t w;
+
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return NULL;
+    }
+
+    w = doc->tape[ref];
+
+    if (JS_TAPE_TAG(w) != '"')
+    {
+        return NULL;
+    }
+
+    return &doc->strings[JS_TAPE_VAL(w) + sizeof(uint32_t)];
+}
+
+static int
+js_doc_get_num_(lz_json_doc * doc, ssize_t ref, struct js_num * num)
+{
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return -1;
+    }
+
+    switch (JS_TAPE_TAG(doc->tape[ref])) {
+        case 'i':
+            num->type = lz_json_ntype_int;
+            num->i    = (int64_t)doc->tape[ref + 1];
+            return 0;
+        case 'u':
+            num->type = lz_json_ntype_uint;
+            num->u    = doc->tape[ref + 1];
+            return 0;
+        case 'd':
+            num->type = lz_json_ntype_double;
+            num->d    = js_double_from_bits_(doc->tape[ref + 1]);
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+static lz_json_ntype
+js_doc_get_number_type_(lz_json_doc * doc, ssize_t ref)
+{
+    struct js_num num;
+
+    if (js_doc_get_num_(doc, ref, &num) == -1)
+    {
+        return -1;
+    }
+
+    return num.type;
+}
+
+static int64_t
+js_doc_get_int_(lz_json_doc * doc, ssize_t ref)
+{
+    struct js_num num;
+
+    if (js_doc_get_num_(doc, ref, &num) == -1)
+    {
+        return 0;
+    }
+
+    return js_num_int_(&num);
+}
+
+static uint64_t
+js_doc_get_uint_(lz_json_doc * doc, ssize_t ref)
+{
+    struct js_num num;
+
+    if (js_doc_get_num_(doc, ref, &num) == -1)
+    {
+        return 0;
+    }
+
+    return js_num_uint_(&num);
+}
+
+static double
+js_doc_get_double_(lz_json_doc * doc, ssize_t ref)
+{
+    struct js_num num;
+
+    if (js_doc_get_num_(doc, ref, &num) == -1)
+    {
+        return 0;
+    }
+
+    return js_num_double_(&num);
+}
+
+static unsigned int
+js_doc_get_number_(lz_json_doc * doc, ssize_t ref)
+{
+    return (unsigned int)js_doc_get_int_(doc, ref);
+}
+
+static bool
+js_doc_get_boolean_(lz_json_doc * doc, ssize_t ref)
+{
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return false;
+    }
+
+    return JS_TAPE_TAG(doc->tape[ref]) == 't';
+}
+
+static int
+js_doc_get_null_(lz_json_doc * doc, ssize_t ref)
+{
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return -1;
+    }
+
+    return (JS_TAPE_TAG(doc->tape[ref]) == 'n') ? 1 : -1;
+}
+
+static ssize_t
+js_doc_get_array_index_(lz_json_doc * doc, ssize_t ref, int index)
+{
+    size_t i;
+    size_t end;
+
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref) || index < 0))
+    {
+        return -1;
+    }
+
+    if (JS_TAPE_TAG(doc->tape[ref]) != '[')
+    {
+        return -1;
+    }
+
+    end = (size_t)(doc->tape[ref] & 0xFFFFFFFFULL) - 1;
+
+    for (i = (size_t)ref + 1; i < end; i = js_doc_next_(doc, i))
+    {
+        if (index-- == 0)
+        {
+            return (ssize_t)i;
+        }
+    }
+
+    return -1;
+}
+
+static ssize_t
+js_doc_find_(lz_json_doc * doc, ssize_t ref, const char * key, size_t klen)
+{
+    size_t i;
+    size_t end;
+
+    if (JS_TAPE_TAG(doc->tape[ref]) != '{')
+    {
+        return -1;
+    }
+
+    end = (size_t)(doc->tape[ref] & 0xFFFFFFFFULL) - 1;
+
+    for (i = (size_t)ref + 1; i < end; i = js_doc_next_(doc, i + 1))
+    {
+        if ((size_t)js_doc_get_size_(doc, (ssize_t)i) == klen &&
+            !memcmp(js_doc_get_string_(doc, (ssize_t)i), key, klen))
+        {
+            return (ssize_t)(i + 1);
+        }
+    }
+
+    return -1;
+}
+
+static ssize_t
+js_doc_get_path_(lz_json_doc * doc, ssize_t ref, const char * path)
+{
+    struct js_path_seg seg;
+    ssize_t            cur;
+
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref) || path == NULL))
+    {
+        return -1;
+    }
+
+    cur = ref;
+
+    while ((path = js_path_next_(path, &seg)) != NULL)
+    {
+        if (seg.key != NULL)
+        {
+            cur = js_doc_find_(doc, cur, seg.key, seg.klen);
+        } else {
+            cur = js_doc_get_array_index_(doc, cur, seg.index);
+        }
+
+        if (cur == -1)
+        {
+            return -1;
+        }
+    }
+
+    return (cur != ref) ? cur : -1;
+}
+
+static ssize_t
+js_doc_path_eval_(const lz_json_path * path, lz_json_doc * doc, ssize_t ref)
+{
+    const struct js_path_seg * seg;
+    ssize_t                    cur;
+    size_t                     n;
+
+    if (lz_unlikely(path == NULL || !js_doc_ref_ok_(doc, ref)))
+    {
+        return -1;
+    }
+
+    cur = ref;
+
+    for (n = 0; n < path->n_segs && cur != -1; n++)
+    {
+        seg = &path->segs[n];
+
+        if (seg->key != NULL)
+        {
+            cur = js_doc_find_(doc, cur, seg->key, seg->klen);
+        } else {
+            cur = js_doc_get_array_index_(doc, cur, seg->index);
+        }
+    }
+
+    return (cur != ref) ? cur : -1;
+}
+
+/* materializes the value at `ref` (and everything below it) as lz_json */
+static lz_json *
+js_doc_to_json_(lz_json_doc * doc, ssize_t ref)
+{
+    struct js_num num;
+    lz_json     * js;
+    lz_json     * val;
+    size_t        i;
+    size_t        end;
+
+    if (lz_unlikely(!js_doc_ref_ok_(doc, ref)))
+    {
+        return NULL;
+    }
+
+    switch (JS_TAPE_TAG(doc->tape[ref])) {
+        case '{':
+            if (!(js = js_object_new_()))
+            {
+                return NULL;
+            }
+
+            end = (size_t)(doc->tape[ref] & 0xFFFFFFFFULL) - 1;
+
+            for (i = (size_t)ref + 1; i < end; i = js_doc_next_(doc, i + 1))
+            {
+                if (!(val = js_doc_to_json_(doc, (ssize_t)(i + 1))))
+                {
+                    lz_safe_free(js, js_free_);
+                    return NULL;
+                }
+
+                if (js_object_add_klen_(js,
+                                        js_doc_get_string_(doc, (ssize_t)i),
+                                        (size_t)js_doc_get_size_(doc, (ssize_t)i), val) == -1)
+                {
+                    lz_safe_free(val, js_free_);
+                    lz_safe_free(js, js_free_);
+                    return NULL;
+                }
+            }
+
+            return js;
+        case '[':
+            if (!(js = js_array_new_()))
+            {
+                return NULL;
+            }
+
+            end = (size_t)(doc->tape[ref] & 0xFFFFFFFFULL) - 1;
+
+            for (i = (size_t)ref + 1; i < end; i = js_doc_next_(doc, i))
+            {
+                if (!(val = js_doc_to_json_(doc, (ssize_t)i)) || js_array_add_(js, val) == -1)
+                {
+                    lz_safe_free(val, js_free_);
+                    lz_safe_free(js, js_free_);
+                    return NULL;
+                }
             }
 
-            switch (*data) {
-                case 't':
-                case 'f':
-                    return js_parse_boolean_(data, len, n_read);
-                case 'n':
-                    return js_parse_null_(data, len, n_read);
+            return js;
+        case '"':
+            return js_string_new_len_(js_doc_get_string_(doc, ref),
+                                      (size_t)js_doc_get_size_(doc, ref));
+        case 'i':
+        case 'u':
+        case 'd':
+            if (js_doc_get_num_(doc, ref, &num) == -1)
+            {
+                return NULL;
             }
+
+            return js_num_new_(&num);
+        case 't':
+            return js_boolean_new_(true);
+        case 'f':
+            return js_boolean_new_(false);
+        case 'n':
+            return js_null_new_();
+        default:
+            return NULL;
     } /* switch */
+}     /* js_doc_to_json_ */
 
-    /* *n_read = 0; */
-    return NULL;
+static ssize_t
+js_doc_to_buffer_(lz_json_doc * doc, ssize_t ref, char * buf, size_t buf_len)
+{
+    lz_json * js;
+    ssize_t   res;
+
+    if (!(js = js_doc_to_json_(doc, ref)))
+    {
+        return -1;
+    }
+
+    res = js_to_buffer_(js, buf, buf_len);
+
+    lz_safe_free(js, js_free_);
+
+    return res;
 }
 
+/* the tape length and string buffer size js_doc_from_json_() needs for `js` */
 static int
-js_json_to_buffer_(lz_json * json, struct __jbuf * jbuf)
+js_doc_json_len_(lz_json * js, size_t * tape_len, size_t * strings_len)
 {
-    switch (json->type) {
+    struct js_object * obj;
+    size_t             i;
+
+    switch (js->type) {
+        case lz_json_vtype_string:
+            if (js->string == NULL || js->slen > UINT32_MAX)
+            {
+                return -1;
+            }
+
+            *tape_len    += 1;
+            *strings_len += sizeof(uint32_t) + js->slen + 1;
+            return 0;
         case lz_json_vtype_number:
-            return js_number_to_buffer_(json, jbuf);
+            *tape_len    += 2;
+            return 0;
+        case lz_json_vtype_bool:
+        case lz_json_vtype_null:
+            *tape_len    += 1;
+            return 0;
         case lz_json_vtype_array:
-            return js_array_to_buffer_(json, jbuf);
+            if (js_lazy_(js) == -1)
+            {
+                return -1;
+            }
+
+            *tape_len += 2;
+
+            for (i = 0; i < js->array->len; i++)
+            {
+                if (js_doc_json_len_(js->array->items[i], tape_len, strings_len) == -1)
+                {
+                    return -1;
+                }
+            }
+
+            return 0;
         case lz_json_vtype_object:
-            return js_object_to_buffer_(json, jbuf);
+            if (js_lazy_(js) == -1)
+            {
+                return -1;
+            }
+
+            obj        = js->object;
+            *tape_len += 2 + obj->len;
+
+            for (i = 0; i < obj->len; i++)
+            {
+                *strings_len += sizeof(uint32_t) + JS_OBJECT_KEYS(obj)[i].klen + 1;
+
+                if (js_doc_json_len_(js_object_val_(obj, (uint32_t)i), tape_len, strings_len) == -1)
+                {
+                    return -1;
+                }
+            }
+
+            return 0;
+        default:
+            return -1;
+    } /* switch */
+}     /* js_doc_json_len_ */
+
+static void
+js_doc_put_string_(lz_json_doc * doc, const char * str, size_t len)
+{
+    uint32_t len32 = (uint32_t)len;
+
+    doc->tape[doc->tape_len++] = JS_TAPE_WORD('"', doc->strings_len);
+
+    memcpy(&doc->strings[doc->strings_len], &len32, sizeof(len32));
+    memcpy(&doc->strings[doc->strings_len + sizeof(len32)], str, len);
+
+    doc->strings[doc->strings_len + sizeof(len32) + len] = '\0';
+    doc->strings_len += sizeof(len32) + len + 1;
+}
+
+/* writes `js` to a tape sized by js_doc_json_len_(), lazy nodes have been
+ * expanded by then so nothing here can fail.
+ */
+static void
+js_doc_json_put_(lz_json_doc * doc, lz_json * js)
+{
+    struct js_object * obj;
+    struct js_entry  * ent;
+    struct js_num      num;
+    size_t             open;
+    size_t             count;
+    size_t             i;
+
+    switch (js->type) {
         case lz_json_vtype_string:
-            return js_string_to_buffer_(json, jbuf);
+            js_doc_put_string_(doc, js->string, js->slen);
+            return;
+        case lz_json_vtype_number:
+            js_get_num_(js, &num);
+
+            switch (num.type) {
+                case lz_json_ntype_int:
+                    doc->tape[doc->tape_len++] = JS_TAPE_WORD('i', 0);
+                    doc->tape[doc->tape_len++] = (uint64_t)num.i;
+                    break;
+                case lz_json_ntype_uint:
+                    doc->tape[doc->tape_len++] = JS_TAPE_WORD('u', 0);
+                    doc->tape[doc->tape_len++] = num.u;
+                    break;
+                default:
+                    doc->tape[doc->tape_len++] = JS_TAPE_WORD('d', 0);
+                    doc->tape[doc->tape_len++] = js_double_to_bits_(num.d);
+                    break;
+            }
+
+            return;
         case lz_json_vtype_bool:
-            return js_boolean_to_buffer_(json, jbuf);
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD(js->boolean ? 't' : 'f', 0);
+            return;
         case lz_json_vtype_null:
-            return js_null_to_buffer_(json, jbuf);
+            doc->tape[doc->tape_len++] = JS_TAPE_WORD('n', 0);
+            return;
+        case lz_json_vtype_array:
+            open  = doc->tape_len++;
+            count = js->array->len;
+
+            for (i = 0; i < count; i++)
+            {
+                js_doc_json_put_(doc, js->array->items[i]);
+            }
+
+            break;
         default:
-            return -1;
+            obj   = js->object;
+            open  = doc->tape_len++;
+            count = obj->len;
+
+            for (i = 0; i < count; i++)
+            {
+                ent = &JS_OBJECT_KEYS(obj)[i];
+
+                js_doc_put_string_(doc, ent->key, ent->klen);
+                js_doc_json_put_(doc, js_object_val_(obj, (uint32_t)i));
+            }
+
+            break;
+    } /* switch */
+
+    doc->tape[open] = JS_TAPE_WORD(js->type == lz_json_vtype_object ? '{' : '[',
+                                   (doc->tape_len + 1) |
+                                   ((count < JS_TAPE_COUNT_MAX ?
+                                     count : JS_TAPE_COUNT_MAX) << 32));
+    doc->tape[doc->tape_len++] = JS_TAPE_WORD(js->type == lz_json_vtype_object ? '}' : ']', open);
+} /* js_doc_json_put_ */
+
+static lz_json_doc *
+js_doc_from_json_(lz_json * json)
+{
+    lz_json_doc * doc;
+    size_t        tape_len    = 0;
+    size_t        strings_len = 0;
+
+    if (lz_unlikely(json == NULL))
+    {
+        return NULL;
     }
 
-    return 0;
+    /* container offsets on the tape are 32 bits wide */
+    if (js_doc_json_len_(json, &tape_len, &strings_len) == -1 || tape_len >= UINT32_MAX)
+    {
+        return NULL;
+    }
+
+    if (!(doc = calloc(1, sizeof(*doc))))
+    {
+        return NULL;
+    }
+
+    doc->tape    = malloc(tape_len * sizeof(uint64_t));
+    doc->strings = malloc(strings_len + 1);
+
+    if (doc->tape == NULL || doc->strings == NULL)
+    {
+        js_doc_free_(doc);
+        return NULL;
+    }
+
+    js_doc_json_put_(doc, json);
+
+    return doc;
+}
+
+/* images: a document written out as a header followed by its tape and its
+ * string buffer, byte for byte. Neither holds a pointer, so an image can be
+ * mapped at any address and read in place by the same accessors, without
+ * parsing or allocating. Words are in host byte order, which the header
+ * records, along with the sizes of both parts.
+ */
+#define JS_DOC_IMAGE_MAGIC   "lzjsdoc"
+#define JS_DOC_IMAGE_VERSION 1
+#define JS_DOC_IMAGE_ORDER   0x01020304U
+
+struct js_doc_image {
+    char     magic[8];
+    uint32_t version;
+    uint32_t order;
+    uint64_t tape_len;
+    uint64_t strings_len;
+};
+
+static size_t
+js_doc_image_len_(lz_json_doc * doc)
+{
+    if (lz_unlikely(doc == NULL))
+    {
+        return 0;
+    }
+
+    return sizeof(struct js_doc_image) + doc->tape_len * sizeof(uint64_t) + doc->strings_len;
+}
+
+static void
+js_doc_image_head_(lz_json_doc * doc, struct js_doc_image * head)
+{
+    memset(head, 0, sizeof(*head));
+    memcpy(head->magic, JS_DOC_IMAGE_MAGIC, sizeof(JS_DOC_IMAGE_MAGIC));
+
+    head->version     = JS_DOC_IMAGE_VERSION;
+    head->order       = JS_DOC_IMAGE_ORDER;
+    head->tape_len    = doc->tape_len;
+    head->strings_len = doc->strings_len;
 }
 
 static ssize_t
-js_to_buffer_(lz_json * json, char * buf, size_t buf_len)
+js_doc_to_image_(lz_json_doc * doc, char * buf, size_t buf_len)
 {
-    struct __jbuf jbuf = {
-        .buf     = buf,
-        .buf_idx = 0,
-        .written = 0,
-        .buf_len = buf_len,
-        .dynamic = 0,
-        .escape  = true
-    };
+    struct js_doc_image head;
+    size_t              len;
 
-    if (js_json_to_buffer_(json, &jbuf) == -1)
+    if (lz_unlikely(doc == NULL || buf == NULL))
+    {
+        return -1;
+    }
+
+    if ((len = js_doc_image_len_(doc)) > buf_len)
+    {
+        return -1;
+    }
+
+    js_doc_image_head_(doc, &head);
+
+    memcpy(buf, &head, sizeof(head));
+    memcpy(buf + sizeof(head), doc->tape, doc->tape_len * sizeof(uint64_t));
+    memcpy(buf + sizeof(head) + doc->tape_len * sizeof(uint64_t), doc->strings, doc->strings_len);
+
+    return (ssize_t)len;
+}
+
+/* the image is written next to `filename` and renamed over it, processes
+ * which still have the old one mapped keep reading the old one.
+ */
+static int
+js_doc_to_image_file_(lz_json_doc * doc, const char * filename)
+{
+    struct js_doc_image head;
+    char              * tmp;
+    size_t              tmp_len;
+    int                 fd;
+
+    if (lz_unlikely(doc == NULL || filename == NULL))
+    {
+        return -1;
+    }
+
+    tmp_len = strlen(filename) + 32;
+
+    if (!(tmp = malloc(tmp_len)))
+    {
+        return -1;
+    }
+
+    snprintf(tmp, tmp_len, "%s.%ld.tmp", filename, (long)getpid());
+
+    if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1)
+    {
+        free(tmp);
+        return -1;
+    }
+
+    js_doc_image_head_(doc, &head);
+
+    if (js_sink_fd_((const char *)&head, sizeof(head), &fd) == -1 ||
+        js_sink_fd_((const char *)doc->tape, doc->tape_len * sizeof(uint64_t), &fd) == -1 ||
+        js_sink_fd_(doc->strings, doc->strings_len, &fd) == -1)
+    {
+        goto error;
+    }
+
+    if (close(fd) == -1)
+    {
+        fd = -1;
+        goto error;
+    }
+
+    if (rename(tmp, filename) == -1)
+    {
+        fd = -1;
+        goto error;
+    }
+
+    free(tmp);
+
+    return 0;
+error:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    unlink(tmp);
+    free(tmp);
+
+    return -1;
+} /* js_doc_to_image_file_ */
+
+/* an image may come from anywhere, so before any accessor trusts the tape it
+ * is walked once: every container must be closed where its open word says,
+ * counts must match, object members must be keyed by strings, and strings
+ * and number payloads must lie within their buffers.
+ */
+static int
+js_doc_check_(lz_json_doc * doc)
+{
+    struct js_doc_frame * stack;
+    struct js_doc_frame * frame;
+    size_t                depth;
+    size_t                stack_len;
+    size_t                i;
+    uint64_t              w;
+    uint64_t              off;
+    uint32_t              slen;
+    unsigned char         tag;
+    int                   res;
+
+    if (doc->tape_len == 0 || doc->tape_len >= UINT32_MAX)
     {
         return -1;
     }
 
-    return jbuf.written;
-}
+    stack     = NULL;
+    depth     = 0;
+    stack_len = 0;
+    res       = -1;
+
+    for (i = 0; i < doc->tape_len; )
+    {
+        w     = doc->tape[i];
+        tag   = JS_TAPE_TAG(w);
+        frame = depth ? &stack[depth - 1] : NULL;
+
+        if (frame == NULL && i != 0)
+        {
+            /* something after the root */
+            goto done;
+        }
+
+        if (tag == '}' || tag == ']')
+        {
+            if (frame == NULL || JS_TAPE_VAL(w) != frame->open ||
+                tag != (frame->type == lz_json_vtype_object ? '}' : ']') ||
+                (frame->type == lz_json_vtype_object && frame->state.obj != lz_j_obj_s_key))
+            {
+                goto done;
+            }
+
+            w = doc->tape[frame->open];
+
+            if ((w & 0xFFFFFFFFULL) != i + 1 ||
+                ((w >> 32) & JS_TAPE_COUNT_MAX) !=
+                (frame->count < JS_TAPE_COUNT_MAX ? frame->count : JS_TAPE_COUNT_MAX))
+            {
+                goto done;
+            }
+
+            depth -= 1;
+            i     += 1;
+            continue;
+        }
+
+        if (frame != NULL)
+        {
+            if (frame->type != lz_json_vtype_object)
+            {
+                frame->count += 1;
+            } else if (frame->state.obj == lz_j_obj_s_key)
+            {
+                if (tag != '"')
+                {
+                    goto done;
+                }
+
+                frame->state.obj = lz_j_obj_s_val;
+            } else {
+                frame->state.obj = lz_j_obj_s_key;
+                frame->count    += 1;
+            }
+        }
+
+        switch (tag) {
+            case '{':
+            case '[':
+                if (depth == stack_len)
+                {
+                    size_t                nlen   = stack_len ? stack_len * 2 : 32;
+                    struct js_doc_frame * nstack = realloc(stack, nlen * sizeof(*nstack));
+
+                    if (nstack == NULL)
+                    {
+                        goto done;
+                    }
+
+                    stack     = nstack;
+                    stack_len = nlen;
+                }
+
+                frame        = &stack[depth++];
+                frame->open  = i;
+                frame->count = 0;
+
+                if (tag == '{')
+                {
+                    frame->type      = lz_json_vtype_object;
+                    frame->state.obj = lz_j_obj_s_key;
+                } else {
+                    frame->type      = lz_json_vtype_array;
+                    frame->state.arr = lz_j_arr_s_val;
+                }
+
+                i += 1;
+                break;
+            case '"':
+                off = JS_TAPE_VAL(w);
+
+                if (doc->strings_len < sizeof(slen) || off > doc->strings_len - sizeof(slen))
+                {
+                    goto done;
+                }
+
+                memcpy(&slen, &doc->strings[off], sizeof(slen));
+
+                if (slen >= doc->strings_len - off - sizeof(slen) ||
+                    doc->strings[off + sizeof(slen) + slen] != '\0')
+                {
+                    goto done;
+                }
+
+                i += 1;
+                break;
+            case 'i':
+            case 'u':
+            case 'd':
+                if (i + 1 >= doc->tape_len)
+                {
+                    goto done;
+                }
+
+                i += 2;
+                break;
+            case 't':
+            case 'f':
+            case 'n':
+                i += 1;
+                break;
+            default:
+                goto done;
+        } /* switch */
+    }
+
+    res = (depth == 0) ? 0 : -1;
+done:
+    free(stack);
 
-static char *
-js_to_buffer_alloc_(lz_json * json, size_t * len)
+    return res;
+} /* js_doc_check_ */
+
+static lz_json_doc *
+js_doc_from_image_(const void * data, size_t len)
 {
-    struct __jbuf jbuf = {
-        .buf     = NULL,
-        .buf_idx = 0,
-        .written = 0,
-        .buf_len = 0,
-        .dynamic = 1,
-        .escape  = true
-    };
+    struct js_doc_image head;
+    lz_json_doc       * doc;
+    const char        * base = data;
 
-    if (!json || !len)
+    if (lz_unlikely(data == NULL || len < sizeof(head)))
     {
         return NULL;
     }
 
-    if (js_json_to_buffer_(json, &jbuf) == -1)
+    /* the tape is read as words where it lies */
+    if ((uintptr_t)data % sizeof(uint64_t))
     {
-        lz_safe_free(jbuf.buf, free);
         return NULL;
     }
 
-    *len = jbuf.written;
+    memcpy(&head, data, sizeof(head));
 
-    return jbuf.buf;
-}
+    if (memcmp(head.magic, JS_DOC_IMAGE_MAGIC, sizeof(JS_DOC_IMAGE_MAGIC)) ||
+        head.version != JS_DOC_IMAGE_VERSION || head.order != JS_DOC_IMAGE_ORDER)
+    {
+        return NULL;
+    }
 
-static void
-js_print_(FILE * out, lz_json * json) {
-    size_t len;
-    char * buf;
+    len -= sizeof(head);
 
-    if ((buf = js_to_buffer_alloc_(json, &len)) == NULL) {
-        fprintf(out, "{\"error\":%d}\n", len);
-        return;
+    if (head.tape_len > len / sizeof(uint64_t) ||
+        head.strings_len != len - head.tape_len * sizeof(uint64_t))
+    {
+        return NULL;
+    }
+
+    if (!(doc = calloc(1, sizeof(*doc))))
+    {
+        return NULL;
     }
 
-    fprintf(out, "%s\n", buf);
+    doc->image       = true;
+    doc->tape        = (uint64_t *)(uintptr_t)(base + sizeof(head));
+    doc->tape_len    = (size_t)head.tape_len;
+    doc->strings     = (char *)(uintptr_t)(base + sizeof(head) + doc->tape_len * sizeof(uint64_t));
+    doc->strings_len = (size_t)head.strings_len;
+
+    if (js_doc_check_(doc) == -1)
+    {
+        free(doc);
+        return NULL;
+    }
 
-    free(buf);
+    return doc;
 }
 
-static int
-js_number_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+static lz_json_doc *
+js_doc_map_file_(const char * filename)
 {
-    if (j1 == NULL || j2 == NULL)
-    {
-        return -1;
-    }
+    struct stat   st;
+    lz_json_doc * doc;
+    void        * map;
+    size_t        len;
+    int           fd;
 
-    if (j1->type != lz_json_vtype_number)
+    if (lz_unlikely(filename == NULL))
     {
-        return -1;
+        return NULL;
     }
 
-    if (j2->type != lz_json_vtype_number)
+    if ((fd = open(filename, O_RDONLY | O_CLOEXEC)) == -1)
     {
-        return -1;
+        return NULL;
     }
 
-    if (js_get_number_(j1) != js_get_number_(j2))
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        (size_t)st.st_size < sizeof(struct js_doc_image))
     {
-        return -1;
+        close(fd);
+        return NULL;
     }
 
-    return 0;
-}
+    len = (size_t)st.st_size;
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
 
-static int
-js_array_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
-{
-    lz_tailq      * j1_array;
-    lz_tailq      * j2_array;
-    lz_tailq_elem * elem;
-    lz_tailq_elem * temp;
-    int             idx;
+    close(fd);
 
-    if (j1 == NULL || j2 == NULL)
+    if (map == MAP_FAILED)
     {
-        return -1;
+        return NULL;
     }
 
-    if (!(j1_array = js_get_array_(j1)))
+    if (!(doc = js_doc_from_image_(map, len)))
     {
-        return -1;
+        munmap(map, len);
+        return NULL;
     }
 
-    if (!(j2_array = js_get_array_(j2)))
-    {
-        return -1;
-    }
+    doc->map     = map;
+    doc->map_len = len;
+
+    return doc;
+} /* js_doc_map_file_ */
+
+/* lazy parsing: lz_json_parse_buf_flags() with LZ_JSON_PARSE_LAZY only finds
+ * where the document ends, then parses its top level. Nested objects and
+ * arrays are skipped over with the stage 1 classifier of the document parser
+ * and become lazy nodes holding their span; each is parsed, one level at a
+ * time again, when something first looks inside it.
+ *
+ * Unless the input is zero-copy, the document is copied into its arena once,
+ * and strings and keys are decoded in place in the copy and terminated where
+ * their closing quote was. Each byte of the copy belongs to exactly one level,
+ * so nothing is overwritten which another level has yet to read.
+ */
+
+/* returns the length of the object or array at data[0], or -1 if it does
+ * not end. Brackets are only counted, matching them up is left to the
+ * expansion of each level.
+ */
+static ssize_t
+js_lazy_skip_(const char * data, size_t len)
+{
+    const char    * block;
+    char            tail[64];
+    struct js_masks m;
+    uint64_t        prev_escaped;
+    uint64_t        prev_in_string;
+    uint64_t        quote;
+    uint64_t        in_string;
+    uint64_t        ops;
+    size_t          depth;
+    size_t          pos;
+    size_t          i;
 
-    idx = 0;
+    prev_escaped   = 0;
+    prev_in_string = 0;
+    depth          = 0;
 
-    for (elem = lz_tailq_first(j1_array); elem; elem = temp)
+    for (pos = 0; pos < len; pos += 64)
     {
-        lz_json * j1_val;
-        lz_json * j2_val;
+        block = data + pos;
+
+        if (len - pos < 64)
+        {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, len - pos);
+            block = tail;
+        }
+
+        js_classify_(block, &m);
 
-        j1_val = (lz_json *)lz_tailq_elem_data(elem);
-        j2_val = (lz_json *)lz_tailq_get_at_index(j2_array, idx);
+        quote          = m.quote & ~js_find_escaped_(m.bslash, &prev_escaped);
+        in_string      = js_prefix_xor_(quote) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
 
-        if (j1_val && !j2_val)
+        for (ops = m.op & ~in_string; ops != 0; ops &= ops - 1)
         {
-            return -1;
+            i = (size_t)__builtin_ctzll(ops);
+
+            switch (block[i]) {
+                case '{':
+                case '[':
+                    depth++;
+                    break;
+                case '}':
+                case ']':
+                    if (--depth == 0)
+                    {
+                        return (ssize_t)(pos + i + 1);
+                    }
+                    break;
+            }
         }
+    }
+
+    return -1;
+} /* js_lazy_skip_ */
+
+/* reads the string body starting at data[0], just past its opening quote.
+ * Sets `str` and `slen` to the decoded string and returns the offset just
+ * past the closing quote, or -1.
+ */
+static ssize_t
+js_lazy_string_(lz_json * js, char * data, size_t len, char ** str, size_t * slen)
+{
+    ssize_t n;
+    size_t  end;
+    int     flags;
 
-        if (j2_val && !j1_val)
+    flags = 0;
+    end   = js_string_end_(data, len, &flags);
+
+    if (end == len || (flags & JS_STR_F_INVALID) ||
+        !js_utf8_valid_(data, end))
+    {
+        return -1;
+    }
+
+    *str  = data;
+    *slen = end;
+
+    if (flags & JS_STR_F_ESCAPED)
+    {
+        /* the input cannot be written to, decode into the arena instead */
+        if ((js->flags & JS_F_LAZY_VIEW) && !(*str = js_arena_alloc_(js->arena, end + 1)))
         {
             return -1;
         }
 
-        if (js_compare_(j1_val, j2_val, cb) == -1)
+        if ((n = js_unescape_(*str, data, end)) == -1)
         {
             return -1;
         }
 
-        idx += 1;
+        *slen = (size_t)n;
+    }
 
-        temp = lz_tailq_next(elem);
+    if (*str != data || !(js->flags & JS_F_LAZY_VIEW))
+    {
+        (*str)[*slen] = '\0';
     }
 
-    return 0;
-} /* _lz_j_array_compare */
+    return (ssize_t)(end + 1);
+}
 
-static int
-js_object_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+/* parses the value at data[0], containers are left lazy */
+static ssize_t
+js_lazy_value_(lz_json * js, char * data, size_t len, lz_json ** val)
 {
-    lz_kvmap     * j1_map;
-    lz_kvmap     * j2_map;
-    lz_kvmap_ent * ent;
-    lz_kvmap_ent * temp;
+    struct js_num num;
+    char        * str;
+    size_t        slen;
+    ssize_t       n;
 
-    if (j1 == NULL || j2 == NULL)
-    {
-        return -1;
-    }
+    *val = NULL;
 
-    if (!(j1_map = js_get_object_(j1)))
-    {
-        return -1;
-    }
+    switch (*data) {
+        case '"':
+            if ((n = js_lazy_string_(js, data + 1, len - 1, &str, &slen)) == -1)
+            {
+                return -1;
+            }
+
+            *val = js_string_new_view_(str, slen);
+
+            return n + 1;
+        case '{':
+        case '[':
+            if ((n = js_lazy_skip_(data, len)) == -1)
+            {
+                return -1;
+            }
+
+            if ((*val = js_new_(*data == '{' ? lz_json_vtype_object : lz_json_vtype_array)))
+            {
+                (*val)->string = data;
+                (*val)->slen   = (size_t)n;
+                (*val)->flags |= JS_F_LAZY | (js->flags & JS_F_LAZY_VIEW);
+            }
+
+            return n;
+        case 't':
+            if (len < 4 || memcmp(data, "true", 4))
+            {
+                return -1;
+            }
+
+            *val = js_boolean_new_(true);
+
+            return 4;
+        case 'f':
+            if (len < 5 || memcmp(data, "false", 5))
+            {
+                return -1;
+            }
+
+            *val = js_boolean_new_(false);
+
+            return 5;
+        case 'n':
+            if (len < 4 || memcmp(data, "null", 4))
+            {
+                return -1;
+            }
+
+            *val = js_null_new_();
+
+            return 4;
+        default:
+            if ((n = js_num_parse_(data, len, &num)) == -1)
+            {
+                return -1;
+            }
 
-    if (!(j2_map = js_get_object_(j2)))
+            *val = js_num_new_(&num);
+
+            return n;
+    } /* switch */
+} /* js_lazy_value_ */
+
+/* fills the container `js` from the text of one level, data[0] being its
+ * opening and data[len - 1] its closing bracket.
+ */
+static int
+js_lazy_level_(lz_json * js, char * data, size_t len)
+{
+    lz_json * val;
+    char    * key;
+    size_t    klen;
+    size_t    pos;
+    ssize_t   n;
+    char      close;
+
+    close = (js->type == lz_json_vtype_object) ? '}' : ']';
+    key   = NULL;
+    klen  = 0;
+    pos   = 1;
+    pos  += js_skip_space_(data + pos, len - pos);
+
+    if (data[pos] == close)
     {
-        return -1;
+        return (pos == len - 1) ? 0 : -1;
     }
 
-    for (ent = lz_kvmap_first(j1_map); ent; ent = temp)
+    while (pos < len)
     {
-        const char * key;
-        lz_json    * j1_val;
-        lz_json    * j2_val;
+        if (js->type == lz_json_vtype_object)
+        {
+            if (data[pos] != '"' ||
+                (n = js_lazy_string_(js, data + pos + 1, len - pos - 1, &key, &klen)) == -1)
+            {
+                return -1;
+            }
+
+            pos += (size_t)n + 1;
+            pos += js_skip_space_(data + pos, len - pos);
+
+            if (pos == len || data[pos] != ':')
+            {
+                return -1;
+            }
+
+            pos += 1;
+            pos += js_skip_space_(data + pos, len - pos);
+        }
 
-        if (!(key = lz_kvmap_ent_key(ent)))
+        if (pos == len || (n = js_lazy_value_(js, data + pos, len - pos, &val)) == -1 || val == NULL)
         {
             return -1;
         }
 
-        if (!(j1_val = (lz_json *)lz_kvmap_ent_val(ent)))
+        if (js->type == lz_json_vtype_object)
         {
-            return -1;
+            n = (js_object_put_(js, key, klen, val, JS_KEY_BORROWED) == -1) ? -1 : n;
+        } else {
+            n = (js_array_add_(js, val) == -1) ? -1 : n;
         }
 
-        if (cb && (cb)(key, j1_val) == 1)
+        if (n == -1)
         {
-            /* the key filter callback returned 1, which means we can ignore the
-             * comparison of this field.
-             */
-            temp = lz_kvmap_next(ent);
-            continue;
+            return -1;
         }
 
-        if (!(j2_val = (lz_json *)lz_kvmap_find(j2_map, key)))
+        pos += (size_t)n;
+        pos += js_skip_space_(data + pos, len - pos);
+
+        if (pos == len)
         {
             return -1;
         }
 
-        if (js_compare_(j1_val, j2_val, cb) == -1)
+        if (data[pos] == close)
+        {
+            return (pos == len - 1) ? 0 : -1;
+        }
+
+        if (data[pos] != ',')
         {
             return -1;
         }
 
-        temp = lz_kvmap_next(ent);
+        pos += 1;
+        pos += js_skip_space_(data + pos, len - pos);
+
+        /* like the tree parser, a trailing comma is let through */
+        if (data[pos] == close)
+        {
+            return (pos == len - 1) ? 0 : -1;
+        }
     }
 
-    return 0;
-} /* _lz_j_object_compare */
+    return -1;
+} /* js_lazy_level_ */
 
+/* parses one level of a lazy container. A container which fails to parse
+ * stays lazy with an empty span, so every later look inside it fails too.
+ */
 static int
-js_string_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+js_lazy_expand_(lz_json * js)
 {
-    const char * j1_str;
-    const char * j2_str;
+    struct js_arena * prev;
+    char            * data;
+    size_t            len;
+    int               res;
 
-    if (!(j1_str = js_get_string_(j1)))
-    {
-        return -1;
-    }
+    data = js->string;
+    len  = js->slen;
 
-    if (!(j2_str = js_get_string_(j2)))
+    if (len < 2)
     {
         return -1;
     }
 
-    if (strcmp(j1_str, j2_str))
-    {
-        return -1;
-    }
+    js->flags &= ~JS_F_LAZY;
 
-    return 0;
-}
+    prev = js_arena_enter_(js->arena);
 
-static int
-js_boolean_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
-{
-    if (!j1 || !j2)
+    if (js->type == lz_json_vtype_object)
     {
-        return -1;
+        res = js_object_init_(js, 0);
+    } else {
+        res = js_array_init_(js, 0);
     }
 
-    if (j1->type != lz_json_vtype_bool)
+    if (res == 0)
     {
-        return -1;
+        res = js_lazy_level_(js, data, len);
     }
 
-    if (j2->type != lz_json_vtype_bool)
-    {
-        return -1;
-    }
+    js_arena_enter_(prev);
 
-    if (js_get_boolean_(j1) != js_get_boolean_(j2))
+    if (res == -1)
     {
-        return -1;
+        js->flags  |= JS_F_LAZY;
+        js->string  = NULL;
+        js->slen    = 0;
     }
 
-    return 0;
-}
+    return res;
+} /* js_lazy_expand_ */
 
-static int
-js_null_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
+static lz_json *
+js_parse_lazy_(const char * data, size_t len, int flags, size_t * consumed)
 {
-    if (lz_unlikely(!j1 || !j2))
+    struct js_arena * arena;
+    struct js_arena * prev;
+    lz_json         * js;
+    char            * span;
+    size_t            start;
+    ssize_t           n;
+
+    start     = js_skip_space_(data, len);
+    *consumed = start;
+
+    if (start == len || (data[start] != '{' && data[start] != '['))
     {
-        return -1;
+        return NULL;
     }
 
-    if (j1->type != lz_json_vtype_null || j2->type != lz_json_vtype_null)
+    if ((n = js_lazy_skip_(data + start, len - start)) == -1)
     {
-        return -1;
+        *consumed = len;
+        return NULL;
     }
 
-    return 0;
-}
-
-static int
-js_compare_(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb)
-{
-    if (lz_unlikely(j1 == NULL || j2 == NULL))
+    if (!(arena = js_arena_new_()))
     {
-        return -1;
+        return NULL;
     }
 
-    if (j1->type != j2->type)
+    if (flags & LZ_JSON_PARSE_ZEROCOPY)
     {
-        return -1;
+        span = (char *)data + start;
+    } else if ((span = js_arena_alloc_(arena, (size_t)n)))
+    {
+        memcpy(span, data + start, (size_t)n);
     }
 
-    if (js_get_size_(j1) != js_get_size_(j2))
+    prev = js_arena_enter_(arena);
+    js   = NULL;
+
+    if (span != NULL && (js = js_new_(*span == '{' ? lz_json_vtype_object : lz_json_vtype_array)))
     {
-        return -1;
+        js->string = span;
+        js->slen   = (size_t)n;
+        js->flags |= JS_F_LAZY;
+
+        if (flags & LZ_JSON_PARSE_ZEROCOPY)
+        {
+            js->flags |= JS_F_LAZY_VIEW;
+        }
     }
 
-    switch (j1->type) {
-        case lz_json_vtype_number:
-            return js_number_compare_(j1, j2, cb);
-        case lz_json_vtype_array:
-            return js_array_compare_(j1, j2, cb);
-        case lz_json_vtype_object:
-            return js_object_compare_(j1, j2, cb);
-        case lz_json_vtype_string:
-            return js_string_compare_(j1, j2, cb);
-        case lz_json_vtype_bool:
-            return js_boolean_compare_(j1, j2, cb);
-        case lz_json_vtype_null:
-            return js_null_compare_(j2, j2, cb);
-        default:
-            return -1;
+    js_arena_enter_(prev);
+
+    if (js == NULL || js_lazy_expand_(js) == -1)
+    {
+        js_arena_free_(arena);
+        return NULL;
     }
 
-    return 0;
-}
+    js->flags |= JS_F_ARENA_OWNER;
+    *consumed  = start + (size_t)n;
+
+    return js;
+} /* js_parse_lazy_ */
 
 int
 lz_json_init(void)
 {
-    if (lz_unlikely(__js_heap == NULL))
+    js_simd_init_();
+
+    /* the pool of any other thread is created when it first allocates */
+    if (lz_unlikely(js_pool_get_() == NULL))
     {
-        if (!(__js_heap = lz_heap_new(sizeof(lz_json), 1024)))
-        {
-            return -1;
-        }
+        return -1;
     }
+
     return 0;
 }
 
@@ -1866,11 +10621,21 @@ lz_alias(js_boolean_new_, lz_json_boolean_new);
 lz_alias(js_object_new_, lz_json_object_new);
 lz_alias(js_string_new_, lz_json_string_new);
 lz_alias(js_number_new_, lz_json_number_new);
+lz_alias(js_int_new_, lz_json_int_new);
+lz_alias(js_uint_new_, lz_json_uint_new);
+lz_alias(js_double_new_, lz_json_double_new);
+lz_alias(js_get_number_, lz_json_get_number);
+lz_alias(js_get_number_type_, lz_json_get_number_type);
+lz_alias(js_get_int_, lz_json_get_int);
+lz_alias(js_get_uint_, lz_json_get_uint);
+lz_alias(js_get_double_, lz_json_get_double);
 lz_alias(js_array_new_, lz_json_array_new);
 lz_alias(js_null_new_, lz_json_null_new);
 lz_alias(js_free_, lz_json_free);
 
 lz_alias(js_get_array_index_, lz_json_get_array_index);
+lz_alias(js_get_array_, lz_json_get_array);
+lz_alias(js_get_object_, lz_json_get_object);
 lz_alias(js_get_null_, lz_json_get_null);
 lz_alias(js_get_type_, lz_json_get_type);
 lz_alias(js_get_size_, lz_json_get_size);
@@ -1878,17 +10643,90 @@ lz_alias(js_get_path_, lz_json_get_path);
 
 lz_alias(js_parse_boolean_, lz_json_parse_boolean);
 lz_alias(js_parse_string_, lz_json_parse_string);
+lz_alias(js_parse_string_, lz_json_parse_key);
+lz_alias(js_parse_object_, lz_json_parse_object);
+lz_alias(js_parse_value_, lz_json_parse_value);
 lz_alias(js_parse_number_, lz_json_parse_number);
 lz_alias(js_parse_array_, lz_json_parse_array);
 lz_alias(js_parse_file_, lz_json_parse_file);
 lz_alias(js_parse_null_, lz_json_parse_null);
 lz_alias(js_parse_buf_, lz_json_parse_buf);
+lz_alias(js_parse_buf_flags_, lz_json_parse_buf_flags);
+lz_alias(js_parse_file_flags_, lz_json_parse_file_flags);
+lz_alias(js_ndjson_new_buf_, lz_json_ndjson_new_buf);
+lz_alias(js_ndjson_new_fd_, lz_json_ndjson_new_fd);
+lz_alias(js_ndjson_next_, lz_json_ndjson_next);
+lz_alias(js_ndjson_offset_, lz_json_ndjson_offset);
+lz_alias(js_ndjson_free_, lz_json_ndjson_free);
+lz_alias(js_ndjson_set_keys_, lz_json_ndjson_set_keys);
+lz_alias(js_ndjson_parallel_, lz_json_ndjson_parallel);
+
+lz_alias(js_parser_new_, lz_json_parser_new);
+lz_alias(js_parser_new_events_, lz_json_parser_new_events);
+lz_alias(js_parser_new_flags_, lz_json_parser_new_flags);
+lz_alias(js_parser_feed_, lz_json_parser_feed);
+lz_alias(js_parser_complete_, lz_json_parser_complete);
+lz_alias(js_parser_finish_, lz_json_parser_finish);
+lz_alias(js_parser_free_, lz_json_parser_free);
+lz_alias(js_parser_set_keys_, lz_json_parser_set_keys);
+lz_alias(js_keys_new_, lz_json_keys_new);
+lz_alias(js_keys_free_, lz_json_keys_free);
+lz_alias(js_parse_events_, lz_json_parse_events);
+
+lz_alias(js_arena_begin_, lz_json_arena_begin);
+lz_alias(js_arena_end_, lz_json_arena_end);
+
+lz_alias(js_doc_parse_buf_, lz_json_doc_parse_buf);
+lz_alias(js_doc_free_, lz_json_doc_free);
+lz_alias(js_doc_root_, lz_json_doc_root);
+lz_alias(js_doc_get_type_, lz_json_doc_get_type);
+lz_alias(js_doc_get_size_, lz_json_doc_get_size);
+lz_alias(js_doc_get_path_, lz_json_doc_get_path);
+lz_alias(js_doc_get_array_index_, lz_json_doc_get_array_index);
+lz_alias(js_doc_get_string_, lz_json_doc_get_string);
+lz_alias(js_doc_get_number_, lz_json_doc_get_number);
+lz_alias(js_doc_get_number_type_, lz_json_doc_get_number_type);
+lz_alias(js_doc_get_int_, lz_json_doc_get_int);
+lz_alias(js_doc_get_uint_, lz_json_doc_get_uint);
+lz_alias(js_doc_get_double_, lz_json_doc_get_double);
+lz_alias(js_doc_get_boolean_, lz_json_doc_get_boolean);
+lz_alias(js_doc_get_null_, lz_json_doc_get_null);
+lz_alias(js_doc_to_json_, lz_json_doc_to_json);
+lz_alias(js_doc_to_buffer_, lz_json_doc_to_buffer);
+lz_alias(js_doc_from_json_, lz_json_doc_from_json);
+lz_alias(js_doc_image_len_, lz_json_doc_image_len);
+lz_alias(js_doc_to_image_, lz_json_doc_to_image);
+lz_alias(js_doc_to_image_file_, lz_json_doc_to_image_file);
+lz_alias(js_doc_from_image_, lz_json_doc_from_image);
+lz_alias(js_doc_map_file_, lz_json_doc_map_file);
 
 lz_alias(js_object_add_klen_, lz_json_object_add_klen);
 lz_alias(js_object_add_, lz_json_object_add);
+lz_alias(js_object_get_key_, lz_json_object_get_key);
+lz_alias(js_object_get_val_, lz_json_object_get_val);
+lz_alias(js_object_find_val_, lz_json_object_find);
 lz_alias(js_array_add_, lz_json_array_add);
 lz_alias(js_add_, lz_json_add);
 lz_alias(js_to_buffer_alloc_, lz_json_to_buffer_alloc);
 lz_alias(js_to_buffer_, lz_json_to_buffer);
+lz_alias(js_serialized_size_, lz_json_serialized_size);
 lz_alias(js_compare_, lz_json_compare);
 lz_alias(js_print_, lz_json_print);
+lz_alias(js_path_compile_, lz_json_path_compile);
+lz_alias(js_path_eval_, lz_json_path_eval);
+lz_alias(js_path_free_, lz_json_path_free);
+lz_alias(js_to_columns_, lz_json_to_columns);
+lz_alias(js_columns_free_, lz_json_columns_free);
+lz_alias(js_doc_path_eval_, lz_json_doc_path_eval);
+lz_alias(js_to_cb_, lz_json_to_cb);
+lz_alias(js_to_fd_, lz_json_to_fd);
+lz_alias(js_to_file_, lz_json_to_file);
+lz_alias(js_to_msgpack_, lz_json_to_msgpack);
+lz_alias(js_to_msgpack_alloc_, lz_json_to_msgpack_alloc);
+lz_alias(js_to_msgpack_cb_, lz_json_to_msgpack_cb);
+lz_alias(js_from_msgpack_, lz_json_from_msgpack);
+lz_alias(js_to_iov_, lz_json_to_iov);
+lz_alias(js_iov_vec_, lz_json_iov_vec);
+lz_alias(js_iov_len_, lz_json_iov_len);
+lz_alias(js_iov_writev_, lz_json_iov_writev);
+lz_alias(js_iov_free_, lz_json_iov_free);
@@ -9,12 +9,72 @@ enum lz_json_vtype_e {
     lz_json_vtype_null
 };
 
+/* how a lz_json_vtype_number value is stored */
+enum lz_json_ntype_e {
+    lz_json_ntype_int = 0, /* integers which fit in an int64_t */
+    lz_json_ntype_uint,    /* integers above INT64_MAX which fit in a uint64_t */
+    lz_json_ntype_double   /* anything with a fraction or exponent, or too large */
+};
+
+/* the type of a column filled by lz_json_to_columns() */
+enum lz_json_ctype_e {
+    lz_json_ctype_int = 0, /* int64_t, from integers which fit */
+    lz_json_ctype_double,  /* double, from any number */
+    lz_json_ctype_string   /* offsets into one buffer of the strings */
+};
+
 struct lz_json_s;
+struct lz_json_parser_s;
+struct lz_json_events_s;
+struct lz_json_doc_s;
+struct lz_json_ndjson_s;
+struct lz_json_iov_s;
+struct lz_json_path_s;
+struct lz_json_keys_s;
+struct lz_json_column_s;
+struct iovec;
 
-typedef enum lz_json_vtype_e lz_json_vtype;
-typedef struct lz_json_s     lz_json;
+typedef enum lz_json_vtype_e    lz_json_vtype;
+typedef enum lz_json_ntype_e    lz_json_ntype;
+typedef enum lz_json_ctype_e    lz_json_ctype;
+typedef struct lz_json_s        lz_json;
+typedef struct lz_json_parser_s lz_json_parser;
+typedef struct lz_json_events_s lz_json_events;
+typedef struct lz_json_doc_s    lz_json_doc;
+typedef struct lz_json_ndjson_s lz_json_ndjson;
+typedef struct lz_json_iov_s    lz_json_iov;
+typedef struct lz_json_path_s   lz_json_path;
+typedef struct lz_json_keys_s   lz_json_keys;
+typedef struct lz_json_column_s lz_json_column;
 
 typedef int (* lz_json_key_filtercb)(const char * key, lz_json * val);
+typedef int (* lz_json_ndjson_cb)(lz_json * record, size_t offset, void * arg);
+typedef int (* lz_json_writecb)(const char * buf, size_t len, void * arg);
+
+/* parse flags */
+#define LZ_JSON_PARSE_ARENA    (1 << 0) /* allocate the whole document from one arena */
+#define LZ_JSON_PARSE_ZEROCOPY (1 << 1) /* point strings and keys into the input */
+#define LZ_JSON_PARSE_LAZY     (1 << 2) /* parse nested containers on first access */
+
+/**
+ * @brief callbacks for the event (SAX-style) parser. Each one returns 0 to
+ *        continue, 1 to stop parsing early, or -1 to abort with an error.
+ *        Any callback may be NULL.
+ *
+ *        Strings and keys are not NUL terminated and are only valid for the
+ *        duration of the callback. Numbers are passed as their raw text.
+ */
+struct lz_json_events_s {
+    int (* on_object_start)(void * arg);
+    int (* on_object_end)(void * arg);
+    int (* on_array_start)(void * arg);
+    int (* on_array_end)(void * arg);
+    int (* on_key)(void * arg, const char * key, size_t len);
+    int (* on_string)(void * arg, const char * str, size_t len);
+    int (* on_number)(void * arg, const char * num, size_t len);
+    int (* on_boolean)(void * arg, bool boolean);
+    int (* on_null)(void * arg);
+};
 
 
 /**
@@ -37,6 +97,9 @@ LZ_EXPORT lz_json * lz_json_array_new(void);
  * @brief frees data associated with a lz_json context. Objects and arrays
  *        will free all the resources contained within in a recursive manner.
  *
+ *        Contexts are allocated from a pool owned by the calling thread, but
+ *        may be freed from any thread.
+ *
  * @param js
  */
 LZ_EXPORT void lz_json_free(lz_json * js);
@@ -65,8 +128,7 @@ LZ_EXPORT lz_json * lz_json_string_new_len(const char * str, size_t len);
 
 
 /**
- * @brief creates a lz_json context for a number. Note: this only supports
- *        unsigned int right now (casted for signed).
+ * @brief creates a lz_json context for a number, same as lz_json_int_new()
  *
  * @param num
  *
@@ -75,6 +137,19 @@ LZ_EXPORT lz_json * lz_json_string_new_len(const char * str, size_t len);
 LZ_EXPORT lz_json * lz_json_number_new(unsigned int num);
 
 
+/**
+ * @brief creates a lz_json number from a signed, unsigned or floating point
+ *        value. Doubles which are not finite are written out as null.
+ *
+ * @param num
+ *
+ * @return lz_json context with vtype of 'lz_json_vtype_number'
+ */
+LZ_EXPORT lz_json * lz_json_int_new(int64_t num);
+LZ_EXPORT lz_json * lz_json_uint_new(uint64_t num);
+LZ_EXPORT lz_json * lz_json_double_new(double num);
+
+
 /**
  * @brief creates a lz_json context for a boolean value.
  *
@@ -106,8 +181,8 @@ LZ_EXPORT lz_json * lz_json_null_new(void);
 LZ_EXPORT lz_json * lz_json_parse_buf(const char * data, size_t len, size_t * n_read);
 
 /**
- * @brief wrapper around lz_json_parse_buf but opens, reads, parses, and closes
- *        a file with JSON data.
+ * @brief wrapper around lz_json_parse_buf but maps, parses, and closes a
+ *        file with JSON data.
  *
  * @param filename
  * @param n_read number of bytes parsed
@@ -116,6 +191,109 @@ LZ_EXPORT lz_json * lz_json_parse_buf(const char * data, size_t len, size_t * n_
  */
 LZ_EXPORT lz_json * lz_json_parse_file(const char * filename, size_t * n_read);
 
+
+/**
+ * @brief same as lz_json_parse_file, with LZ_JSON_PARSE_* flags. With
+ *        LZ_JSON_PARSE_ZEROCOPY the file stays mapped for as long as the
+ *        document exists, and strings point into the mapping; the file
+ *        must not be truncated or modified in the meantime.
+ *
+ * @param filename
+ * @param n_read number of bytes parsed
+ * @param flags
+ *
+ * @return see lz_json_parse_buf
+ */
+LZ_EXPORT lz_json * lz_json_parse_file_flags(const char * filename, size_t * n_read, int flags);
+
+
+/**
+ * @brief creates a reader for newline delimited JSON (JSON Lines) held in a
+ *        buffer, or read from a file descriptor. Each line is one object or
+ *        array; blank lines are skipped.
+ *
+ *        Records are built in storage owned by the reader and reused for the
+ *        next one, so a record is only valid until the next call to
+ *        lz_json_ndjson_next() and must not be freed. LZ_JSON_PARSE_ZEROCOPY
+ *        is the only flag which applies; the buffer (not the descriptor,
+ *        which the reader buffers itself) must then outlive the reader.
+ *
+ * @param data / fd
+ * @param len
+ * @param flags
+ *
+ * @return lz_json_ndjson context, NULL on error
+ */
+LZ_EXPORT lz_json_ndjson * lz_json_ndjson_new_buf(const char * data, size_t len, int flags);
+LZ_EXPORT lz_json_ndjson * lz_json_ndjson_new_fd(int fd, int flags);
+
+
+/**
+ * @brief reads the next record
+ *
+ * @param nd
+ * @param record set to the record, or NULL
+ *
+ * @return 1 if a record was read, 0 at the end of the input, -1 if the line
+ *         was not a valid record (it is skipped, and the next call
+ *         continues after it) or reading the descriptor failed (which ends
+ *         the stream).
+ */
+LZ_EXPORT int lz_json_ndjson_next(lz_json_ndjson * nd, lz_json ** record);
+
+
+/**
+ * @brief returns the byte offset in the input of the line the last call to
+ *        lz_json_ndjson_next() read, whether or not it was a valid record.
+ *
+ * @param nd
+ *
+ * @return offset
+ */
+LZ_EXPORT size_t lz_json_ndjson_offset(lz_json_ndjson * nd);
+
+
+/**
+ * @brief frees the reader, and the last record it returned. The descriptor
+ *        is not closed.
+ *
+ * @param nd
+ */
+LZ_EXPORT void lz_json_ndjson_free(lz_json_ndjson * nd);
+
+/**
+ * @brief interns the keys of the records read from now on in `keys`, see
+ *        lz_json_parser_set_keys()
+ *
+ * @param nd
+ * @param keys
+ *
+ * @return 0 on success, -1 on error
+ */
+LZ_EXPORT int lz_json_ndjson_set_keys(lz_json_ndjson * nd, lz_json_keys * keys);
+
+
+/**
+ * @brief parses newline delimited JSON on a pool of threads. The input is
+ *        split into chunks at line boundaries which are parsed in parallel,
+ *        and `cb` is called with every record in input order, on the
+ *        calling thread. A record is only valid during its callback and
+ *        must not be freed; `record` is NULL for a line which was not a
+ *        valid record, `offset` is where the line starts in `data`.
+ *
+ * @param data
+ * @param len
+ * @param flags LZ_JSON_PARSE_ZEROCOPY, or 0
+ * @param n_threads the number of workers, <= 0 for one per online CPU
+ * @param cb returns 0 to continue, anything else to stop
+ * @param arg
+ *
+ * @return 0 when all of the input was read, 1 if the callback stopped early,
+ *         -1 on error
+ */
+LZ_EXPORT int lz_json_ndjson_parallel(const char * data, size_t len, int flags, int n_threads,
+                                      lz_json_ndjson_cb cb, void * arg);
+
 /* these next set of parser functions are self explainatory, and will probably be
  * made private in the future.
  */
@@ -128,6 +306,163 @@ LZ_EXPORT lz_json * lz_json_parse_key(const char * data, size_t len, size_t * n_
 LZ_EXPORT lz_json * lz_json_parse_null(const char * data, size_t len, size_t * n_read);
 LZ_EXPORT lz_json * lz_json_parse_boolean(const char * data, size_t len, size_t * n_read);
 
+/**
+ * @brief same as lz_json_parse_buf, with LZ_JSON_PARSE_* flags.
+ *
+ *        With LZ_JSON_PARSE_ARENA every node and string of the document is
+ *        carved out of a single arena which the root owns, so building the
+ *        tree does few allocations and lz_json_free() on the root releases
+ *        all of it at once. Nodes of such a document are never freed on
+ *        their own and must not outlive the root.
+ *
+ *        LZ_JSON_PARSE_ZEROCOPY implies LZ_JSON_PARSE_ARENA. Strings and
+ *        keys without escapes are not copied, they point into `data`, which
+ *        must stay valid and unchanged for as long as the document is used.
+ *        These are not NUL terminated: use lz_json_get_size() for the length
+ *        of a string and the klen of lz_json_object_get_key() for a key.
+ *
+ *        LZ_JSON_PARSE_LAZY implies LZ_JSON_PARSE_ARENA. Only the top level
+ *        of the document is parsed up front; nested objects and arrays are
+ *        skipped over and each is parsed, again one level deep, the first
+ *        time it is looked inside. The input is copied once (unless
+ *        LZ_JSON_PARSE_ZEROCOPY is also given), and syntax errors within a
+ *        nested value are only found when it is first accessed, which then
+ *        fails as if the value were missing. Since reading a lazy document
+ *        can modify it, it must not be read from several threads at once.
+ *
+ * @param data
+ * @param len
+ * @param n_read
+ * @param flags
+ *
+ * @return lz_json context, NULL on error
+ */
+LZ_EXPORT lz_json * lz_json_parse_buf_flags(const char * data, size_t len, size_t * n_read, int flags);
+
+/**
+ * @brief creates an incremental (push) parser. Data can be fed to it in
+ *        arbitrary chunks as it arrives, and parsing resumes exactly where
+ *        the previous chunk ended, so nothing is ever re-parsed.
+ *
+ * @return lz_json_parser context, NULL on error
+ */
+LZ_EXPORT lz_json_parser * lz_json_parser_new(void);
+
+/**
+ * @brief same as lz_json_parser_new, with LZ_JSON_PARSE_* flags which apply
+ *        to every document the parser builds. With LZ_JSON_PARSE_ZEROCOPY,
+ *        every buffer fed to the parser must outlive the document; strings
+ *        which were split between two buffers are copied.
+ *
+ * @param flags
+ *
+ * @return lz_json_parser context, NULL on error
+ */
+LZ_EXPORT lz_json_parser * lz_json_parser_new_flags(int flags);
+
+/**
+ * @brief creates an incremental parser which builds no tree, but instead
+ *        calls the lz_json_events callbacks as the document is scanned.
+ *
+ * @param events
+ * @param arg passed to every callback
+ *
+ * @return lz_json_parser context, NULL on error
+ */
+LZ_EXPORT lz_json_parser * lz_json_parser_new_events(const lz_json_events * events, void * arg);
+
+/**
+ * @brief feeds the next chunk of a document to the parser.
+ *
+ * @param p
+ * @param data the chunk
+ * @param len the length of the chunk
+ *
+ * @return the number of bytes consumed, which is less than len if the
+ *         document was completed (or a callback stopped the parse) within
+ *         this chunk; -1 on a parse error
+ */
+LZ_EXPORT ssize_t lz_json_parser_feed(lz_json_parser * p, const char * data, size_t len);
+
+/**
+ * @brief checks whether the parser has seen the end of a document
+ *
+ * @param p
+ *
+ * @return true if a complete document was parsed, or an event callback
+ *         stopped the parse early
+ */
+LZ_EXPORT bool lz_json_parser_complete(lz_json_parser * p);
+
+/**
+ * @brief ends the current document and returns it, the parser is reset and
+ *        can be used for another document.
+ *
+ * @param p
+ * @param n_read the total number of bytes consumed is stored here
+ *
+ * @return lz_json context if a complete document was parsed, NULL if the
+ *         input was invalid or truncated. Parsers created with
+ *         lz_json_parser_new_events() always return NULL.
+ */
+LZ_EXPORT lz_json * lz_json_parser_finish(lz_json_parser * p, size_t * n_read);
+
+/**
+ * @brief frees the parser along with any partially parsed document
+ *
+ * @param p
+ */
+LZ_EXPORT void lz_json_parser_free(lz_json_parser * p);
+
+/**
+ * @brief creates a table of interned object keys. A parser given the table
+ *        with lz_json_parser_set_keys() stores each key once in the table
+ *        and has objects refer to it, instead of copying the key into every
+ *        object, which saves an allocation per key for documents which keep
+ *        repeating the same keys. Lookups of keys from the table compare by
+ *        pointer first and skip rehashing. Arena documents allocate keys
+ *        cheaply already, so for them it mostly saves memory.
+ *
+ *        The table only grows: once it holds `max_keys` keys, and for keys
+ *        longer than 256 bytes, keys are copied as usual. A table is not
+ *        safe to use from several parsers at once, and must outlive every
+ *        document built with it.
+ *
+ * @param max_keys the most keys to intern, 0 for the default of 65536
+ *
+ * @return the table, NULL on error
+ */
+LZ_EXPORT lz_json_keys * lz_json_keys_new(size_t max_keys);
+
+LZ_EXPORT void lz_json_keys_free(lz_json_keys * keys);
+
+/**
+ * @brief sets the key table used by the documents the parser builds from
+ *        now on, NULL to go back to copying keys.
+ *
+ * @param p a parser which builds a tree
+ * @param keys
+ *
+ * @return 0 on success, -1 for a parser created with lz_json_parser_new_events()
+ */
+LZ_EXPORT int lz_json_parser_set_keys(lz_json_parser * p, lz_json_keys * keys);
+
+/**
+ * @brief scans a buffer containing a single object or array with the event
+ *        callbacks, without allocating any lz_json contexts.
+ *
+ * @param data
+ * @param len
+ * @param events
+ * @param arg passed to every callback
+ * @param n_read the number of bytes scanned is added to this
+ *
+ * @return 0 if the whole document was scanned, 1 if a callback stopped the
+ *         scan early, -1 on error
+ */
+LZ_EXPORT int lz_json_parse_events(const char * data, size_t len,
+    const lz_json_events * events, void * arg, size_t * n_read);
+
 /**
  * @brief returns the underlying type of the lz_json context
  *
@@ -139,7 +474,17 @@ LZ_EXPORT lz_json_vtype lz_json_get_type(lz_json * js);
 
 
 /**
- * @brief returns the underlying lz_kvmap ADT for an object
+ * @brief returns an lz_kvmap view of the entries in an object. Objects keep
+ *        their own table, so the view is built the first time this is
+ *        called, and is kept up to date as keys are added after that. It
+ *        belongs to the object and must not be modified or freed.
+ *
+ *        Replacing the value of a key that is already there frees the view,
+ *        along with the value it replaces; call this again for a new one.
+ *
+ *        lz_json_object_find(), lz_json_object_get_key() and
+ *        lz_json_object_get_val() access the entries directly, and are the
+ *        cheaper way to search or walk an object.
  *
  * @param js
  *
@@ -149,7 +494,13 @@ LZ_EXPORT lz_json_vtype lz_json_get_type(lz_json * js);
 LZ_EXPORT lz_kvmap * lz_json_get_object(lz_json * js);
 
 /**
- * @brief returns the underlying lz_tailq ADT for an array
+ * @brief returns an lz_tailq view of the values in an array. Arrays are
+ *        stored as a vector, so the view is built the first time this is
+ *        called, and is kept up to date as values are added after that. It
+ *        belongs to the array and must not be modified or freed.
+ *
+ *        lz_json_get_size() and lz_json_get_array_index() access the
+ *        values directly, and are the cheaper way to walk an array.
  *
  * @param js
  *
@@ -171,7 +522,7 @@ LZ_EXPORT lz_json * lz_json_get_array_index(lz_json * js, int index);
 
 
 /**
- * @brief return the underlying number
+ * @brief return the underlying number, truncated to an unsigned int
  *
  * @param js
  *
@@ -181,7 +532,33 @@ LZ_EXPORT unsigned int lz_json_get_number(lz_json * js);
 
 
 /**
- * @brief fetches the underlying string of the lz_json context
+ * @brief returns how a number is stored
+ *
+ * @param js
+ *
+ * @return the lz_json_ntype, -1 if js is not a number
+ */
+LZ_EXPORT lz_json_ntype lz_json_get_number_type(lz_json * js);
+
+
+/**
+ * @brief return a number as an int64_t, uint64_t or double. A number stored
+ *        as another type is converted: doubles are truncated towards zero
+ *        and values out of range are clamped.
+ *
+ * @param js
+ *
+ * @return the value, 0 if js is not a number
+ */
+LZ_EXPORT int64_t lz_json_get_int(lz_json * js);
+LZ_EXPORT uint64_t lz_json_get_uint(lz_json * js);
+LZ_EXPORT double lz_json_get_double(lz_json * js);
+
+
+/**
+ * @brief fetches the underlying string of the lz_json context. Strings are
+ *        NUL terminated, except those of a document parsed with
+ *        LZ_JSON_PARSE_ZEROCOPY; lz_json_get_size() returns the length.
  *
  * @param js
  *
@@ -243,7 +620,80 @@ LZ_EXPORT lz_json * lz_json_get_path(lz_json * js, const char * path);
 
 
 /**
- * @brief add a string : lz_json context to an existing lz_json object
+ * @brief compiles a path in the syntax of lz_json_get_path() for repeated
+ *        use: the segments are split, keys hashed and indices converted once.
+ *        A compiled path is never modified, so one may be shared between
+ *        threads.
+ *
+ * @param path
+ *
+ * @return the compiled path, free with lz_json_path_free(), NULL on error or
+ *         if the path is malformed
+ */
+LZ_EXPORT lz_json_path * lz_json_path_compile(const char * path);
+
+
+/**
+ * @brief the same as lz_json_get_path() with a compiled path
+ *
+ * @param path
+ * @param js
+ *
+ * @return
+ */
+LZ_EXPORT lz_json * lz_json_path_eval(const lz_json_path * path, lz_json * js);
+
+LZ_EXPORT void lz_json_path_free(lz_json_path * path);
+
+
+/**
+ * @brief a column of lz_json_to_columns(). The caller sets `path` and
+ *        `type`, the rest is filled in.
+ *
+ *        Row i is null if the value at `path` in the i'th element is
+ *        missing, or is not of the column's type; its value is then 0, or
+ *        an empty string.
+ */
+struct lz_json_column_s {
+    const lz_json_path * path;     /* an empty path is the element itself */
+    lz_json_ctype        type;
+
+    size_t    len;                 /* the number of rows */
+    size_t    n_null;
+    uint8_t * valid;               /* bit (i % 8) of valid[i / 8] is set if row i is not null */
+    union {
+        int64_t * ints;
+        double  * doubles;
+        size_t  * offsets;         /* len + 1, row i is blob[offsets[i]] up to blob[offsets[i + 1]] */
+    };
+    char    * blob;                /* the strings, not NUL terminated */
+    size_t    blob_len;
+};
+
+/**
+ * @brief converts an array of records into columns in one pass over it,
+ *        with a row for each element. When a parsed array's records all
+ *        have the same keys, they are read without looking the keys up.
+ *
+ * @param array
+ * @param columns
+ * @param n_columns
+ *
+ * @return 0 on success, free the columns with lz_json_columns_free(), or -1
+ *         on error.
+ */
+LZ_EXPORT int lz_json_to_columns(lz_json * array, lz_json_column * columns, size_t n_columns);
+
+/**
+ * @brief frees the buffers of columns filled by lz_json_to_columns(), not
+ *        the columns themselves.
+ */
+LZ_EXPORT void lz_json_columns_free(lz_json_column * columns, size_t n_columns);
+
+
+/**
+ * @brief add a string : lz_json context to an existing lz_json object. If
+ *        the key already exists, its value is replaced and freed.
  *
  * @param obj
  * @param key
@@ -268,6 +718,43 @@ LZ_EXPORT int lz_json_object_add(lz_json * obj, const char * key, lz_json * val)
 LZ_EXPORT int lz_json_object_add_klen(lz_json * o, const char * k, size_t kl, lz_json * v);
 
 
+/**
+ * @brief looks up a key in an object
+ *
+ * @param obj
+ * @param key
+ * @param klen length of the key
+ *
+ * @return the value, or NULL if the key was not found or obj is not an object
+ */
+LZ_EXPORT lz_json * lz_json_object_find(lz_json * obj, const char * key, size_t klen);
+
+
+/**
+ * @brief returns the key of the entry at `index` in an object; entries are
+ *        kept in the order they were added.
+ *
+ * @param obj
+ * @param index between 0 and lz_json_get_size() - 1
+ * @param klen if not NULL, set to the length of the key
+ *
+ * @return the key (NUL terminated unless it was parsed with
+ *         LZ_JSON_PARSE_ZEROCOPY), or NULL if out of range
+ */
+LZ_EXPORT const char * lz_json_object_get_key(lz_json * obj, int index, size_t * klen);
+
+
+/**
+ * @brief returns the value of the entry at `index` in an object
+ *
+ * @param obj
+ * @param index between 0 and lz_json_get_size() - 1
+ *
+ * @return the value, or NULL if out of range
+ */
+LZ_EXPORT lz_json * lz_json_object_get_val(lz_json * obj, int index);
+
+
 /**
  * @brief add a lz_json context to a lz_json array context
  *
@@ -317,6 +804,17 @@ LZ_EXPORT ssize_t lz_json_to_buffer_nescp(lz_json * json, char * buf, size_t buf
 #endif
 
 
+/**
+ * @brief computes the exact number of bytes lz_json_to_buffer() would write
+ *        for this context, without writing anything. This can be used to
+ *        size the output buffer so that serializing takes one allocation.
+ *
+ * @param json
+ *
+ * @return the serialized length, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_serialized_size(lz_json * json);
+
 /**
  * @brief converts to a malloc'd JSON string
  *
@@ -328,6 +826,142 @@ LZ_EXPORT ssize_t lz_json_to_buffer_nescp(lz_json * json, char * buf, size_t buf
 LZ_EXPORT char * lz_json_to_buffer_alloc(lz_json * json, size_t * len);
 
 
+/**
+ * @brief streams the JSON string to a write callback. Output is gathered in
+ *        a fixed size buffer which is passed to `cb` whenever it fills, so
+ *        memory use does not depend on the size of the output.
+ *
+ * @param json
+ * @param cb must consume all `len` bytes, returning 0, or -1 on error
+ * @param arg
+ *
+ * @return the total number of bytes written, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_to_cb(lz_json * json, lz_json_writecb cb, void * arg);
+
+
+/**
+ * @brief streams the JSON string to a file descriptor, see lz_json_to_cb()
+ *
+ * @param json
+ * @param fd
+ *
+ * @return the total number of bytes written, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_to_fd(lz_json * json, int fd);
+
+
+/**
+ * @brief streams the JSON string to a stdio stream, see lz_json_to_cb()
+ *
+ * @param json
+ * @param fp
+ *
+ * @return the total number of bytes written, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_to_file(lz_json * json, FILE * fp);
+
+
+/**
+ * @brief serializes into a list of iovecs for writev(2) or sendmsg(2).
+ *        Long strings and keys which need no escaping are referenced in
+ *        the tree rather than copied, everything else is staged in a buffer
+ *        owned by the result. The tree must outlive the result and must not
+ *        be modified while it is in use.
+ *
+ * @param json
+ *
+ * @return the iovec list, free with lz_json_iov_free(), NULL on error
+ */
+LZ_EXPORT lz_json_iov * lz_json_to_iov(lz_json * json);
+
+
+/**
+ * @brief the iovecs making up the output, in order
+ *
+ * @param iov
+ * @param [OUT] n_vec the number of iovecs, which may be more than IOV_MAX
+ *
+ * @return
+ */
+LZ_EXPORT const struct iovec * lz_json_iov_vec(lz_json_iov * iov, size_t * n_vec);
+
+
+/**
+ * @brief the total length of the output
+ *
+ * @param iov
+ *
+ * @return
+ */
+LZ_EXPORT size_t lz_json_iov_len(lz_json_iov * iov);
+
+
+/**
+ * @brief writes all of the output to `fd`, in batches of IOV_MAX iovecs and
+ *        resuming after short writes
+ *
+ * @param iov
+ * @param fd
+ *
+ * @return the number of bytes written, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_iov_writev(lz_json_iov * iov, int fd);
+
+LZ_EXPORT void lz_json_iov_free(lz_json_iov * iov);
+
+
+/**
+ * @brief encodes the lz_json ctx as MessagePack, a binary form of the same
+ *        values which lz_json_from_msgpack() reads back without scanning
+ *        text or converting numbers. Integers are written in the smallest
+ *        form which holds them, doubles as doubles.
+ *
+ * @param json
+ * @param buf user supplied buffer
+ * @param buf_len the length of the buffer
+ *
+ * @return number of bytes copied into the buffer, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_to_msgpack(lz_json * json, char * buf, size_t buf_len);
+
+/**
+ * @brief encodes to a malloc'd MessagePack buffer, see lz_json_to_msgpack()
+ *
+ * @param json
+ * @param len set to the length of the buffer
+ *
+ * @return the buffer, NULL on error
+ */
+LZ_EXPORT char * lz_json_to_msgpack_alloc(lz_json * json, size_t * len);
+
+/**
+ * @brief streams the MessagePack encoding to a write callback, see
+ *        lz_json_to_cb()
+ *
+ * @return the total number of bytes written, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_to_msgpack_cb(lz_json * json, lz_json_writecb cb, void * arg);
+
+/**
+ * @brief decodes one MessagePack value. Any value may be at the top level.
+ *        Map keys must be strings; binary strings are read as strings, and
+ *        extension types are not supported.
+ *
+ *        LZ_JSON_PARSE_ARENA and LZ_JSON_PARSE_ZEROCOPY apply as they do
+ *        for lz_json_parse_buf_flags().
+ *
+ * @param data
+ * @param len
+ * @param n_read if not NULL, set to the number of bytes the value took, which
+ *        is where the next one starts
+ * @param flags
+ *
+ * @return lz_json context, NULL on error
+ */
+LZ_EXPORT lz_json * lz_json_from_msgpack(const char * data, size_t len, size_t * n_read, int flags);
+
+
 /**
  * @brief prints string version of json context
  *
@@ -342,6 +976,8 @@ LZ_EXPORT void lz_json_print(FILE * out, lz_json * json);
  *        argument is not NULL, and the type being compared currently is an array or object,
  *        each ts_json context is passed to the callback. If the callback returns -1, that
  *        value will not be compared to the other.
+ *        Keys are passed NUL terminated, in documents parsed with
+ *        LZ_JSON_PARSE_ZEROCOPY too.
  *
  * @param j1
  * @param j2
@@ -351,4 +987,177 @@ LZ_EXPORT void lz_json_print(FILE * out, lz_json * json);
  */
 LZ_EXPORT int lz_json_compare(lz_json * j1, lz_json * j2, lz_json_key_filtercb cb);
 
+/**
+ * @brief starts an arena session on the calling thread: until
+ *        lz_json_arena_end(), every lz_json context created on this thread
+ *        (by the lz_json_*_new functions or a parse) is carved out of a
+ *        single arena. Sessions do not nest.
+ *
+ * @return 0 on success, -1 on error or if a session is already active
+ */
+LZ_EXPORT int lz_json_arena_begin(void);
+
+/**
+ * @brief ends the arena session on the calling thread, handing the arena
+ *        over to `root`, so that lz_json_free(root) releases everything
+ *        which was allocated during the session at once. If root is NULL
+ *        (or was not created in the session), it is all freed right away.
+ *
+ * @param root
+ */
+LZ_EXPORT void lz_json_arena_end(lz_json * root);
+
+/**
+ * @brief parses a buffer containing an object or array into a read-only
+ *        lz_json_doc. The input is indexed in a vectorized first pass, and
+ *        the values are then written to a flat tape instead of allocating a
+ *        context per value, which makes this the fastest way to parse a
+ *        document which is only going to be read.
+ *
+ *        Values within the document are referred to by their offset in the
+ *        tape, which the lz_json_doc_* accessors take and return.
+ *
+ * @param data
+ * @param len
+ * @param n_read the number of bytes parsed is added to this
+ *
+ * @return lz_json_doc, NULL on error
+ */
+LZ_EXPORT lz_json_doc * lz_json_doc_parse_buf(const char * data, size_t len, size_t * n_read);
+
+/**
+ * @brief frees a document, along with every string returned from it
+ *
+ * @param doc
+ */
+LZ_EXPORT void lz_json_doc_free(lz_json_doc * doc);
+
+/**
+ * @brief returns a reference to the root object or array of a document
+ *
+ * @param doc
+ *
+ * @return reference, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_doc_root(lz_json_doc * doc);
+
+/**
+ * @brief the lz_json_doc equivalents of the lz_json_get_* functions, each
+ *        takes a reference returned by lz_json_doc_root() or another
+ *        accessor. Functions returning a reference return -1 if the value
+ *        does not exist.
+ *
+ *        lz_json_doc_get_path() uses the same path syntax as
+ *        lz_json_get_path(), strings are valid until the document is freed.
+ */
+LZ_EXPORT lz_json_vtype lz_json_doc_get_type(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT ssize_t lz_json_doc_get_size(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT ssize_t lz_json_doc_get_path(lz_json_doc * doc, ssize_t ref, const char * path);
+LZ_EXPORT ssize_t lz_json_doc_path_eval(const lz_json_path * path, lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT ssize_t lz_json_doc_get_array_index(lz_json_doc * doc, ssize_t ref, int index);
+LZ_EXPORT const char * lz_json_doc_get_string(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT unsigned int lz_json_doc_get_number(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT lz_json_ntype lz_json_doc_get_number_type(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT int64_t lz_json_doc_get_int(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT uint64_t lz_json_doc_get_uint(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT double lz_json_doc_get_double(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT bool lz_json_doc_get_boolean(lz_json_doc * doc, ssize_t ref);
+LZ_EXPORT int lz_json_doc_get_null(lz_json_doc * doc, ssize_t ref);
+
+/**
+ * @brief builds a mutable lz_json tree from a value within a document
+ *
+ * @param doc
+ * @param ref
+ *
+ * @return lz_json context, NULL on error
+ */
+LZ_EXPORT lz_json * lz_json_doc_to_json(lz_json_doc * doc, ssize_t ref);
+
+/**
+ * @brief same as lz_json_to_buffer, for a value within a document
+ *
+ * @param doc
+ * @param ref
+ * @param buf
+ * @param buf_len
+ *
+ * @return number of bytes copied into the buffer, -1 on error
+ */
+LZ_EXPORT ssize_t lz_json_doc_to_buffer(lz_json_doc * doc, ssize_t ref, char * buf, size_t buf_len);
+
+/**
+ * @brief builds a read-only lz_json_doc from an lz_json tree, e.g. to write
+ *        a document parsed with lz_json_parse_file() out as an image.
+ *
+ * @param json
+ *
+ * @return lz_json_doc, NULL on error
+ */
+LZ_EXPORT lz_json_doc * lz_json_doc_from_json(lz_json * json);
+
+/**
+ * @brief the size of the image lz_json_doc_to_image() writes for `doc`.
+ *
+ *        An image holds the tape and strings of a document as they are in
+ *        memory. Values refer to each other by offset, so an image can be
+ *        mapped at any address and queried in place through the
+ *        lz_json_doc_* accessors, with no parsing and no allocation. Images
+ *        are only read on hosts with the byte order they were written with.
+ *
+ * @param doc
+ *
+ * @return the number of bytes, 0 on error
+ */
+LZ_EXPORT size_t lz_json_doc_image_len(lz_json_doc * doc);
+
+/**
+ * @brief writes the image of a document to a buffer
+ *
+ * @param doc
+ * @param buf
+ * @param buf_len at least lz_json_doc_image_len(doc)
+ *
+ * @return number of bytes written, -1 on error or if buf is too small
+ */
+LZ_EXPORT ssize_t lz_json_doc_to_image(lz_json_doc * doc, char * buf, size_t buf_len);
+
+/**
+ * @brief writes the image of a document to a file. The image is written to
+ *        a temporary file in the same directory which is then renamed over
+ *        `filename`, so processes which have the previous image mapped are
+ *        not affected.
+ *
+ * @param doc
+ * @param filename
+ *
+ * @return 0 on success, -1 on error
+ */
+LZ_EXPORT int lz_json_doc_to_image_file(lz_json_doc * doc, const char * filename);
+
+/**
+ * @brief opens an image held in memory. Nothing is copied: `data` must be
+ *        8-byte aligned, and stay valid and unchanged until the document
+ *        is freed. The image is checked once for consistency, after which
+ *        accessors read it in place.
+ *
+ * @param data
+ * @param len the exact length of the image
+ *
+ * @return lz_json_doc, NULL if the image is malformed or not for this host
+ */
+LZ_EXPORT lz_json_doc * lz_json_doc_from_image(const void * data, size_t len);
+
+/**
+ * @brief maps an image file written by lz_json_doc_to_image_file() read-only
+ *        and opens it as with lz_json_doc_from_image(). The pages are
+ *        shared with every other process mapping the same file, and
+ *        lz_json_doc_free() unmaps it.
+ *
+ * @param filename
+ *
+ * @return lz_json_doc, NULL on error
+ */
+LZ_EXPORT lz_json_doc * lz_json_doc_map_file(const char * filename);
+
 LZ_EXPORT int lz_json_init(void) __attribute__((constructor(101)));
@@ -24,7 +24,7 @@ js_number_to_lua_(lz_json * json, lua_State * L)
         return -1;
     }
 
-    lua_pushnumber(L, lz_json_get_number(json));
+    lua_pushnumber(L, lz_json_get_double(json));
 
     return 0;
 }
@@ -32,36 +32,25 @@ js_number_to_lua_(lz_json * json, lua_State * L)
 static int
 js_array_to_lua_(lz_json * json, lua_State * L)
 {
-    int             index;
-    lz_tailq      * array;
-    lz_tailq_elem * elem;
-    lz_tailq_elem * temp;
+    ssize_t size;
+    int     index;
 
     lz_assert(L != NULL);
 
-    if (!(array = lz_json_get_array(json)))
+    if (lz_json_get_type(json) != lz_json_vtype_array)
     {
         return -1;
     }
 
-    index = 1;
+    size = lz_json_get_size(json);
 
-    lua_createtable(L, lz_tailq_size(array), 0);
+    lua_createtable(L, (int)size, 0);
 
-    for (elem = lz_tailq_first(array); elem; elem = temp)
+    for (index = 0; index < size; index++)
     {
-        lz_json * val;
-
-        val = (lz_json *)lz_tailq_elem_data(elem);
-
-        if (val)
-        {
-            lua_pushnumber(L, index++);
-            lz_json_to_lua(val, L);
-            lua_settable(L, -3);
-        }
-
-        temp = lz_tailq_next(elem);
+        lua_pushnumber(L, index + 1);
+        lz_json_to_lua(lz_json_get_array_index(json, index), L);
+        lua_settable(L, -3);
     }
 
     return 0;
@@ -70,36 +59,30 @@ js_array_to_lua_(lz_json * json, lua_State * L)
 static int
 js_object_to_lua_(lz_json * json, lua_State * L)
 {
-    lz_kvmap     * object;
-    lz_kvmap_ent * ent;
-    lz_kvmap_ent * temp;
+    ssize_t size;
+    int     index;
 
     lz_assert(L != NULL);
 
-    if (!(object = lz_json_get_object(json)))
+    if (lz_json_get_type(json) != lz_json_vtype_object)
     {
         return -1;
     }
 
-    lua_createtable(L, 0, lz_kvmap_get_size(object));
+    size = lz_json_get_size(json);
 
+    lua_createtable(L, 0, (int)size);
 
-    for (ent = lz_kvmap_first(object); ent; ent = temp)
+    for (index = 0; index < size; index++)
     {
         const char * key;
-        lz_json    * val;
+        size_t       klen;
 
-        key = lz_kvmap_ent_key(ent);
-        val = lz_kvmap_ent_val(ent);
+        key = lz_json_object_get_key(json, index, &klen);
 
-        if (val)
-        {
-            lua_pushlstring(L, key, lz_kvmap_ent_get_klen(ent));
-            lz_json_to_lua(val, L);
-            lua_settable(L, -3);
-        }
-
-        temp = lz_kvmap_next(ent);
+        lua_pushlstring(L, key, klen);
+        lz_json_to_lua(lz_json_object_get_val(json, index), L);
+        lua_settable(L, -3);
     }
 
     return 0;
@@ -122,6 +105,23 @@ js_string_to_lua_(lz_json * json, lua_State * L)
     return 0;
 }
 
+static lz_json *
+js_number_from_lua_(lua_State * L, int idx)
+{
+    lua_Number num;
+
+    num = lua_tonumber(L, idx);
+
+    /* keep integral values as integers */
+    if (num >= -9007199254740992.0 && num <= 9007199254740992.0 &&
+        num == (lua_Number)(int64_t)num)
+    {
+        return lz_json_int_new((int64_t)num);
+    }
+
+    return lz_json_double_new((double)num);
+}
+
 static lz_json *
 js_from_lua_idx_(lua_State * L, int idx)
 {
@@ -158,7 +158,7 @@ js_from_lua_idx_(lua_State * L, int idx)
 
         switch (val_type) {
             case LUA_TNUMBER:
-                ent = lz_json_number_new(lua_tointeger(L, -1));
+                ent = js_number_from_lua_(L, -1);
                 break;
             case LUA_TSTRING:
                 ent = lz_json_string_new(lua_tostring(L, -1));